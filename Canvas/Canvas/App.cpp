@@ -5,40 +5,22 @@ namespace canvas
 {
 	App* App::mInstance = nullptr;
 
-	bool App::mbLButtonDown = false;
-	D2D1_POINT_2F App::mStartPoint = { NONE_POINT, NONE_POINT };
-	D2D1_POINT_2F App::mEndPoint = { NONE_POINT, NONE_POINT };
-
-	Object* App::mDragSelectionArea = nullptr;
-	Object* App::mSelectedBoundary = nullptr;
-	Object* App::mSelectedResizingRect = nullptr;
-	Object* App::mResizingRects[RESIZING_RECTS_COUNT];
-	Object* App::mNewObjectArea = nullptr;
-
-	eMouseMode App::mCurrMode = eMouseMode::Select;
-	eResizingDirection App::mResizingDirection = eResizingDirection::None;
-
-	std::unordered_set<Object*> App::mObjects;
-	std::unordered_set<Object*> App::mSelectedObjects;
-	std::vector<ObjectInfo> App::mCopiedObjectInfo;
-
 	App::App()
 		: mHwnd(nullptr)
 		, mResolution{ 0, 0 }
 		, mD2DFactory(nullptr)
-		, mRenderTarget(nullptr)
-		, mObjectBrush(nullptr)
+		, mRenderBackend(&mD2DBackend)
+		, mScene(nullptr)
+		, mPanPoint{ 0, 0 }
+		, mbFramePending(false)
+		, mFrameStats()
 	{
-		mObjects.reserve(DEFAULT_OBJECT_CAPACITY);
-		mSelectedObjects.reserve(DEFAULT_OBJECT_CAPACITY);
-		mCopiedObjectInfo.reserve(DEFAULT_OBJECT_CAPACITY);
 	}
 
 	void App::discardDeviceResources()
 	{
+		mD2DBackend.Release();
 		SafeRelease(&mD2DFactory);
-		SafeRelease(&mRenderTarget);
-		SafeRelease(&mObjectBrush);
 	}
 
 	App* App::GetInstance()
@@ -55,22 +37,77 @@ namespace canvas
 	{
 		discardDeviceResources();
 
-		for (auto obj : mObjects)
+		if (mRecording.IsRecording() && !mRecording.Write(mRecordingPath.data()))
+		{
+			MessageBoxW(nullptr, L"Failed to write the input recording.", L"Canvas", MB_OK | MB_ICONERROR);
+		}
+
+		if (!mProfilePath.empty())
 		{
-			delete obj;
+			if (!Profiler::Dump(mProfilePath.data()))
+			{
+				MessageBoxW(nullptr, L"Failed to write the profile.", L"Canvas", MB_OK | MB_ICONERROR);
+			}
+
+			Profiler::Disable();
 		}
 
-		for (auto obj : mResizingRects)
+		if (!mTracePath.empty())
 		{
-			delete obj;
+			writeTrace();
+			Tracer::Disable();
 		}
 
-		delete mSelectedBoundary;
-		delete mDragSelectionArea;
-		delete mNewObjectArea;
+		delete mScene;
 		delete mInstance;
 	}
 
+	// Records every input from here on; the file is written on exit.
+	bool App::StartRecording(const wchar_t* path)
+	{
+		if (!toUtf8(path, mRecordingPath))
+		{
+			return false;
+		}
+
+		mRecording.Start(mResolution.x, mResolution.y, Clock::now());
+
+		return true;
+	}
+
+	// Profiles every frame from here on; the histograms are written on exit.
+	bool App::StartProfiling(const wchar_t* path)
+	{
+		if (!toUtf8(path, mProfilePath))
+		{
+			mProfilePath.clear();
+			return false;
+		}
+
+		Profiler::Enable();
+
+		return true;
+	}
+
+	// Traces every frame from here on. The trace is written on F4 and on exit.
+	bool App::StartTracing(const wchar_t* path)
+	{
+		if (!toUtf8(path, mTracePath))
+		{
+			mTracePath.clear();
+			return false;
+		}
+
+		Tracer::Enable();
+
+		return true;
+	}
+
+	const RenderStats& App::GetRenderStats() const
+	{
+		return mScene->GetRenderStats();
+	}
+
 	HRESULT App::Init(HWND hWnd, POINT resolution)
 	{
 		if (mD2DFactory != nullptr)
@@ -85,6 +122,10 @@ namespace canvas
 		AdjustWindowRect(&rt, WS_OVERLAPPEDWINDOW, true);
 		SetWindowPos(mHwnd, nullptr, 200, 200, rt.right - rt.left, rt.bottom - rt.top, 0);
 
+		mScene = new Scene(mResolution.x, mResolution.y);
+		mFrameStats.begin = Clock::now();
+		Tracer::SetThreadName("main");
+
 		HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &mD2DFactory);
 
 		if (SUCCEEDED(hr))
@@ -92,39 +133,16 @@ namespace canvas
 			hr = createDeviceResources();
 		}
 
-		mDragSelectionArea = new Object(D2D1::ColorF(0x000000, 0.3f), D2D1::ColorF(0x6495ED, 0.2f));
-		mSelectedBoundary = new Object(D2D1::ColorF(0x0000FF, 1.f), D2D1::ColorF(0xFFFFFF, 0.f));
-		mNewObjectArea = new Object(D2D1::ColorF(0x000000, 1.f), D2D1::ColorF(0xFFFFFF, 0.f));
-
-		for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
-		{
-			mResizingRects[i] = new Object(D2D1::ColorF(0x0000FF, 1.f), D2D1::ColorF(0xFFFFFF, 1.0f));
-		}
-
 		return hr;
 	}
 
 	HRESULT App::createDeviceResources()
 	{
-		HRESULT hr = S_OK;
+		HRESULT hr = mD2DBackend.Init(mD2DFactory, mHwnd);
 
-		if (mRenderTarget == nullptr)
+		if (SUCCEEDED(hr))
 		{
-			RECT rt;
-			GetClientRect(mHwnd, &rt);
-
-			D2D1_SIZE_U size = D2D1::SizeU(rt.right - rt.left, rt.bottom - rt.top);
-			
-			hr = mD2DFactory->CreateHwndRenderTarget(
-				D2D1::RenderTargetProperties(),
-				D2D1::HwndRenderTargetProperties(mHwnd, size),
-				&mRenderTarget
-			);
-
-			if (SUCCEEDED(hr))
-			{
-				mRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0x000000, 1.f), &mObjectBrush);
-			}
+			mScene->Invalidate({ 0.f, 0.f, static_cast<float>(mResolution.x), static_cast<float>(mResolution.y) });
 		}
 
 		return hr;
@@ -132,321 +150,281 @@ namespace canvas
 
 	HRESULT App::render()
 	{
-		mRenderTarget->BeginDraw();
-		{
-			mRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
-			mRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::White));
-
-			for (auto obj : mObjects)
-			{
-				mObjectBrush->SetColor(obj->mBackgroundColor);
-				mRenderTarget->FillRectangle(obj->mRect, mObjectBrush);
+		mScene->Render(*mRenderBackend);
 
-				mObjectBrush->SetColor(obj->mLineColor);
-				mRenderTarget->DrawRectangle(obj->mRect, mObjectBrush, obj->mStrokeWidth);
-			}
+		return mD2DBackend.GetLastResult();
+	}
 
-			mObjectBrush->SetColor(mDragSelectionArea->mBackgroundColor);
-			mRenderTarget->FillRectangle(mDragSelectionArea->mRect, mObjectBrush);
+	void App::runFrame()
+	{
+		TraceScope scope("frame");
+		const Clock::time_point BEGIN = Clock::now();
+		const Clock::time_point OLDEST_INPUT = mInput.GetOldestTime();
+		const bool bHasInput = !mInput.IsEmpty();
 
-			mObjectBrush->SetColor(mDragSelectionArea->mLineColor);
-			mRenderTarget->DrawRectangle(mDragSelectionArea->mRect, mObjectBrush, mDragSelectionArea->mStrokeWidth);
+		mRecording.Add(eInputType::Frame, 0, 0.f, 0.f, BEGIN);
+		applyInput();
+		render();
+		mKeys.EndFrame();
+		mbFramePending = false;
 
-			mObjectBrush->SetColor(mSelectedBoundary->mLineColor);
-			mRenderTarget->DrawRectangle(mSelectedBoundary->mRect, mObjectBrush, mSelectedBoundary->mStrokeWidth);
+		const Clock::time_point END = Clock::now();
+		const Clock::duration WORK = END - BEGIN - mD2DBackend.GetLastPresentTime();
 
-			if (mSelectedBoundary->mRect.left == NONE_POINT)
-			{
-				setResizingRectsNone();
-			}
-			else
-			{
-				setResizingRectsPoint();
+		++mFrameStats.framesCount;
+		mFrameStats.work += WORK;
+		mFrameStats.maxWork = (std::max)(mFrameStats.maxWork, WORK);
 
-				for (auto obj : mResizingRects)
-				{
-					mObjectBrush->SetColor(obj->mBackgroundColor);
-					mRenderTarget->FillRectangle(obj->mRect, mObjectBrush);
+		if (bHasInput)
+		{
+			const Clock::duration LATENCY = END - OLDEST_INPUT;
 
-					mObjectBrush->SetColor(obj->mLineColor);
-					mRenderTarget->DrawRectangle(obj->mRect, mObjectBrush, obj->mStrokeWidth);
-				}
-			}
+			++mFrameStats.inputFramesCount;
+			mFrameStats.latency += LATENCY;
+			mFrameStats.maxLatency = (std::max)(mFrameStats.maxLatency, LATENCY);
+		}
 
-			mObjectBrush->SetColor(mNewObjectArea->mLineColor);
-			mRenderTarget->DrawRectangle(mNewObjectArea->mRect, mObjectBrush, mNewObjectArea->mStrokeWidth);
+		if (END - mFrameStats.begin >= FRAME_STATS_INTERVAL)
+		{
+			reportFrameStats(END);
 		}
-		return mRenderTarget->EndDraw();
 	}
 
-	void App::addObject() 
+	void App::applyInput()
 	{
-		if (mStartPoint.x > mEndPoint.x)
+		if (mInput.IsEmpty())
 		{
-			const float temp = mStartPoint.x;
-			mStartPoint.x = mEndPoint.x;
-			mEndPoint.x = temp;
+			return;
 		}
 
-		if (mStartPoint.y > mEndPoint.y)
-		{
-			const float temp = mStartPoint.y;
-			mStartPoint.y = mEndPoint.y;
-			mEndPoint.y = temp;
-		}
+		mFrameStats.eventsReceived += static_cast<uint32_t>(mInput.GetReceivedCount());
+		mFrameStats.eventsApplied += static_cast<uint32_t>(mInput.GetPendingCount());
 
-		D2D1_RECT_F rect{ mStartPoint.x, mStartPoint.y, mEndPoint.x, mEndPoint.y };
-		mObjects.insert(new Object(rect, D2D1::ColorF(0x000000, 1.f), D2D1::ColorF(0xFFFFFF, 0.f), 1.0f));
+		setCursor(mInput.Apply(*mScene));
 	}
 
-	void App::copySelectedObjects()
+	void App::queueInput(eInputType type, LPARAM lParam)
 	{
-		mCopiedObjectInfo.clear();
-
-		auto center = mSelectedBoundary->GetCenter();
+		const Clock::time_point NOW = Clock::now();
+		const float X = LOWORD(lParam);
+		const float Y = HIWORD(lParam);
 
-		for (auto& obj : mSelectedObjects)
-		{
-			mCopiedObjectInfo.push_back({
-				obj->mRect.left - center.x,
-				obj->mRect.top - center.y,
-				obj->GetWidth(),
-				obj->GetHeight(),
-				obj->mLineColor,
-				obj->mBackgroundColor,
-				obj->mStrokeWidth
-			});
-		}
+		mInput.Push(type, X, Y, NOW);
+		mRecording.Add(type, 0, X, Y, NOW);
 	}
 
-	void App::addCopiedObjectOnCursor(int x, int y)
+	// A middle button drag moves the camera by the cursor's offset since the last move.
+	void App::queuePan(LPARAM lParam)
 	{
-		mSelectedObjects.clear();
-
-		for (const auto& info : mCopiedObjectInfo)
-		{
-			const float LEFT = x + info.leftFromCenter;
-			const float TOP = y + info.topFromCenter;
+		const Clock::time_point NOW = Clock::now();
+		const POINT CURSOR = { static_cast<short>(LOWORD(lParam)), static_cast<short>(HIWORD(lParam)) };
+		const float X = static_cast<float>(CURSOR.x - mPanPoint.x);
+		const float Y = static_cast<float>(CURSOR.y - mPanPoint.y);
+
+		mPanPoint = CURSOR;
+		mInput.Push(eInputType::Pan, X, Y, NOW);
+		mRecording.Add(eInputType::Pan, 0, X, Y, NOW);
+	}
 
-			D2D1_RECT_F rect{ LEFT, TOP, LEFT + info.width, TOP + info.height };
+	// Wheel messages carry screen coordinates. Each notch zooms by WHEEL_ZOOM_FACTOR,
+	// and finer wheels by the matching fraction of it.
+	void App::queueZoom(WPARAM wParam, LPARAM lParam)
+	{
+		const Clock::time_point NOW = Clock::now();
+		POINT cursor = { static_cast<short>(LOWORD(lParam)), static_cast<short>(HIWORD(lParam)) };
+		ScreenToClient(mHwnd, &cursor);
 
-			Object* copiedObject = new Object(rect, info.lineColor, info.backgroundColor, info.strokeWidth);
-			mObjects.insert(copiedObject);
-			mSelectedObjects.insert(copiedObject);
-		}
+		const float FACTOR = powf(WHEEL_ZOOM_FACTOR, static_cast<float>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA);
+		const float X = static_cast<float>(cursor.x);
+		const float Y = static_cast<float>(cursor.y);
 
-		getSelectedObjectsBoundary(mSelectedBoundary->mRect);
+		mInput.PushZoom(FACTOR, X, Y, NOW);
+		mRecording.AddZoom(FACTOR, X, Y, NOW);
 	}
-	
-	void App::duplicateSelectedObject()
+
+	// Latency runs from the oldest input a frame applied until its present returned.
+	void App::reportFrameStats(Clock::time_point now)
 	{
-		std::vector<Object*> duplicatedObjects;
-		duplicatedObjects.reserve(mSelectedObjects.size());
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		const double FRAMES = (std::max)(mFrameStats.framesCount, 1u);
+		const double INPUT_FRAMES = (std::max)(mFrameStats.inputFramesCount, 1u);
+		const double SECONDS = std::chrono::duration<double>(now - mFrameStats.begin).count();
+
+		wchar_t title[256];
+		swprintf_s(title, L"Canvas - %.0f fps, input %.1f -> %.1f per frame, work %.2f ms (max %.2f), latency %.2f ms (max %.2f)",
+			mFrameStats.framesCount / SECONDS,
+			mFrameStats.eventsReceived / INPUT_FRAMES,
+			mFrameStats.eventsApplied / INPUT_FRAMES,
+			Milliseconds(mFrameStats.work).count() / FRAMES,
+			Milliseconds(mFrameStats.maxWork).count(),
+			Milliseconds(mFrameStats.latency).count() / INPUT_FRAMES,
+			Milliseconds(mFrameStats.maxLatency).count());
+
+		SetWindowTextW(mHwnd, title);
+
+		mFrameStats = FrameStats();
+		mFrameStats.begin = now;
+	}
 
-		for (auto obj : mSelectedObjects)
+	void App::saveScene()
+	{
+		if (mScene->IsSaving())
 		{
-			Object* duplicated = new Object(*obj);
-			duplicated->Move(OBJECT_MARGIN, OBJECT_MARGIN);
-
-			mObjects.insert(duplicated);
-			duplicatedObjects.push_back(duplicated);
+			MessageBoxW(mHwnd, L"The previous save is still in progress.", L"Canvas", MB_OK | MB_ICONWARNING);
+			return;
 		}
 
-		mSelectedObjects.clear();
-		mSelectedObjects.insert(duplicatedObjects.begin(), duplicatedObjects.end());
+		wchar_t path[MAX_PATH] = L"";
 
-		getSelectedObjectsBoundary(mSelectedBoundary->mRect);
-	}
+		OPENFILENAMEW dialog = {};
+		dialog.lStructSize = sizeof(dialog);
+		dialog.hwndOwner = mHwnd;
+		dialog.lpstrFilter = L"Canvas Scene (*.canvas)\0*.canvas\0";
+		dialog.lpstrFile = path;
+		dialog.nMaxFile = MAX_PATH;
+		dialog.lpstrDefExt = L"canvas";
+		dialog.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
 
-	void App::removeSelectedObjects()
-	{
-		for (auto obj : mSelectedObjects)
+		if (!GetSaveFileNameW(&dialog))
 		{
-#ifdef _DEBUG
-			size_t ret = mObjects.erase(obj);
-			DEBUG_BREAK(ret != 0);
-#else
-			mObjects.erase(obj);
-#endif
-
-			delete obj;
-			obj = nullptr;
+			return;
 		}
 
-		mSelectedObjects.clear();
+		std::vector<char> utf8Path;
+		const HWND HWND_OWNER = mHwnd;
+
+		const auto onSaved = [HWND_OWNER](bool bSucceeded)
+		{
+			PostMessageW(HWND_OWNER, WM_SCENE_SAVED, bSucceeded, 0);
+		};
+
+		if (!toUtf8(path, utf8Path) || !mScene->SaveAsync(utf8Path.data(), onSaved))
+		{
+			MessageBoxW(mHwnd, L"Failed to save the scene.", L"Canvas", MB_OK | MB_ICONERROR);
+		}
 	}
 
-	Object* App::getObjectOnCursor(float x, float y)
+	bool App::openScene()
 	{
-		if (mCurrMode == eMouseMode::Selected)
-		{
-			for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
-			{
-				if (x >= mResizingRects[i]->mRect.left && x <= mResizingRects[i]->mRect.right
-					&& y >= mResizingRects[i]->mRect.top && y <= mResizingRects[i]->mRect.bottom)
-				{
-					mSelectedResizingRect = mResizingRects[i];
-					mResizingDirection = static_cast<eResizingDirection>(i);
+		wchar_t path[MAX_PATH] = L"";
 
-					return mResizingRects[i];
-				}
-			}
+		OPENFILENAMEW dialog = {};
+		dialog.lStructSize = sizeof(dialog);
+		dialog.hwndOwner = mHwnd;
+		dialog.lpstrFilter = L"Canvas Scene (*.canvas)\0*.canvas\0";
+		dialog.lpstrFile = path;
+		dialog.nMaxFile = MAX_PATH;
+		dialog.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
 
-			mResizingDirection = eResizingDirection::None;
-			
-			if (x >= mSelectedBoundary->mRect.left - OBJECT_MARGIN && x <= mSelectedBoundary->mRect.right + OBJECT_MARGIN
-				&& y >= mSelectedBoundary->mRect.top - OBJECT_MARGIN && y <= mSelectedBoundary->mRect.bottom + OBJECT_MARGIN)
-			{
-				return mSelectedBoundary;
-			}
+		if (!GetOpenFileNameW(&dialog))
+		{
+			return false;
 		}
 
-		Object* result = nullptr;
-		
-		for (auto obj : mObjects)
-		{
-			const float LEFT = obj->mRect.left;
-			const float TOP = obj->mRect.top;
-			const float RIGHT = obj->mRect.right;
-			const float BOTTOM = obj->mRect.bottom;
+		std::vector<char> utf8Path;
 
-			if (obj->mBackgroundColor.a > 0.0)
-			{
-				if (x >= obj->mRect.left - OBJECT_MARGIN && x <= obj->mRect.right + OBJECT_MARGIN
-					&& y >= obj->mRect.top - OBJECT_MARGIN && y <= obj->mRect.bottom + OBJECT_MARGIN)
-				{
-					result = obj;
-					break;
-				}
-			}
-			else
-			{
-				if (y >= TOP - OBJECT_MARGIN && y <= TOP + OBJECT_MARGIN
-					|| y >= BOTTOM - OBJECT_MARGIN && y <= BOTTOM + OBJECT_MARGIN)
-				{
-					if (x >= LEFT - OBJECT_MARGIN && x <= RIGHT + OBJECT_MARGIN)
-					{
-						result = obj;
-						break;
-					}
-				}
-				else if (x >= LEFT - OBJECT_MARGIN && x <= LEFT + OBJECT_MARGIN
-					|| x >= RIGHT - OBJECT_MARGIN && x <= RIGHT + OBJECT_MARGIN)
-				{
-					if (y >= TOP - OBJECT_MARGIN && y <= BOTTOM + OBJECT_MARGIN)
-					{
-						result = obj;
-						break;
-					}
-				}
-			}
+		if (!toUtf8(path, utf8Path) || !mScene->Load(utf8Path.data()))
+		{
+			MessageBoxW(mHwnd, L"Failed to open the scene.", L"Canvas", MB_OK | MB_ICONERROR);
+			return false;
 		}
 
-		return result;
+		return true;
 	}
 
-	void App::addObjectsInDraggingArea()
+	// The rings keep their spans, so every write holds the latest window.
+	void App::writeTrace()
 	{
-		D2D1_RECT_F dragSelectionArea = { mStartPoint.x, mStartPoint.y, mEndPoint.x, mEndPoint.y };
-
-		if (mStartPoint.x > mEndPoint.x)
+		if (!Tracer::Write(mTracePath.data()))
 		{
-			dragSelectionArea.left = mEndPoint.x;
-			dragSelectionArea.right = mStartPoint.x;
+			MessageBoxW(mHwnd, L"Failed to write the trace.", L"Canvas", MB_OK | MB_ICONERROR);
 		}
+	}
 
-		if (mStartPoint.y > mEndPoint.y)
-		{
-			dragSelectionArea.top = mEndPoint.y;
-			dragSelectionArea.bottom = mStartPoint.y;
-		}
+	// Keys without a shortcut map to Count.
+	eKeyValue App::toKeyValue(WPARAM virtualKey)
+	{
+		static constexpr int VIRTUAL_KEYS[TOTAL_KEY_COUNT] = {
+			'1',
+			'2',
+			VK_BACK,
+			'C',
+			'V',
+			'D',
+			'S',
+			'O',
+			'Z',
+			'Y',
+			VK_SHIFT,
+			VK_CONTROL,
+			VK_F3,
+			VK_F4,
+			VK_OEM_4,
+			VK_OEM_6
+		};
 
-		for (auto obj : mObjects)
+		static constexpr std::array<eKeyValue, VIRTUAL_KEY_COUNT> KEYS = []()
 		{
-			if (obj->mRect.left >= dragSelectionArea.left && obj->mRect.right <= dragSelectionArea.right
-				&& obj->mRect.top >= dragSelectionArea.top && obj->mRect.bottom <= dragSelectionArea.bottom)
+			std::array<eKeyValue, VIRTUAL_KEY_COUNT> keys = {};
+
+			for (size_t i = 0; i < keys.size(); ++i)
 			{
-				auto ret = mSelectedObjects.insert(obj);
+				keys[i] = eKeyValue::Count;
 			}
-			else
+
+			for (int i = 0; i < TOTAL_KEY_COUNT; ++i)
 			{
-				if (mSelectedObjects.find(obj) != mSelectedObjects.end())
-				{
-					mSelectedObjects.erase(obj);
-				}
+				keys[VIRTUAL_KEYS[i]] = static_cast<eKeyValue>(i);
 			}
-		}
+
+			return keys;
+		}();
+
+		return virtualKey < KEYS.size() ? KEYS[virtualKey] : eKeyValue::Count;
 	}
 
-	void App::getSelectedObjectsBoundary(D2D1_RECT_F& outBoundary)
+	bool App::toUtf8(const wchar_t* text, std::vector<char>& outText)
 	{
-		outBoundary = { 
-			static_cast<float>(mResolution.x) + 1,
-			static_cast<float>(mResolution.y) + 1,
-			NONE_POINT,
-			NONE_POINT
-		};
-		
-		for (auto obj : mSelectedObjects)
-		{
-			outBoundary.left = outBoundary.left > obj->mRect.left ? obj->mRect.left : outBoundary.left;
-			outBoundary.top = outBoundary.top > obj->mRect.top ? obj->mRect.top : outBoundary.top;
-			outBoundary.right = outBoundary.right < obj->mRect.right ? obj->mRect.right : outBoundary.right;
-			outBoundary.bottom = outBoundary.bottom < obj->mRect.bottom ? obj->mRect.bottom : outBoundary.bottom;
-		}
+		const int LENGTH = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
 
-		if (outBoundary.right == NONE_POINT)
+		if (LENGTH == 0)
 		{
-			DEBUG_BREAK(outBoundary.bottom == NONE_POINT);
-			DEBUG_BREAK(mSelectedObjects.size() == 0);
-
-			outBoundary.left = NONE_POINT;
-			outBoundary.top = NONE_POINT;
-
-			return;
+			return false;
 		}
 
-		ADD_MARGIN_TO_RECT(outBoundary, SELECTED_RECT_MARGIN);
+		outText.resize(LENGTH);
+		WideCharToMultiByte(CP_UTF8, 0, text, -1, outText.data(), LENGTH, nullptr, nullptr);
+
+		return true;
 	}
 
-	void App::getResizeRect(D2D1_RECT_F& out)
+	void App::setCursor(eCursor cursor)
 	{
-		const float DIFF_X = mEndPoint.x - mStartPoint.x;
-		const float DIFF_Y = mEndPoint.y - mStartPoint.y;
-
-		switch (mResizingDirection)
+		switch (cursor)
 		{
-		case eResizingDirection::NorthWest:
-			out = { DIFF_X, DIFF_Y, 0, 0 };
-			SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
+		case eCursor::Unchanged:
 			break;
-		case eResizingDirection::North:
-			out = { 0, DIFF_Y, 0, 0 };
-			SetCursor(LoadCursor(nullptr, IDC_SIZENS));
+		case eCursor::Arrow:
+			SetCursor(LoadCursor(nullptr, IDC_ARROW));
 			break;
-		case eResizingDirection::NorthEast:
-			out = { 0, DIFF_Y, DIFF_X, 0 };
-			SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
+		case eCursor::Cross:
+			SetCursor(LoadCursor(nullptr, IDC_CROSS));
 			break;
-		case eResizingDirection::West:
-			out = { DIFF_X, 0, 0, 0 };
-			SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
+		case eCursor::SizeAll:
+			SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
 			break;
-		case eResizingDirection::East:
-			out = { 0, 0, DIFF_X, 0 };
-			SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
+		case eCursor::SizeNWSE:
+			SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
 			break;
-		case eResizingDirection::SouthWest:
-			out = { DIFF_X, 0, 0, DIFF_Y };
+		case eCursor::SizeNESW:
 			SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
 			break;
-		case eResizingDirection::South:
-			out = { 0, 0, 0, DIFF_Y };
+		case eCursor::SizeNS:
 			SetCursor(LoadCursor(nullptr, IDC_SIZENS));
 			break;
-		case eResizingDirection::SouthEast:
-			out = { 0, 0, DIFF_X, DIFF_Y };
-			SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
+		case eCursor::SizeWE:
+			SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
 			break;
 		default:
 			DEBUG_BREAK(false);
@@ -454,481 +432,171 @@ namespace canvas
 		}
 	}
 
-	void App::moveSelectedObjects(float x, float y)
-	{
-		for (auto obj : mSelectedObjects)
-		{
-			obj->Move(x, y);
-		}
-
-		mSelectedBoundary->Move(x, y);
-	}
-
+	// Drains every pending message, then applies the collected input and
+	// renders once. EndDraw waits for the vertical blank, which paces the loop
+	// to the display; with nothing to draw it sleeps until the next message.
 	void App::Run()
 	{
 		MSG msg;
 
-		while (GetMessage(&msg, NULL, 0, 0))
+		for (;;)
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+			{
+				if (msg.message == WM_QUIT)
+				{
+					return;
+				}
+
+				TraceScope scope("dispatch");
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+
+			if (mbFramePending)
+			{
+				runFrame();
+			}
+			else
+			{
+				WaitMessage();
+			}
 		}
 	}
 
 	LRESULT App::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	{
-		static KeyManager* keyManager = KeyManager::GetInstance();
-
 		switch (message)
 		{
 		case WM_DESTROY:
 			PostQuitMessage(0);
 			break;
 		case WM_PAINT:
-			if (mbLButtonDown && mEndPoint.x >= 0)
-			{
-				switch (mCurrMode)
-				{
-				case eMouseMode::Select:
-					mDragSelectionArea->SetLeftTop(mStartPoint);
-					mDragSelectionArea->SetRightBottom(mEndPoint);
-					break;
-				case eMouseMode::Rect:
-					mNewObjectArea->SetLeftTop(mStartPoint);
-					mNewObjectArea->SetRightBottom(mEndPoint);
-					break;
-				}
-			}
-			break;
-		case WM_LBUTTONDOWN:
-			DEBUG_BREAK(!mbLButtonDown);
-			mbLButtonDown = true;
-			mStartPoint.x = LOWORD(lParam);
-			mStartPoint.y = HIWORD(lParam);
+		{
+			RECT updateRect;
 
-			switch (mCurrMode)
-			{
-			case eMouseMode::Select:
-			case eMouseMode::Selected:
+			if (GetUpdateRect(hWnd, &updateRect, FALSE))
 			{
-				Object* selected = mInstance->getObjectOnCursor(mStartPoint.x, mStartPoint.y);
-
-				if (selected == nullptr)
-				{
-					SET_NONE_RECT(mSelectedBoundary);
-					mCurrMode = eMouseMode::Select;
-					break;
-				}
-				else if (mResizingDirection != eResizingDirection::None)
-				{
-					mCurrMode = eMouseMode::Resize;
-
-					switch (mResizingDirection)
-					{
-					case eResizingDirection::NorthWest:
-					case eResizingDirection::SouthEast:
-						SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
-						break;
-					case eResizingDirection::South:
-					case eResizingDirection::North:
-						SetCursor(LoadCursor(nullptr, IDC_SIZENS));
-						break;
-					case eResizingDirection::NorthEast:
-					case eResizingDirection::SouthWest:
-						SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
-						break;
-					case eResizingDirection::West:
-					case eResizingDirection::East:
-						SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
-						break;
-					case eResizingDirection::None:
-						SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-						break;
-					default:
-						DEBUG_BREAK(false);
-						break;
-					}
-
-					break;
-				}
-				else if (selected == mSelectedBoundary)
-				{
-					SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-					break;
-				}
-
-				mSelectedObjects.clear();
-
-				SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-				mSelectedObjects.insert(selected);
+				mInstance->mScene->Invalidate({
+					static_cast<float>(updateRect.left),
+					static_cast<float>(updateRect.top),
+					static_cast<float>(updateRect.right),
+					static_cast<float>(updateRect.bottom)
+				});
+			}
 
-				D2D1_RECT_F rect = selected->mRect;
-				ADD_MARGIN_TO_RECT(rect, SELECTED_RECT_MARGIN);
-				mSelectedBoundary->SetRect(rect);
+			ValidateRect(hWnd, nullptr);
 
-				mCurrMode = eMouseMode::Selected;
-			}
-				break;
-			case eMouseMode::Rect:
-				SetCursor(LoadCursor(nullptr, IDC_CROSS));
-				SET_NONE_RECT(mSelectedBoundary);
-				break;
-			default:
-				DEBUG_BREAK(false);
-				break;
+			// Also reached from modal loops, where Run does not get to draw.
+			mInstance->runFrame();
+		}
+			goto no_render;
+		case WM_SCENE_SAVED:
+			if (!wParam)
+			{
+				MessageBoxW(hWnd, L"Failed to save the scene.", L"Canvas", MB_OK | MB_ICONERROR);
 			}
 			break;
+		case WM_LBUTTONDOWN:
+			mInstance->queueInput(eInputType::MouseDown, lParam);
+			break;
 		case WM_MOUSEMOVE:
-			if (mbLButtonDown)
+			if (wParam & MK_MBUTTON)
 			{
-				mEndPoint.x = LOWORD(lParam);
-				mEndPoint.y = HIWORD(lParam);
-
-				switch (mCurrMode)
-				{
-				case eMouseMode::Select:
-					mDragSelectionArea->SetLeftTop(mStartPoint);
-					mDragSelectionArea->SetRightBottom(mEndPoint);
-
-					mInstance->addObjectsInDraggingArea();
-
-					mInstance->getSelectedObjectsBoundary(mSelectedBoundary->mRect);
-					break;
-				case eMouseMode::Selected:
-					SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-
-					mInstance->moveSelectedObjects(mEndPoint.x - mStartPoint.x, mEndPoint.y - mStartPoint.y);
-
-					mStartPoint.x = mEndPoint.x;
-					mStartPoint.y = mEndPoint.y;
-					break;
-				case eMouseMode::Resize:
-				{
-					DEBUG_BREAK(mSelectedResizingRect != nullptr);
-					DEBUG_BREAK(mSelectedObjects.size() > 0);
-					D2D1_RECT_F resize;
-
-					if (mSelectedObjects.size() == 1)
-					{
-						mInstance->getResizeRect(resize);
-
-						auto obj = mSelectedObjects.begin();
-						(*obj)->mRect.left += resize.left;
-						(*obj)->mRect.top += resize.top;
-						(*obj)->mRect.right += resize.right;
-						(*obj)->mRect.bottom += resize.bottom;
-					}
-					else
-					{
-						float diffX = mEndPoint.x - mStartPoint.x;
-						float diffY = mEndPoint.y - mStartPoint.y;
-
-						float oppositePointX;
-						float oppositePointY;
-
-						switch (mResizingDirection)
-						{
-						case eResizingDirection::NorthWest:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
-							if (diffY == 0)
-							{
-								if (diffX == -1)
-								{
-									diffY = -1;
-								}
-								else
-								{
-									diffX = 0;
-								}
-							}
-							else if (diffX == 0)
-							{
-								if (diffY == -1)
-								{
-									diffX = -1;
-								}
-								else
-								{
-									diffY = 0;
-								}
-							}
-
-							resize = { diffX, diffY, 0, 0 };
-							oppositePointX = mSelectedBoundary->mRect.right;
-							oppositePointY = mSelectedBoundary->mRect.bottom;
-							break;
-						case eResizingDirection::NorthEast:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
-							if (diffY == 0)
-							{
-								if (diffX == 1)
-								{
-									diffY = -1;
-								}
-								else
-								{
-									diffX = 0;
-								}
-							}
-							else if (diffX == 0)
-							{
-								if (diffY == -1)
-								{
-									diffX = 1;
-								}
-								else
-								{
-									diffY = 0;
-								}
-							}
-
-							resize = { 0, diffY, diffX, 0 };
-
-							oppositePointX = mSelectedBoundary->mRect.left;
-							oppositePointY = mSelectedBoundary->mRect.bottom;
-							break;
-						case eResizingDirection::SouthWest:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
-							if (diffY == 0)
-							{
-								if (diffX == -1)
-								{
-									diffY = 1;
-								}
-								else
-								{
-									diffX = 0;
-								}
-							}
-							else if (diffX == 0)
-							{
-								if (diffY == 1)
-								{
-									diffX = -1;
-								}
-								else
-								{
-									diffY = 0;
-								}
-							}
-
-							resize = { diffX, 0, 0, diffY };
-
-							oppositePointX = mSelectedBoundary->mRect.right;
-							oppositePointY = mSelectedBoundary->mRect.top;
-							break;
-						case eResizingDirection::SouthEast:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
-							if (diffY == 0)
-							{
-								if (diffX == 1)
-								{
-									diffY = 1;
-								}
-								else
-								{
-									diffX = 0;
-								}
-							}
-							else if (diffX == 0)
-							{
-								if (diffY == 1)
-								{
-									diffX = 1;
-								}
-								else
-								{
-									diffY = 0;
-								}
-							}
-
-							resize = { 0, 0, diffX, diffY };
-
-							oppositePointX = mSelectedBoundary->mRect.left;
-							oppositePointY = mSelectedBoundary->mRect.top;
-							break;
-						default:
-							DEBUG_BREAK(false);
-							break;
-						}
-
-						if (diffX == 0 && diffY == 0)
-						{
-							mEndPoint.x = mStartPoint.x;
-							mEndPoint.y = mStartPoint.y;
-							break;
-						}
-
-						const float boundaryWidth = mSelectedBoundary->GetWidth();
-						const float bouddaryHeight = mSelectedBoundary->GetHeight();
-
-						for (auto obj : mSelectedObjects)
-						{
-							obj->mRect.left += abs(oppositePointX - obj->mRect.left) / boundaryWidth * diffX;
-							obj->mRect.top += abs(oppositePointY - obj->mRect.top) / bouddaryHeight * diffY;
-
-							obj->mRect.right += abs(oppositePointX - obj->mRect.right) / boundaryWidth * diffX;
-							obj->mRect.bottom += abs(oppositePointY - obj->mRect.bottom) / bouddaryHeight * diffY;
-						}
-					}
-
-					mSelectedBoundary->mRect.left += resize.left;
-					mSelectedBoundary->mRect.top += resize.top;
-					mSelectedBoundary->mRect.right += resize.right;
-					mSelectedBoundary->mRect.bottom += resize.bottom;
-
-					mStartPoint.x = mEndPoint.x;
-					mStartPoint.y = mEndPoint.y;
-				}
-					break;
-				case eMouseMode::Rect:
-					SetCursor(LoadCursor(nullptr, IDC_CROSS));
-					mNewObjectArea->SetLeftTop(mStartPoint);
-					mNewObjectArea->SetRightBottom(mEndPoint);
-					break;
-				default:
-					DEBUG_BREAK(false);
-					break;
-				}
+				mInstance->queuePan(lParam);
 			}
 			else
 			{
-				switch (mCurrMode)
-				{
-				case eMouseMode::Select:
-				case eMouseMode::Selected:
-					if (mInstance->getObjectOnCursor(LOWORD(lParam), HIWORD(lParam)))
-					{
-						switch (mResizingDirection)
-						{
-						case eResizingDirection::NorthWest:
-						case eResizingDirection::SouthEast:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENWSE));
-							break;
-						case eResizingDirection::South:
-						case eResizingDirection::North:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENS));
-							break;
-						case eResizingDirection::NorthEast:
-						case eResizingDirection::SouthWest:
-							SetCursor(LoadCursor(nullptr, IDC_SIZENESW));
-							break;
-						case eResizingDirection::West:
-						case eResizingDirection::East:
-							SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
-							break;
-						case eResizingDirection::None:
-							SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-							break;
-						default:
-							DEBUG_BREAK(false);
-							break;
-						}
-					}
-					break;
-				case eMouseMode::Rect:
-					SetCursor(LoadCursor(nullptr, IDC_CROSS));
-					break;
-				default:
-					DEBUG_BREAK(false);
-					break;
-				}
+				mInstance->queueInput(eInputType::MouseMove, lParam);
 			}
 			break;
 		case WM_LBUTTONUP:
-			DEBUG_BREAK(mbLButtonDown);
+			mInstance->queueInput(eInputType::MouseUp, lParam);
+			break;
+		case WM_MBUTTONDOWN:
+			mInstance->mPanPoint = { static_cast<short>(LOWORD(lParam)), static_cast<short>(HIWORD(lParam)) };
+			goto no_render;
+		case WM_MOUSEWHEEL:
+			mInstance->queueZoom(wParam, lParam);
+			break;
+		case WM_KEYDOWN:
+		{
+			const eKeyValue KEY = toKeyValue(wParam);
 
-			switch (mCurrMode)
+			if (KEY == eKeyValue::Count)
 			{
-			case eMouseMode::Select:
-				if (mSelectedObjects.size() > 0)
+				goto no_render;
+			}
+
+			const eCommand COMMAND = mInstance->mKeys.KeyDown(KEY);
+			mInstance->applyInput();
+
+			POINT cursorPoint = { 0, 0 };
+			GetCursorPos(&cursorPoint);
+			ScreenToClient(mInstance->mHwnd, &cursorPoint);
+
+			const float X = static_cast<float>(cursorPoint.x);
+			const float Y = static_cast<float>(cursorPoint.y);
+
+			mInstance->mRecording.Add(eInputType::KeyDown, mInstance->mKeys.GetHeldKeys(), X, Y, Clock::now());
+
+			if (mInstance->mScene->RunCommand(COMMAND, X, Y))
+			{
+				if (COMMAND == eCommand::SelectMode)
 				{
-					mCurrMode = eMouseMode::Selected;
+					setCursor(eCursor::Arrow);
 				}
-
-				SET_NONE_RECT(mDragSelectionArea);
-				break;
-			case eMouseMode::Selected:
-				if (mSelectedObjects.size() > 0)
+				else if (COMMAND == eCommand::RectMode)
 				{
-					SetCursor(LoadCursor(nullptr, IDC_SIZEALL));
-					mCurrMode = eMouseMode::Selected;
+					setCursor(eCursor::Cross);
 				}
-				break;
-			case eMouseMode::Resize:
-				mCurrMode = eMouseMode::Selected;
-				mSelectedResizingRect = nullptr;
-				mResizingDirection = eResizingDirection::None;
-				break;
-			case eMouseMode::Rect:
-				mInstance->addObject();
-
-				SET_NONE_RECT(mNewObjectArea);
-
-				mCurrMode = eMouseMode::Select;
-				break;
-			default:
-				DEBUG_BREAK(false);
-				break;
-			}
 
-			mbLButtonDown = false;
-			mEndPoint.x = NONE_POINT;
-			mEndPoint.y = NONE_POINT;
-			break;
-		case WM_KEYDOWN:
-			keyManager->Update();
-
-			if (keyManager->IsKeyPressed(eKeyValue::Select))
-			{
-				mCurrMode = eMouseMode::Select;
-				SetCursor(LoadCursor(nullptr, IDC_ARROW));
+				goto request_frame;
 			}
-			else if (keyManager->IsKeyPressed(eKeyValue::Rect))
+			else if (COMMAND == eCommand::Save)
 			{
-				mCurrMode = eMouseMode::Rect;
-				SetCursor(LoadCursor(nullptr, IDC_CROSS));
+				mInstance->saveScene();
 			}
-			else if (keyManager->IsKeyPressed(eKeyValue::Backspace))
+			else if (COMMAND == eCommand::Open && mInstance->openScene())
 			{
-				mInstance->removeSelectedObjects();
-
-				SET_NONE_RECT(mSelectedBoundary);
-				mCurrMode = eMouseMode::Select;
-
-				goto call_render;
+				setCursor(eCursor::Arrow);
+				goto request_frame;
 			}
-			else if (keyManager->IsKeyPressed(eKeyValue::C) && keyManager->IsKeyPressed(eKeyValue::Ctrl))
+			else if (COMMAND == eCommand::WriteTrace)
 			{
-				mInstance->copySelectedObjects();
+				if (Tracer::IsEnabled())
+				{
+					mInstance->writeTrace();
+				}
+				else
+				{
+					mInstance->StartTracing(TRACE_DEFAULT_PATH);
+				}
 			}
-			else if (keyManager->IsKeyPressed(eKeyValue::V) && keyManager->IsKeyPressed(eKeyValue::Ctrl))
-			{
-				POINT cursorPoint = { 0, 0 };
-				GetCursorPos(&cursorPoint);
-				ScreenToClient(mInstance->mHwnd, &cursorPoint);
-
-				mInstance->addCopiedObjectOnCursor(cursorPoint.x, cursorPoint.y);
+		}
+			goto no_render;
+		case WM_KEYUP:
+		{
+			const eKeyValue KEY = toKeyValue(wParam);
 
-				goto call_render;
-			}
-			else if (keyManager->IsKeyPressed(eKeyValue::D) && keyManager->IsKeyPressed(eKeyValue::Ctrl))
+			if (KEY != eKeyValue::Count)
 			{
-				mInstance->duplicateSelectedObject();
-				goto call_render;
+				mInstance->mKeys.KeyUp(KEY);
+				mInstance->mRecording.Add(eInputType::KeyUp, mInstance->mKeys.GetHeldKeys(), 0.f, 0.f, Clock::now());
 			}
-
+		}
 			goto no_render;
-		case WM_KEYUP:
-			keyManager->Update();
+		case WM_KILLFOCUS:
+			mInstance->mKeys.Reset();
+			mInstance->mRecording.Add(eInputType::KeyUp, 0, 0.f, 0.f, Clock::now());
 
 			goto no_render;
 		default:
 			return DefWindowProc(hWnd, message, wParam, lParam);
 		}
 
-	call_render:
-		mInstance->render();
+	request_frame:
+		mInstance->mbFramePending = true;
 
 	no_render:
 		return 0;
@@ -1,7 +1,10 @@
 #pragma once
 
-#include "Object.h"
 #include "KeyManager.h"
+#include "Scene.h"
+#include "InputQueue.h"
+#include "InputRecording.h"
+#include "D2DRenderBackend.h"
 
 namespace canvas
 {
@@ -12,6 +15,10 @@ namespace canvas
 		HRESULT Init(HWND, POINT);
 		void Run();
 		void Release();
+		bool StartRecording(const wchar_t* path);
+		bool StartProfiling(const wchar_t* path);
+		bool StartTracing(const wchar_t* path);
+		const RenderStats& GetRenderStats() const;
 
 		static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
@@ -22,134 +29,59 @@ namespace canvas
 		App& operator=(const App* rhs) = delete;
 
 	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct FrameStats
+		{
+			Clock::time_point begin;
+			uint32_t framesCount;
+			uint32_t eventsReceived;
+			uint32_t eventsApplied;
+			uint32_t inputFramesCount;
+			Clock::duration work;
+			Clock::duration maxWork;
+			Clock::duration latency;
+			Clock::duration maxLatency;
+		};
+
 		HRESULT createDeviceResources();
 		void discardDeviceResources();
 
 		HRESULT render();
-		
-		void addObject();
-		void addCopiedObjectOnCursor(int x, int y);
-		void duplicateSelectedObject();
-		void removeSelectedObjects();
-		void copySelectedObjects();
-		void moveSelectedObjects(float x, float y);
-		Object* getObjectOnCursor(float x, float y);
-		void addObjectsInDraggingArea();
-		void getSelectedObjectsBoundary(D2D1_RECT_F& out);
-		void getResizeRect(D2D1_RECT_F& out);
-		
-		inline void setResizingRectsPoint();
-		inline void setResizingRectsNone();
-		
+		void runFrame();
+		void applyInput();
+		void queueInput(eInputType type, LPARAM lParam);
+		void queuePan(LPARAM lParam);
+		void queueZoom(WPARAM wParam, LPARAM lParam);
+		void reportFrameStats(Clock::time_point now);
+		void saveScene();
+		bool openScene();
+		void writeTrace();
+
+		static void setCursor(eCursor cursor);
+		static eKeyValue toKeyValue(WPARAM virtualKey);
+		static bool toUtf8(const wchar_t* text, std::vector<char>& outText);
+
 	private:
 		static App* mInstance;
-		static bool mbLButtonDown;
-		static D2D1_POINT_2F mStartPoint;
-		static D2D1_POINT_2F mEndPoint;
-		static eMouseMode mCurrMode;
-
-		static std::unordered_set<Object*> mObjects;
-		static std::unordered_set<Object*> mSelectedObjects;
-		static std::vector<ObjectInfo> mCopiedObjectInfo;
 
-		static Object* mDragSelectionArea;
-		static Object* mSelectedBoundary;
-		static Object* mSelectedResizingRect;
-		static eResizingDirection mResizingDirection;
-		static Object* mNewObjectArea;
-		static Object* mResizingRects[RESIZING_RECTS_COUNT];
-		
 		HWND mHwnd;
 		POINT mResolution;
 
 		ID2D1Factory* mD2DFactory;
-		ID2D1HwndRenderTarget* mRenderTarget;
-		ID2D1SolidColorBrush* mObjectBrush;
+		D2DRenderBackend mD2DBackend;
+		RenderBackend* mRenderBackend;
+		Scene* mScene;
+
+		InputQueue mInput;
+		KeyManager mKeys;
+		POINT mPanPoint;
+		bool mbFramePending;
+		FrameStats mFrameStats;
+
+		InputRecording mRecording;
+		std::vector<char> mRecordingPath;
+		std::vector<char> mProfilePath;
+		std::vector<char> mTracePath;
 	};
-
-	inline void App::setResizingRectsPoint()
-	{
-		if (mSelectedBoundary->mRect.left == NONE_POINT)
-		{
-			return;
-		}
-
-		const D2D1_POINT_2F LEFT_TOP = { mSelectedBoundary->mRect.left, mSelectedBoundary->mRect.top };
-		const D2D1_POINT_2F RIGHT_BOTTOM = { mSelectedBoundary->mRect.right, mSelectedBoundary->mRect.bottom };
-		const D2D1_POINT_2F CENTER = mSelectedBoundary->GetCenter();
-		
-		mResizingRects[static_cast<int>(eResizingDirection::NorthWest)]->mRect = { 
-			LEFT_TOP.x - RESIZING_RECT_SIZE,
-			LEFT_TOP.y - RESIZING_RECT_SIZE,
-			LEFT_TOP.x + RESIZING_RECT_SIZE,
-			LEFT_TOP.y + RESIZING_RECT_SIZE
-		};
-
-		mResizingRects[static_cast<int>(eResizingDirection::NorthEast)]->mRect = {
-			RIGHT_BOTTOM.x - RESIZING_RECT_SIZE,
-			LEFT_TOP.y - RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.x + RESIZING_RECT_SIZE,
-			LEFT_TOP.y + RESIZING_RECT_SIZE
-		};
-
-		mResizingRects[static_cast<int>(eResizingDirection::SouthWest)]->mRect = {
-			LEFT_TOP.x - RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.y - RESIZING_RECT_SIZE,
-			LEFT_TOP.x + RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.y + RESIZING_RECT_SIZE
-		};
-
-		mResizingRects[static_cast<int>(eResizingDirection::SouthEast)]->mRect = {
-			RIGHT_BOTTOM.x - RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.y - RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.x + RESIZING_RECT_SIZE,
-			RIGHT_BOTTOM.y + RESIZING_RECT_SIZE
-		};
-
-		if (mSelectedObjects.size() == 1)
-		{
-			mResizingRects[static_cast<int>(eResizingDirection::North)]->mRect = {
-				CENTER.x - RESIZING_RECT_SIZE,
-				LEFT_TOP.y - RESIZING_RECT_SIZE,
-				CENTER.x + RESIZING_RECT_SIZE,
-				LEFT_TOP.y + RESIZING_RECT_SIZE
-			};
-
-			mResizingRects[static_cast<int>(eResizingDirection::West)]->mRect = {
-				LEFT_TOP.x - RESIZING_RECT_SIZE,
-				CENTER.y - RESIZING_RECT_SIZE,
-				LEFT_TOP.x + RESIZING_RECT_SIZE,
-				CENTER.y + RESIZING_RECT_SIZE
-			};
-
-			mResizingRects[static_cast<int>(eResizingDirection::East)]->mRect = {
-				RIGHT_BOTTOM.x - RESIZING_RECT_SIZE,
-				CENTER.y - RESIZING_RECT_SIZE,
-				RIGHT_BOTTOM.x + RESIZING_RECT_SIZE,
-				CENTER.y + RESIZING_RECT_SIZE
-			};
-
-			mResizingRects[static_cast<int>(eResizingDirection::South)]->mRect = {
-				CENTER.x - RESIZING_RECT_SIZE,
-				RIGHT_BOTTOM.y - RESIZING_RECT_SIZE,
-				CENTER.x + RESIZING_RECT_SIZE,
-				RIGHT_BOTTOM.y + RESIZING_RECT_SIZE
-			};
-		}
-		else
-		{
-			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::North)]);
-			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::West)]);
-			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::East)]);
-			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::South)]);
-		}
-	}
-
-	inline void App::setResizingRectsNone()
-	{
-		for (auto obj : mResizingRects)
-		{
-			SET_NONE_RECT(obj);
-		}
-	}
 }
@@ -3,6 +3,8 @@
 #include "App.h"
 #include "Canvas.h"
 
+#include <shellapi.h>
+
 using namespace canvas;
 
 HINSTANCE hInst;
@@ -27,6 +29,35 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return FALSE;
     }
 
+    // Canvas.exe [/record session.cvin] [/profile profile.txt] [/trace trace.json]
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    bool bSucceeded = argv != nullptr;
+
+    for (int i = 1; bSucceeded && i + 1 < argc; i += 2)
+    {
+        if (wcscmp(argv[i], L"/record") == 0)
+        {
+            bSucceeded = app->StartRecording(argv[i + 1]);
+        }
+        else if (wcscmp(argv[i], L"/profile") == 0)
+        {
+            bSucceeded = app->StartProfiling(argv[i + 1]);
+        }
+        else if (wcscmp(argv[i], L"/trace") == 0)
+        {
+            bSucceeded = app->StartTracing(argv[i + 1]);
+        }
+    }
+
+    LocalFree(argv);
+
+    if (!bSucceeded)
+    {
+        app->Release();
+        return FALSE;
+    }
+
     app->Run();
 
     app->Release();
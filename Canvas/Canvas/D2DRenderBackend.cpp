@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "D2DRenderBackend.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	D2DRenderBackend::D2DRenderBackend()
+		: mRenderTarget(nullptr)
+		, mBrush(nullptr)
+		, mWriteFactory(nullptr)
+		, mTextFormat(nullptr)
+		, mBrushColor(MakeColor(0x000000, 1.f))
+		, mLastResult(S_OK)
+		, mLastPresentTime(0)
+	{
+	}
+
+	D2DRenderBackend::~D2DRenderBackend()
+	{
+		Release();
+	}
+
+	HRESULT D2DRenderBackend::Init(ID2D1Factory* factory, HWND hWnd)
+	{
+		if (mRenderTarget != nullptr)
+		{
+			return S_OK;
+		}
+
+		RECT rt;
+		GetClientRect(hWnd, &rt);
+
+		D2D1_SIZE_U size = D2D1::SizeU(rt.right - rt.left, rt.bottom - rt.top);
+
+		HRESULT hr = factory->CreateHwndRenderTarget(
+			D2D1::RenderTargetProperties(),
+			D2D1::HwndRenderTargetProperties(hWnd, size, D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS),
+			&mRenderTarget
+		);
+
+		if (SUCCEEDED(hr))
+		{
+			mBrushColor = MakeColor(0x000000, 1.f);
+			hr = mRenderTarget->CreateSolidColorBrush(toD2DColor(mBrushColor), &mBrush);
+		}
+
+		if (SUCCEEDED(hr))
+		{
+			hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), reinterpret_cast<IUnknown**>(&mWriteFactory));
+		}
+
+		if (SUCCEEDED(hr))
+		{
+			hr = mWriteFactory->CreateTextFormat(L"Consolas", nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL,
+				DWRITE_FONT_STRETCH_NORMAL, 12.f, L"en-us", &mTextFormat);
+		}
+
+		return hr;
+	}
+
+	void D2DRenderBackend::Release()
+	{
+		SafeRelease(&mTextFormat);
+		SafeRelease(&mWriteFactory);
+		SafeRelease(&mBrush);
+		SafeRelease(&mRenderTarget);
+	}
+
+	void D2DRenderBackend::BeginFrame()
+	{
+		mLastPresentTime = std::chrono::steady_clock::duration(0);
+
+		mRenderTarget->BeginDraw();
+		mRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+	}
+
+	bool D2DRenderBackend::EndFrame()
+	{
+		TraceScope scope("present");
+		const std::chrono::steady_clock::time_point BEGIN = std::chrono::steady_clock::now();
+		mLastResult = mRenderTarget->EndDraw();
+		mLastPresentTime = std::chrono::steady_clock::now() - BEGIN;
+
+		return SUCCEEDED(mLastResult);
+	}
+
+	void D2DRenderBackend::Clear(const ColorF& color)
+	{
+		mRenderTarget->Clear(toD2DColor(color));
+	}
+
+	void D2DRenderBackend::PushClip(const RectF& rect)
+	{
+		mRenderTarget->PushAxisAlignedClip(toD2DRect(rect), D2D1_ANTIALIAS_MODE_ALIASED);
+	}
+
+	void D2DRenderBackend::PopClip()
+	{
+		mRenderTarget->PopAxisAlignedClip();
+	}
+
+	void D2DRenderBackend::FillRect(const RectF& rect, const ColorF& color)
+	{
+		setColor(color);
+		mRenderTarget->FillRectangle(toD2DRect(rect), mBrush);
+	}
+
+	void D2DRenderBackend::StrokeRect(const RectF& rect, const ColorF& color, float strokeWidth)
+	{
+		setColor(color);
+		mRenderTarget->DrawRectangle(toD2DRect(rect), mBrush, strokeWidth);
+	}
+
+	void D2DRenderBackend::FillRects(const RectF* rects, size_t count, const ColorF& color)
+	{
+		setColor(color);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			mRenderTarget->FillRectangle(toD2DRect(rects[i]), mBrush);
+		}
+	}
+
+	void D2DRenderBackend::StrokeRects(const RectF* rects, size_t count, const ColorF& color, float strokeWidth)
+	{
+		setColor(color);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			mRenderTarget->DrawRectangle(toD2DRect(rects[i]), mBrush, strokeWidth);
+		}
+	}
+
+	void D2DRenderBackend::DrawLabel(const RectF& rect, const char* text, const ColorF& color)
+	{
+		wchar_t wideText[PROFILER_LABEL_LENGTH];
+		UINT32 length = 0;
+
+		for (; text[length] != '\0' && length < PROFILER_LABEL_LENGTH; ++length)
+		{
+			wideText[length] = static_cast<wchar_t>(text[length]);
+		}
+
+		setColor(color);
+		mRenderTarget->DrawText(wideText, length, mTextFormat, toD2DRect(rect), mBrush);
+	}
+
+	// Aliased nearest-neighbour scaling, so tile edges meet without seams.
+	void D2DRenderBackend::DrawBitmap(const RectF& rect, const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t stride)
+	{
+		ID2D1Bitmap* bitmap = nullptr;
+		const D2D1_BITMAP_PROPERTIES PROPERTIES = D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_R8G8B8A8_UNORM, D2D1_ALPHA_MODE_IGNORE));
+
+		if (FAILED(mRenderTarget->CreateBitmap(D2D1::SizeU(width, height), pixels, stride * sizeof(uint32_t), PROPERTIES, &bitmap)))
+		{
+			return;
+		}
+
+		mRenderTarget->DrawBitmap(bitmap, toD2DRect(rect), 1.f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+		bitmap->Release();
+	}
+
+	void D2DRenderBackend::setColor(const ColorF& color)
+	{
+		if (memcmp(&mBrushColor, &color, sizeof(ColorF)) == 0)
+		{
+			return;
+		}
+
+		mBrushColor = color;
+		mBrush->SetColor(toD2DColor(color));
+	}
+}
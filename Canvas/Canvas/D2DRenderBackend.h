@@ -0,0 +1,71 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+namespace canvas
+{
+	class D2DRenderBackend final : public RenderBackend
+	{
+	public:
+		D2DRenderBackend();
+		~D2DRenderBackend();
+		D2DRenderBackend(const D2DRenderBackend& other) = delete;
+		D2DRenderBackend& operator=(const D2DRenderBackend& rhs) = delete;
+
+		HRESULT Init(ID2D1Factory* factory, HWND hWnd);
+		void Release();
+
+		void BeginFrame() override;
+		bool EndFrame() override;
+
+		void Clear(const ColorF& color) override;
+		void PushClip(const RectF& rect) override;
+		void PopClip() override;
+
+		void FillRect(const RectF& rect, const ColorF& color) override;
+		void StrokeRect(const RectF& rect, const ColorF& color, float strokeWidth) override;
+		void FillRects(const RectF* rects, size_t count, const ColorF& color) override;
+		void StrokeRects(const RectF* rects, size_t count, const ColorF& color, float strokeWidth) override;
+		void DrawLabel(const RectF& rect, const char* text, const ColorF& color) override;
+		void DrawBitmap(const RectF& rect, const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t stride) override;
+
+		inline HRESULT GetLastResult() const;
+		inline std::chrono::steady_clock::duration GetLastPresentTime() const;
+
+	private:
+		void setColor(const ColorF& color);
+
+		inline static D2D1_RECT_F toD2DRect(const RectF& rect);
+		inline static D2D1_COLOR_F toD2DColor(const ColorF& color);
+
+	private:
+		ID2D1HwndRenderTarget* mRenderTarget;
+		ID2D1SolidColorBrush* mBrush;
+		IDWriteFactory* mWriteFactory;
+		IDWriteTextFormat* mTextFormat;
+		ColorF mBrushColor;
+		HRESULT mLastResult;
+		std::chrono::steady_clock::duration mLastPresentTime;
+	};
+
+	inline HRESULT D2DRenderBackend::GetLastResult() const
+	{
+		return mLastResult;
+	}
+
+	// EndDraw blocks until the frame is queued for the next vertical blank.
+	inline std::chrono::steady_clock::duration D2DRenderBackend::GetLastPresentTime() const
+	{
+		return mLastPresentTime;
+	}
+
+	inline D2D1_RECT_F D2DRenderBackend::toD2DRect(const RectF& rect)
+	{
+		return D2D1::RectF(rect.left, rect.top, rect.right, rect.bottom);
+	}
+
+	inline D2D1_COLOR_F D2DRenderBackend::toD2DColor(const ColorF& color)
+	{
+		return D2D1::ColorF(color.r, color.g, color.b, color.a);
+	}
+}
@@ -3,14 +3,30 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <memory.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include <wchar.h>
 #include <math.h>
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
 #include <limits>
-#include <intrin.h>
+#include <cfloat>
 #include <cassert>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <functional>
+#include <string>
+#include <chrono>
+#include <array>
+#include <iterator>
 
+#include <commdlg.h>
 #include <d2d1.h>
 #include <d2d1helper.h>
 #include <dwrite.h>
@@ -23,5 +39,6 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 
 #define MAX_LOADSTRING 100
 
+#include "CoreHelper.h"
 #include "CanvasHelper.h"
 #include "resource.h"
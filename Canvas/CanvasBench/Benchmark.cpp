@@ -0,0 +1,917 @@
+#include "pch.h"
+#include "Scene.h"
+#include "CpuRenderBackend.h"
+#include "InputQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <random>
+
+#define VIEWPORT_WIDTH (1280)
+#define VIEWPORT_HEIGHT (720)
+#define AREA_PER_OBJECT (40.f)
+#define HIT_TEST_COUNT (100000)
+#define KERNEL_RECTS (static_cast<size_t>(1) << 26)
+#define MARQUEE_STEPS (64)
+#define DRAG_STEPS (64)
+#define PASTE_REPEATS (4)
+#define PACED_FRAMES (4)
+#define SMALL_SELECTION_COUNT (10.f)
+#define PAN_FRAMES (32)
+#define PAN_STEP (160.f)
+#define FIT_FRAMES (16)
+#define EVENTS_PER_FRAME (16)
+#define RASTER_WIDTH (3840)
+#define RASTER_HEIGHT (2160)
+#define RASTER_FRAMES (4)
+#define RASTER_BITMAPS (64)
+#define FNV_OFFSET_BASIS (0xCBF29CE484222325ull)
+#define FNV_PRIME (0x100000001B3ull)
+#define SCENE_PATH "CanvasBench.canvas"
+#define RECORDS_PATH "CanvasBench.records"
+
+static std::atomic<size_t> sLiveBytes(0);
+static std::atomic<uint64_t> sAllocationCount(0);
+static std::atomic<uint64_t> sFreeCount(0);
+static volatile size_t sHitSink = 0;
+
+void* operator new(size_t size)
+{
+	size_t* block = static_cast<size_t*>(malloc(size + sizeof(max_align_t)));
+
+	if (block == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	*block = size;
+	sLiveBytes += size;
+	++sAllocationCount;
+
+	return reinterpret_cast<uint8_t*>(block) + sizeof(max_align_t);
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	size_t* block = reinterpret_cast<size_t*>(static_cast<uint8_t*>(memory) - sizeof(max_align_t));
+	sLiveBytes -= *block;
+	++sFreeCount;
+	free(block);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+namespace canvas
+{
+	class Benchmark final
+	{
+	public:
+		Benchmark(size_t count);
+		~Benchmark() = default;
+		Benchmark(const Benchmark& other) = delete;
+		Benchmark& operator=(const Benchmark& rhs) = delete;
+
+		void Run();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Record
+		{
+			RectF rect;
+			ColorF lineColor;
+			ColorF backgroundColor;
+			float strokeWidth;
+		};
+
+		struct Sample
+		{
+			Clock::time_point time;
+			uint64_t cycles;
+			uint64_t allocations;
+			uint64_t frees;
+		};
+
+		void build();
+		void benchHitTest(const char* name);
+		void benchKernels();
+		void benchPan();
+		void benchFit();
+		void benchMarquee();
+		void benchMove(const char* name, const char* commitName);
+		void benchMultiResize();
+		void benchCopyPaste();
+		void benchDuplicate();
+		void benchDelete();
+		void benchReorder();
+
+		void benchSave();
+		void benchSaveAsync();
+		void benchUndo();
+		void benchPacedDrag();
+		void benchSmallDrag(const char* layerName, const char* name);
+		void benchRaster();
+		void benchLoad(size_t count);
+		void selectLarge();
+		void clickEmpty();
+		Sample start() const;
+		void report(const char* name, const Sample& begin, size_t ops, size_t objectsPerOp);
+
+		inline static uint64_t readCycles();
+
+	private:
+		size_t mCount;
+		float mWorldSize;
+		std::mt19937 mRandom;
+		Scene* mScene;
+		CpuRenderBackend mBackend;
+	};
+
+	Benchmark::Benchmark(size_t count)
+		: mCount(count)
+		, mWorldSize(sqrtf(static_cast<float>(count)) * AREA_PER_OBJECT)
+		, mRandom(static_cast<uint32_t>(count))
+		, mScene(nullptr)
+		, mBackend(VIEWPORT_WIDTH, VIEWPORT_HEIGHT)
+	{
+	}
+
+	void Benchmark::Run()
+	{
+		const size_t BYTES_BEFORE = sLiveBytes;
+		const Sample BEGIN = start();
+
+		mScene = new Scene(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+		build();
+
+		report("build", BEGIN, mCount, 1);
+		printf("%10zu  %-14s %12.1f bytes/object\n", mCount, "memory",
+			static_cast<double>(sLiveBytes - BYTES_BEFORE) / mCount);
+
+		mScene->Render(mBackend);
+
+		benchHitTest("hit-test");
+
+		Profiler::Enable();
+		benchHitTest("hit-profiled");
+		Profiler::Disable();
+		Profiler::Reset();
+
+		benchKernels();
+		benchPan();
+		benchFit();
+		benchSmallDrag("layer-small", "drag-small");
+		benchMarquee();
+		benchMove("move", "move-commit");
+		benchMultiResize();
+		benchCopyPaste();
+		benchDuplicate();
+		benchDelete();
+
+		selectLarge();
+		benchReorder();
+		benchCopyPaste();
+		benchDuplicate();
+		benchDelete();
+
+		const size_t SAVED_COUNT = mScene->GetObjects().GetCount();
+		benchSave();
+
+		selectLarge();
+		benchSaveAsync();
+		benchUndo();
+		benchPacedDrag();
+		benchRaster();
+
+		const Sample DESTROY_BEGIN = start();
+		delete mScene;
+		mScene = nullptr;
+		report("destroy", DESTROY_BEGIN, 1, mCount);
+
+		benchLoad(SAVED_COUNT);
+
+		remove(SCENE_PATH);
+		remove(RECORDS_PATH);
+	}
+
+	void Benchmark::benchSave()
+	{
+		const Sample BEGIN = start();
+
+		if (!mScene->Save(SCENE_PATH))
+		{
+			printf("failed to save %s\n", SCENE_PATH);
+			return;
+		}
+
+		report("save", BEGIN, 1, mScene->GetObjects().GetCount());
+
+		const ObjectStore& objects = mScene->GetObjects();
+		FILE* file = fopen(RECORDS_PATH, "wb");
+
+		if (file == nullptr)
+		{
+			printf("failed to write %s\n", RECORDS_PATH);
+			return;
+		}
+
+		for (size_t i = 0; i < objects.GetCount(); ++i)
+		{
+			const Record RECORD = { objects.GetRect(i), objects.GetLineColor(i), objects.GetBackgroundColor(i), objects.GetStrokeWidth(i) };
+			fwrite(&RECORD, sizeof(RECORD), 1, file);
+		}
+
+		fclose(file);
+	}
+
+	// The snapshot is the only part of the save paid on the calling thread;
+	// the selection is dragged while the worker is still writing.
+	void Benchmark::benchSaveAsync()
+	{
+		const size_t COUNT = mScene->GetObjects().GetCount();
+		const Sample BEGIN = start();
+
+		if (!mScene->SaveAsync(SCENE_PATH, nullptr))
+		{
+			printf("failed to start saving %s\n", SCENE_PATH);
+			return;
+		}
+
+		report("snapshot", BEGIN, 1, COUNT);
+
+		benchMove("move-saving", "commit-saving");
+
+		while (mScene->IsSaving())
+		{
+			std::this_thread::yield();
+		}
+
+		report("save-async", BEGIN, 1, COUNT);
+	}
+
+	// Undoes and redoes the last drag, which moved the whole selection.
+	void Benchmark::benchUndo()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		Sample begin = start();
+
+		if (!mScene->Undo())
+		{
+			printf("nothing to undo\n");
+			return;
+		}
+
+		report("undo-move", begin, 1, SELECTED);
+
+		begin = start();
+		mScene->Redo();
+		report("redo-move", begin, 1, SELECTED);
+
+		mScene->Render(mBackend);
+	}
+
+	// A 1000 Hz mouse dragging the selection over 60 Hz frames, applying every
+	// report against one coalesced move per frame.
+	void Benchmark::benchPacedDrag()
+	{
+		const RectF& boundary = mScene->GetSelectionBoundary();
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		float x = (boundary.left + boundary.right) / 2;
+		float y = (boundary.top + boundary.bottom) / 2;
+
+		mScene->MouseDown(x, y);
+
+		Sample begin = start();
+
+		for (int frame = 0; frame < PACED_FRAMES; ++frame)
+		{
+			for (int i = 0; i < EVENTS_PER_FRAME; ++i)
+			{
+				x += 1.f;
+				mScene->MouseMove(x, y);
+			}
+
+			mScene->Render(mBackend);
+		}
+
+		report("drag-raw", begin, PACED_FRAMES, SELECTED);
+
+		InputQueue input;
+		begin = start();
+
+		for (int frame = 0; frame < PACED_FRAMES; ++frame)
+		{
+			for (int i = 0; i < EVENTS_PER_FRAME; ++i)
+			{
+				x += 1.f;
+				input.Push(eInputType::MouseMove, x, y, Clock::now());
+			}
+
+			input.Apply(*mScene);
+			mScene->Render(mBackend);
+		}
+
+		report("drag-paced", begin, PACED_FRAMES, SELECTED);
+
+		mScene->MouseUp();
+		mScene->Render(mBackend);
+	}
+
+	// Draws every object onto a 4K target with 1 to N raster threads. Each
+	// thread count must reproduce the single-threaded pixels exactly.
+	// About ten objects near the origin dragged across the view at the current
+	// zoom, drawing a frame per step, so the cost should not depend on what is
+	// around them.
+	void Benchmark::benchSmallDrag(const char* layerName, const char* name)
+	{
+		const Camera& camera = mScene->GetCamera();
+		const float SIDE = sqrtf(SMALL_SELECTION_COUNT) * AREA_PER_OBJECT * camera.GetZoom();
+		const float ORIGIN = -2 * OBJECT_MARGIN;
+
+		clickEmpty();
+		mScene->MouseDown(ORIGIN, ORIGIN);
+		mScene->MouseMove(SIDE, SIDE);
+		mScene->MouseUp();
+		mScene->Render(mBackend);
+
+		const RectF BOUNDARY = camera.ToScreen(mScene->GetSelectionBoundary());
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		float x = (BOUNDARY.left + BOUNDARY.right) / 2;
+		float y = (BOUNDARY.top + BOUNDARY.bottom) / 2;
+
+		mScene->MouseDown(x, y);
+
+		// The first frame of a drag also draws everything else into the static layer.
+		Sample begin = start();
+
+		x += 8.f;
+		y += 4.f;
+		mScene->MouseMove(x, y);
+		mScene->Render(mBackend);
+
+		report(layerName, begin, 1, mScene->GetObjects().GetCount() - SELECTED);
+
+		begin = start();
+
+		for (int i = 1; i < DRAG_STEPS; ++i)
+		{
+			x += 8.f;
+			y += 4.f;
+			mScene->MouseMove(x, y);
+			mScene->Render(mBackend);
+		}
+
+		report(name, begin, DRAG_STEPS - 1, SELECTED);
+
+		mScene->MouseUp();
+		mScene->Render(mBackend);
+	}
+
+	void Benchmark::benchRaster()
+	{
+		const ObjectStore& objects = mScene->GetObjects();
+		const size_t MAX_THREADS = (std::max)(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(4));
+		uint64_t referenceHash = 0;
+
+		// LOD tiles drawn at the scales a zoomed out view uses, on fractional
+		// positions, so tile seams land inside scaled bitmaps.
+		std::vector<uint32_t> bitmap(static_cast<size_t>(LOD_TILE_SIZE) * LOD_TILE_SIZE);
+		std::vector<RectF> bitmapRects(RASTER_BITMAPS);
+		std::uniform_real_distribution<float> bitmapX(-LOD_TILE_SIZE, RASTER_WIDTH);
+		std::uniform_real_distribution<float> bitmapY(-LOD_TILE_SIZE, RASTER_HEIGHT);
+		std::uniform_real_distribution<float> bitmapScale(0.5f, 2.f);
+
+		for (size_t i = 0; i < bitmap.size(); ++i)
+		{
+			bitmap[i] = static_cast<uint32_t>(i * 2654435761u) | 0xFF000000u;
+		}
+
+		for (RectF& rect : bitmapRects)
+		{
+			const float LEFT = bitmapX(mRandom);
+			const float TOP = bitmapY(mRandom);
+			const float SIZE = LOD_TILE_SIZE * bitmapScale(mRandom);
+
+			rect = { LEFT, TOP, LEFT + SIZE, TOP + SIZE };
+		}
+
+		for (size_t threadsCount = 1; threadsCount <= MAX_THREADS; threadsCount *= 2)
+		{
+			CpuRenderBackend backend(RASTER_WIDTH, RASTER_HEIGHT, threadsCount);
+			const Sample BEGIN = start();
+
+			for (int frame = 0; frame < RASTER_FRAMES; ++frame)
+			{
+				backend.BeginFrame();
+				backend.Clear(MakeColor(0xFFFFFF, 1.f));
+
+				for (size_t i = 0; i < objects.GetCount(); ++i)
+				{
+					backend.FillRect(objects.GetRect(i), objects.GetBackgroundColor(i));
+					backend.StrokeRect(objects.GetRect(i), objects.GetLineColor(i), objects.GetStrokeWidth(i));
+				}
+
+				for (const RectF& rect : bitmapRects)
+				{
+					backend.DrawBitmap(rect, bitmap.data(), LOD_TILE_SIZE, LOD_TILE_SIZE, LOD_TILE_SIZE);
+				}
+
+				backend.EndFrame();
+			}
+
+			char name[32];
+			snprintf(name, sizeof(name), "raster-%zut", threadsCount);
+			report(name, BEGIN, RASTER_FRAMES, mCount);
+
+			uint64_t hash = FNV_OFFSET_BASIS;
+
+			for (uint32_t pixel : backend.GetPixels())
+			{
+				hash = (hash ^ pixel) * FNV_PRIME;
+			}
+
+			if (threadsCount == 1)
+			{
+				referenceHash = hash;
+			}
+			else if (hash != referenceHash)
+			{
+				printf("%10zu  %-14s pixels differ from raster-1t\n", mCount, name);
+			}
+		}
+	}
+
+	void Benchmark::benchLoad(size_t count)
+	{
+		Sample begin = start();
+		mScene = new Scene(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+
+		if (!mScene->Load(SCENE_PATH) || mScene->GetObjects().GetCount() != count)
+		{
+			printf("failed to load %s\n", SCENE_PATH);
+		}
+
+		report("load", begin, 1, count);
+
+		delete mScene;
+		mScene = nullptr;
+
+		// Baseline: one fread and one AddObject per record.
+		begin = start();
+		FILE* file = fopen(RECORDS_PATH, "rb");
+
+		if (file == nullptr)
+		{
+			printf("failed to open %s, skipping load-naive\n", RECORDS_PATH);
+			return;
+		}
+
+		mScene = new Scene(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+		Record record;
+
+		while (fread(&record, sizeof(record), 1, file) == 1)
+		{
+			mScene->AddObject(record.rect, record.lineColor, record.backgroundColor, record.strokeWidth);
+		}
+
+		fclose(file);
+		report("load-naive", begin, 1, count);
+
+		delete mScene;
+		mScene = nullptr;
+	}
+
+	void Benchmark::build()
+	{
+		std::uniform_real_distribution<float> position(0.f, mWorldSize);
+		std::uniform_real_distribution<float> extent(5.f, 40.f);
+		std::uniform_int_distribution<int> filled(0, 3);
+
+		for (size_t i = 0; i < mCount; ++i)
+		{
+			const float LEFT = position(mRandom);
+			const float TOP = position(mRandom);
+			const RectF rect = { LEFT, TOP, LEFT + extent(mRandom), TOP + extent(mRandom) };
+
+			mScene->AddObject(rect, MakeColor(0x000000, 1.f), MakeColor(0x6495ED, filled(mRandom) == 0 ? 1.f : 0.f), DEFAULT_STROKE_WIDTH);
+		}
+	}
+
+	void Benchmark::benchHitTest(const char* name)
+	{
+		std::uniform_real_distribution<float> position(0.f, mWorldSize);
+		std::vector<PointF> points(HIT_TEST_COUNT);
+
+		for (PointF& point : points)
+		{
+			point = { position(mRandom), position(mRandom) };
+		}
+
+		size_t hits = 0;
+		const Sample BEGIN = start();
+
+		for (const PointF& point : points)
+		{
+			hits += mScene->GetObjectOnCursor(point.x, point.y) != INVALID_OBJECT_HANDLE;
+		}
+
+		report(name, BEGIN, HIT_TEST_COUNT, 1);
+		sHitSink = hits;
+	}
+
+	// Each kernel over the whole store at every SIMD level the CPU has, sized
+	// so every row tests about the same number of rects.
+	void Benchmark::benchKernels()
+	{
+		static const char* const CONTAINED_NAMES[] = { "contain-scalar", "contain-sse2", "contain-avx2" };
+		static const char* const HIT_TEST_NAMES[] = { "hit-scalar", "hit-sse2", "hit-avx2" };
+
+		const ObjectStore& objects = mScene->GetObjects();
+		const size_t COUNT = objects.GetCount();
+		const size_t PASSES = (std::max)(KERNEL_RECTS / COUNT, static_cast<size_t>(1));
+		const eSimdLevel MAX_LEVEL = RectKernels::GetSimdLevel();
+		const RectF AREA = { mWorldSize / 4, mWorldSize / 4, mWorldSize * 3 / 4, mWorldSize * 3 / 4 };
+		std::uniform_real_distribution<float> position(0.f, mWorldSize);
+		std::vector<uint8_t> mask(COUNT);
+
+		auto reportRects = [this, COUNT, PASSES](const char* name, Clock::time_point begin)
+		{
+			const double SECONDS = std::chrono::duration<double>(Clock::now() - begin).count();
+
+			printf("%10zu  %-14s %12.1f Mrects/s\n", mCount, name, static_cast<double>(COUNT) * PASSES / SECONDS / 1e6);
+		};
+
+		for (int level = 0; level <= static_cast<int>(MAX_LEVEL); ++level)
+		{
+			RectKernels::SetSimdLevel(static_cast<eSimdLevel>(level));
+
+			Clock::time_point begin = Clock::now();
+
+			for (size_t i = 0; i < PASSES; ++i)
+			{
+				RectKernels::ContainedInArea(objects.GetLefts(), objects.GetTops(), objects.GetRights(), objects.GetBottoms(),
+					COUNT, AREA, mask.data());
+			}
+
+			reportRects(CONTAINED_NAMES[level], begin);
+
+			const float X = position(mRandom);
+			const float Y = position(mRandom);
+			begin = Clock::now();
+
+			for (size_t i = 0; i < PASSES; ++i)
+			{
+				RectKernels::HitTest(objects.GetLefts(), objects.GetTops(), objects.GetRights(), objects.GetBottoms(),
+					COUNT, X, Y, OBJECT_MARGIN, mask.data());
+			}
+
+			reportRects(HIT_TEST_NAMES[level], begin);
+		}
+
+		RectKernels::SetSimdLevel(MAX_LEVEL);
+		sHitSink = mask[0];
+	}
+
+	// Every frame after a pan is a full one, so its cost follows what is in
+	// view rather than the size of the document.
+	void Benchmark::benchPan()
+	{
+		size_t drawn = 0;
+		const Sample BEGIN = start();
+
+		for (int i = 0; i < PAN_FRAMES; ++i)
+		{
+			mScene->Pan(-PAN_STEP, -PAN_STEP / 2);
+			mScene->Render(mBackend);
+			drawn += mScene->GetRenderStats().objectsRedrawn;
+		}
+
+		report("pan", BEGIN, PAN_FRAMES, (std::max)(drawn / PAN_FRAMES, static_cast<size_t>(1)));
+
+		mScene->ResetCamera();
+		mScene->Render(mBackend);
+	}
+
+	// Zoomed out to the whole world, or to half the LOD threshold if that is
+	// further in. Full frames are drawn object by object, then from tiles once
+	// the pyramid has been built in the background.
+	void Benchmark::benchFit()
+	{
+		const RectF VIEWPORT = { 0.f, 0.f, static_cast<float>(VIEWPORT_WIDTH), static_cast<float>(VIEWPORT_HEIGHT) };
+		size_t drawn = 0;
+
+		mScene->SetLodThreshold(0.f);
+		mScene->Zoom((std::min)(VIEWPORT_HEIGHT / mWorldSize, LOD_ZOOM_THRESHOLD / 2), 0.f, 0.f);
+
+		Sample begin = start();
+
+		for (int i = 0; i < FIT_FRAMES; ++i)
+		{
+			mScene->Invalidate(VIEWPORT);
+			mScene->Render(mBackend);
+			drawn += mScene->GetRenderStats().objectsRedrawn;
+		}
+
+		report("fit-direct", begin, FIT_FRAMES, (std::max)(drawn / FIT_FRAMES, static_cast<size_t>(1)));
+
+		mScene->SetLodThreshold(LOD_ZOOM_THRESHOLD);
+		begin = start();
+
+		do
+		{
+			std::this_thread::yield();
+			mScene->Render(mBackend);
+		} while (mScene->GetTilePyramid().IsBuilding() || mScene->GetTilePyramid().HasRequests());
+
+		mScene->Render(mBackend);
+		report("lod-build", begin, 1, mScene->GetTilePyramid().GetTilesCount());
+
+		begin = start();
+
+		for (int i = 0; i < FIT_FRAMES; ++i)
+		{
+			mScene->Invalidate(VIEWPORT);
+			mScene->Render(mBackend);
+		}
+
+		report("fit-lod", begin, FIT_FRAMES, mScene->GetTilePyramid().GetTilesCount());
+
+		benchSmallDrag("layer-fit", "drag-fit");
+
+		// Dropping the threshold drops the tiles; the default comes back after.
+		mScene->SetLodThreshold(0.f);
+		mScene->SetLodThreshold(LOD_ZOOM_THRESHOLD);
+		mScene->ResetCamera();
+		mScene->Render(mBackend);
+	}
+
+	void Benchmark::benchMarquee()
+	{
+		// Starts outside the world so the press never lands on an object, and sweeps
+		// a tenth of it on each side, selecting about one percent of the objects.
+		const float SIDE = mWorldSize / 10;
+		const float ORIGIN = -2 * OBJECT_MARGIN;
+
+		clickEmpty();
+		mScene->MouseDown(ORIGIN, ORIGIN);
+
+		const Sample BEGIN = start();
+
+		for (int i = 1; i <= MARQUEE_STEPS; ++i)
+		{
+			const float STEP = SIDE * i / MARQUEE_STEPS;
+			mScene->MouseMove(STEP, STEP);
+		}
+
+		report("marquee", BEGIN, MARQUEE_STEPS, 1);
+
+		mScene->MouseUp();
+		mScene->Render(mBackend);
+	}
+
+	// Moves only update the pending transform; the objects take it on mouse up.
+	void Benchmark::benchMove(const char* name, const char* commitName)
+	{
+		const RectF& boundary = mScene->GetSelectionBoundary();
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		float x = (boundary.left + boundary.right) / 2;
+		float y = (boundary.top + boundary.bottom) / 2;
+
+		mScene->MouseDown(x, y);
+
+		const Sample BEGIN = start();
+
+		for (int i = 0; i < DRAG_STEPS; ++i)
+		{
+			x += 1.f;
+			y += 1.f;
+			mScene->MouseMove(x, y);
+		}
+
+		report(name, BEGIN, DRAG_STEPS, SELECTED);
+
+		const Sample COMMIT_BEGIN = start();
+		mScene->MouseUp();
+		report(commitName, COMMIT_BEGIN, 1, SELECTED);
+
+		mScene->Render(mBackend);
+	}
+
+	void Benchmark::benchMultiResize()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED < 2)
+		{
+			return;
+		}
+
+		float x = mScene->GetSelectionBoundary().right;
+		float y = mScene->GetSelectionBoundary().bottom;
+
+		mScene->MouseDown(x, y);
+
+		if (mScene->GetMode() != eMouseMode::Resize)
+		{
+			mScene->MouseUp();
+			return;
+		}
+
+		const Sample BEGIN = start();
+
+		for (int i = 0; i < DRAG_STEPS; ++i)
+		{
+			x += 1.f;
+			y += 1.f;
+			mScene->MouseMove(x, y);
+		}
+
+		report("multi-resize", BEGIN, DRAG_STEPS, SELECTED);
+
+		const Sample COMMIT_BEGIN = start();
+		mScene->MouseUp();
+		report("resize-commit", COMMIT_BEGIN, 1, SELECTED);
+
+		mScene->Render(mBackend);
+	}
+
+	void Benchmark::benchCopyPaste()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		Sample begin = start();
+		mScene->CopySelectedObjects();
+		report("copy", begin, 1, SELECTED);
+
+		// Several pastes, so the one-off column growth past the initial capacity
+		// is amortised the way it is in a session.
+		begin = start();
+
+		for (int i = 1; i <= PASTE_REPEATS; ++i)
+		{
+			mScene->PasteCopiedObjects(mWorldSize * i / (PASTE_REPEATS + 1), mWorldSize / 4);
+		}
+
+		report("paste", begin, PASTE_REPEATS, SELECTED);
+	}
+
+	void Benchmark::benchDuplicate()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		const Sample BEGIN = start();
+		mScene->DuplicateSelectedObjects();
+		report("duplicate", BEGIN, 1, SELECTED);
+	}
+
+	void Benchmark::benchDelete()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		const Sample BEGIN = start();
+		mScene->RemoveSelectedObjects();
+		report("delete", BEGIN, 1, SELECTED);
+	}
+
+	void Benchmark::benchReorder()
+	{
+		const size_t SELECTED = mScene->GetSelection().GetCount();
+
+		if (SELECTED == 0)
+		{
+			return;
+		}
+
+		Sample begin = start();
+		mScene->BringToFront();
+		report("to-front", begin, 1, SELECTED);
+
+		begin = start();
+		mScene->SendToBack();
+		report("to-back", begin, 1, SELECTED);
+
+		begin = start();
+		mScene->BringForward();
+		report("forward", begin, 1, SELECTED);
+
+		begin = start();
+		mScene->SendBackward();
+		report("backward", begin, 1, SELECTED);
+
+		mScene->Render(mBackend);
+	}
+
+	void Benchmark::selectLarge()
+	{
+		// A third of the world on each side, about a tenth of the objects.
+		const float SIDE = mWorldSize / 3;
+		const float ORIGIN = -2 * OBJECT_MARGIN;
+
+		clickEmpty();
+		mScene->MouseDown(ORIGIN, ORIGIN);
+		mScene->MouseMove(SIDE, SIDE);
+		mScene->MouseUp();
+		mScene->Render(mBackend);
+
+		printf("%10zu  %-14s %12zu objects\n", mCount, "select-large", mScene->GetSelection().GetCount());
+	}
+
+	void Benchmark::clickEmpty()
+	{
+		mScene->SetMode(eMouseMode::Select);
+		mScene->MouseDown(-mWorldSize, -mWorldSize);
+		mScene->MouseUp();
+	}
+
+	Benchmark::Sample Benchmark::start() const
+	{
+		return { Clock::now(), readCycles(), sAllocationCount, sFreeCount };
+	}
+
+	void Benchmark::report(const char* name, const Sample& begin, size_t ops, size_t objectsPerOp)
+	{
+		const uint64_t CYCLES = readCycles() - begin.cycles;
+		const uint64_t ALLOCATIONS = sAllocationCount - begin.allocations;
+		const uint64_t FREES = sFreeCount - begin.frees;
+		const double NS = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin.time).count());
+
+		printf("%10zu  %-14s %12.1f ns/op %12.2f ns/object %14.1f cycles/op %10.2f allocs/op %10.2f frees/op %10zu ops\n",
+			mCount, name, NS / ops, NS / ops / objectsPerOp, static_cast<double>(CYCLES) / ops,
+			static_cast<double>(ALLOCATIONS) / ops, static_cast<double>(FREES) / ops, ops);
+	}
+
+	inline uint64_t Benchmark::readCycles()
+	{
+#ifdef CANVAS_X86
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t maxCount = 10000000;
+
+	if (argc > 1)
+	{
+		maxCount = static_cast<size_t>(strtoull(argv[1], nullptr, 10));
+	}
+
+	for (size_t count = 1000; count <= maxCount; count *= 10)
+	{
+		canvas::Benchmark benchmark(count);
+		benchmark.Run();
+	}
+
+	return 0;
+}
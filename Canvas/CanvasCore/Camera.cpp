@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "Camera.h"
+
+namespace canvas
+{
+	Camera::Camera()
+		: mOffset{ 0.f, 0.f }
+		, mZoom(1.f)
+	{
+	}
+
+	// x and y are in screen pixels, so the world moves with the cursor at any zoom.
+	bool Camera::Pan(float x, float y)
+	{
+		if (x == 0.f && y == 0.f)
+		{
+			return false;
+		}
+
+		mOffset.x -= x / mZoom;
+		mOffset.y -= y / mZoom;
+
+		return true;
+	}
+
+	// Keeps the world point under the screen point x, y where it is.
+	bool Camera::Zoom(float factor, float x, float y)
+	{
+		const float ZOOM = (std::min)((std::max)(mZoom * factor, CAMERA_MIN_ZOOM), CAMERA_MAX_ZOOM);
+
+		if (ZOOM == mZoom)
+		{
+			return false;
+		}
+
+		const PointF ANCHOR = ToWorld(x, y);
+
+		mZoom = ZOOM;
+		mOffset.x = ANCHOR.x - x / mZoom;
+		mOffset.y = ANCHOR.y - y / mZoom;
+
+		return true;
+	}
+
+	void Camera::Reset()
+	{
+		mOffset = { 0.f, 0.f };
+		mZoom = 1.f;
+	}
+}
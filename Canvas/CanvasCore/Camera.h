@@ -0,0 +1,64 @@
+#pragma once
+
+namespace canvas
+{
+	// Maps the world, where objects live, to window pixels:
+	// screen = (world - offset) * zoom.
+	class Camera final
+	{
+	public:
+		Camera();
+		~Camera() = default;
+		Camera(const Camera& other) = delete;
+		Camera& operator=(const Camera& rhs) = delete;
+
+		bool Pan(float x, float y);
+		bool Zoom(float factor, float x, float y);
+		void Reset();
+
+		inline float GetZoom() const;
+		inline const PointF& GetOffset() const;
+		inline PointF ToWorld(float x, float y) const;
+		inline RectF ToWorld(const RectF& rect) const;
+		inline RectF ToScreen(const RectF& rect) const;
+
+	private:
+		PointF mOffset;
+		float mZoom;
+	};
+
+	inline float Camera::GetZoom() const
+	{
+		return mZoom;
+	}
+
+	inline const PointF& Camera::GetOffset() const
+	{
+		return mOffset;
+	}
+
+	inline PointF Camera::ToWorld(float x, float y) const
+	{
+		return { x / mZoom + mOffset.x, y / mZoom + mOffset.y };
+	}
+
+	inline RectF Camera::ToWorld(const RectF& rect) const
+	{
+		return {
+			rect.left / mZoom + mOffset.x,
+			rect.top / mZoom + mOffset.y,
+			rect.right / mZoom + mOffset.x,
+			rect.bottom / mZoom + mOffset.y
+		};
+	}
+
+	inline RectF Camera::ToScreen(const RectF& rect) const
+	{
+		return {
+			(rect.left - mOffset.x) * mZoom,
+			(rect.top - mOffset.y) * mZoom,
+			(rect.right - mOffset.x) * mZoom,
+			(rect.bottom - mOffset.y) * mZoom
+		};
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CANVAS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CANVAS_BIG_ENDIAN
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+#define DEFAULT_OBJECT_CAPACITY (256)
+#define OBJECT_MARGIN (10)
+#define SELECTED_RECT_MARGIN (5)
+#define NONE_POINT (-10.f)
+#define RESIZING_RECTS_COUNT (8)
+#define RESIZING_RECT_SIZE (4)
+#define DEFAULT_STROKE_WIDTH (1)
+#define GRID_CELL_SIZE (64.f)
+#define MAX_DIRTY_RECTS_COUNT (8)
+#define DAMAGE_MARGIN (1.f)
+#define CHROME_OBJECTS_COUNT (RESIZING_RECTS_COUNT + 3)
+#define DRAW_ORDER_CELL_SIZE (64.f)
+#define CAMERA_MIN_ZOOM (1.f / 64)
+#define CAMERA_MAX_ZOOM (64.f)
+#define CULL_SORT_RATIO (8)
+#define SLAB_SIZE (64 * 1024)
+#define SLAB_SIZE_CLASS_COUNT (9)
+#define SLAB_MIN_BLOCK_SIZE (static_cast<size_t>(16))
+#define SLAB_MAX_BLOCK_SIZE (SLAB_MIN_BLOCK_SIZE << (SLAB_SIZE_CLASS_COUNT - 1))
+#define GRID_CELL_INITIAL_CAPACITY (4)
+#define SCENE_FILE_MAGIC (0x53564E43u)
+#define SCENE_FILE_VERSION (1)
+#define SCENE_FILE_HEADER_SIZE (24)
+#define SCENE_FILE_COLUMN_SIZE (16)
+#define SCENE_FILE_ALIGNMENT (64)
+#define INPUT_FILE_MAGIC (0x4E495643u)
+#define INPUT_FILE_VERSION (2)
+#define INPUT_FILE_HEADER_SIZE (24)
+#define SNAPSHOT_PAGE_SIZE (static_cast<size_t>(4096))
+#define UNDO_JOURNAL_BUDGET (static_cast<size_t>(128) * 1024 * 1024)
+#define UNDO_JOURNAL_INITIAL_CAPACITY (static_cast<size_t>(64) * 1024)
+#define UNDO_JOURNAL_ALIGNMENT (static_cast<size_t>(16))
+#define Z_KEY_ORIGIN (static_cast<uint64_t>(1) << 63)
+#define Z_KEY_SPACING (static_cast<uint64_t>(1) << 32)
+#define Z_KEY_STEP (static_cast<uint64_t>(1) << 16)
+#define HDR_SUB_BUCKET_BITS (7)
+#define HDR_SUB_BUCKET_COUNT (1 << HDR_SUB_BUCKET_BITS)
+#define HDR_BUCKETS_COUNT (HDR_SUB_BUCKET_COUNT + (64 - HDR_SUB_BUCKET_BITS) * (HDR_SUB_BUCKET_COUNT / 2))
+#define PROFILER_OVERLAY_LINE_HEIGHT (16.f)
+#define PROFILER_OVERLAY_WIDTH (460.f)
+#define PROFILER_LABEL_LENGTH (128)
+#define TRACE_RING_CAPACITY (static_cast<uint64_t>(1) << 16)
+#define CPU_TILE_SIZE (64)
+#define PARALLEL_MIN_CHUNK_SIZE (static_cast<size_t>(8192))
+#define GRID_BULK_MAX_CELLS_PER_OBJECT (16)
+#define GRID_BULK_BAND_OBJECTS (4096)
+#define LOD_ZOOM_THRESHOLD (0.25f)
+#define LOD_TILE_SIZE (256)
+#define LOD_MAX_LEVEL (15)
+#define LOD_MAX_TILES (static_cast<size_t>(256))
+#define LOD_TILE_COORD_MASK ((static_cast<uint64_t>(1) << 28) - 1)
+
+#define SET_NONE_RECT(object)	object->mRect.left = NONE_POINT;\
+								object->mRect.top = NONE_POINT;\
+								object->mRect.right = NONE_POINT;\
+								object->mRect.bottom = NONE_POINT;\
+
+#define ADD_MARGIN_TO_RECT(rect, margin)	rect.left -= margin;\
+											rect.top -= margin;\
+											rect.right += margin;\
+											rect.bottom += margin;\
+
+#ifdef _DEBUG
+#ifdef _MSC_VER
+#define DEBUG_BREAK(expression) \
+if (!(expression))\
+{\
+    __debugbreak();\
+}
+#else
+#define DEBUG_BREAK(expression) \
+if (!(expression))\
+{\
+    __builtin_trap();\
+}
+#endif
+#else
+#define DEBUG_BREAK(expression)
+#endif
+
+namespace canvas
+{
+	struct PointF
+	{
+		float x;
+		float y;
+	};
+
+	struct RectF
+	{
+		float left;
+		float top;
+		float right;
+		float bottom;
+	};
+
+	struct ColorF
+	{
+		float r;
+		float g;
+		float b;
+		float a;
+	};
+
+	inline ColorF MakeColor(uint32_t rgb, float alpha)
+	{
+		return {
+			static_cast<float>((rgb >> 16) & 0xFF) / 255.f,
+			static_cast<float>((rgb >> 8) & 0xFF) / 255.f,
+			static_cast<float>(rgb & 0xFF) / 255.f,
+			alpha
+		};
+	}
+}
+
+enum class eMouseMode
+{
+	Select,
+	Selected,
+	Resize,
+	Rect,
+};
+
+enum class eResizingDirection
+{
+	NorthWest,
+	North,
+	NorthEast,
+	West,
+	East,
+	SouthWest,
+	South,
+	SouthEast,
+
+	None
+};
+
+enum class eCursor
+{
+	Unchanged,
+	Arrow,
+	Cross,
+	SizeAll,
+	SizeNWSE,
+	SizeNESW,
+	SizeNS,
+	SizeWE,
+};
+
+struct ObjectInfo
+{
+	float leftFromCenter;
+	float topFromCenter;
+	float width;
+	float height;
+	canvas::ColorF lineColor;
+	canvas::ColorF backgroundColor;
+	float strokeWidth;
+};
+
+struct RenderStats
+{
+	uint32_t dirtyRectsCount;
+	uint32_t objectsRedrawn;
+	uint64_t pixelsRedrawn;
+	uint32_t commandsCount;
+	uint32_t batchesCount;
+	uint32_t stateChangesCount;
+};
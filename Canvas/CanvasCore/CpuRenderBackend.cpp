@@ -0,0 +1,375 @@
+#include "pch.h"
+#include "CpuRenderBackend.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	CpuRenderBackend::CpuRenderBackend(uint32_t width, uint32_t height, size_t threadsCount)
+		: mWidth(0)
+		, mHeight(0)
+		, mPool(threadsCount > 1 ? std::make_unique<WorkStealingPool>(threadsCount) : nullptr)
+		, mTilesX(0)
+		, mTilesY(0)
+	{
+		Resize(width, height);
+	}
+
+	void CpuRenderBackend::Resize(uint32_t width, uint32_t height)
+	{
+		mWidth = width;
+		mHeight = height;
+		mPixels.assign(static_cast<size_t>(width) * height, 0);
+		mClipStack.clear();
+		mOps.clear();
+		mBitmaps.clear();
+
+		mTilesX = (width + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+		mTilesY = (height + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+		mTileOps.resize(mPool == nullptr ? 0 : static_cast<size_t>(mTilesX) * mTilesY);
+	}
+
+	void CpuRenderBackend::BeginFrame()
+	{
+		mClipStack.clear();
+		mClipStack.push_back({ 0, 0, static_cast<int>(mWidth), static_cast<int>(mHeight) });
+	}
+
+	bool CpuRenderBackend::EndFrame()
+	{
+		DEBUG_BREAK(mClipStack.size() == 1);
+
+		mClipStack.clear();
+
+		if (!mOps.empty())
+		{
+			binOps();
+			mPool->Run(mTileOps.size(), [this](size_t tile) { rasterizeTile(tile); });
+			mOps.clear();
+			mBitmaps.clear();
+		}
+
+		return true;
+	}
+
+	void CpuRenderBackend::Clear(const ColorF& color)
+	{
+		drawRect(mClipStack.back(), packColor(color), true);
+	}
+
+	void CpuRenderBackend::PushClip(const RectF& rect)
+	{
+		const PixelRect& top = mClipStack.back();
+		PixelRect clip = toPixelRect(rect.left, rect.top, rect.right, rect.bottom);
+
+		clip.left = (std::max)(clip.left, top.left);
+		clip.top = (std::max)(clip.top, top.top);
+		clip.right = (std::max)((std::min)(clip.right, top.right), clip.left);
+		clip.bottom = (std::max)((std::min)(clip.bottom, top.bottom), clip.top);
+
+		mClipStack.push_back(clip);
+	}
+
+	void CpuRenderBackend::PopClip()
+	{
+		DEBUG_BREAK(mClipStack.size() > 1);
+
+		mClipStack.pop_back();
+	}
+
+	void CpuRenderBackend::FillRect(const RectF& rect, const ColorF& color)
+	{
+		const uint32_t PACKED = packColor(color);
+
+		if ((PACKED >> 24) == 0)
+		{
+			return;
+		}
+
+		drawRect(toPixelRect(rect.left, rect.top, rect.right, rect.bottom), PACKED, false);
+	}
+
+	void CpuRenderBackend::StrokeRect(const RectF& rect, const ColorF& color, float strokeWidth)
+	{
+		const uint32_t PACKED = packColor(color);
+
+		if ((PACKED >> 24) == 0 || strokeWidth <= 0.f)
+		{
+			return;
+		}
+
+		const float HALF = strokeWidth / 2;
+		const float LEFT = (std::min)(rect.left, rect.right);
+		const float TOP = (std::min)(rect.top, rect.bottom);
+		const float RIGHT = (std::max)(rect.left, rect.right);
+		const float BOTTOM = (std::max)(rect.top, rect.bottom);
+
+		// The stroke is centred on the outline, so it covers the outer rect minus the inner one.
+		// Both are snapped first and the ring is split into four disjoint bands, so no pixel blends twice.
+		const PixelRect OUTER = toPixelRect(LEFT - HALF, TOP - HALF, RIGHT + HALF, BOTTOM + HALF);
+
+		if (LEFT + HALF >= RIGHT - HALF || TOP + HALF >= BOTTOM - HALF)
+		{
+			drawRect(OUTER, PACKED, false);
+			return;
+		}
+
+		PixelRect inner = toPixelRect(LEFT + HALF, TOP + HALF, RIGHT - HALF, BOTTOM - HALF);
+
+		if (inner.left >= inner.right || inner.top >= inner.bottom)
+		{
+			drawRect(OUTER, PACKED, false);
+			return;
+		}
+
+		inner.left = (std::max)(inner.left, OUTER.left);
+		inner.top = (std::max)(inner.top, OUTER.top);
+		inner.right = (std::min)(inner.right, OUTER.right);
+		inner.bottom = (std::min)(inner.bottom, OUTER.bottom);
+
+		drawRect({ OUTER.left, OUTER.top, OUTER.right, inner.top }, PACKED, false);
+		drawRect({ OUTER.left, inner.bottom, OUTER.right, OUTER.bottom }, PACKED, false);
+		drawRect({ OUTER.left, inner.top, inner.left, inner.bottom }, PACKED, false);
+		drawRect({ inner.right, inner.top, OUTER.right, inner.bottom }, PACKED, false);
+	}
+
+	void CpuRenderBackend::FillRects(const RectF* rects, size_t count, const ColorF& color)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			FillRect(rects[i], color);
+		}
+	}
+
+	void CpuRenderBackend::StrokeRects(const RectF* rects, size_t count, const ColorF& color, float strokeWidth)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			StrokeRect(rects[i], color, strokeWidth);
+		}
+	}
+
+	// There is no font here; labels only matter on screen.
+	void CpuRenderBackend::DrawLabel(const RectF&, const char*, const ColorF&)
+	{
+	}
+
+	// Nearest neighbour, replacing what is under it.
+	void CpuRenderBackend::DrawBitmap(const RectF& rect, const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t stride)
+	{
+		const PixelRect& clip = mClipStack.back();
+		const PixelRect RECT = toPixelRect(rect.left, rect.top, rect.right, rect.bottom);
+		const PixelRect CLIPPED = {
+			(std::max)(RECT.left, clip.left),
+			(std::max)(RECT.top, clip.top),
+			(std::min)(RECT.right, clip.right),
+			(std::min)(RECT.bottom, clip.bottom)
+		};
+
+		if (CLIPPED.left >= CLIPPED.right || CLIPPED.top >= CLIPPED.bottom || width == 0 || height == 0)
+		{
+			return;
+		}
+
+		const Bitmap BITMAP = {
+			pixels,
+			width,
+			height,
+			stride,
+			(std::min)(rect.left, rect.right),
+			(std::min)(rect.top, rect.bottom),
+			width / fabsf(rect.right - rect.left),
+			height / fabsf(rect.bottom - rect.top)
+		};
+
+		if (mPool != nullptr)
+		{
+			mOps.push_back({ CLIPPED, 0, static_cast<uint32_t>(mBitmaps.size()), true });
+			mBitmaps.push_back(BITMAP);
+		}
+		else
+		{
+			copyPixels(CLIPPED, BITMAP);
+		}
+	}
+
+	CpuRenderBackend::PixelRect CpuRenderBackend::toPixelRect(float left, float top, float right, float bottom) const
+	{
+		// A pixel is covered when its centre lies in [left, right) x [top, bottom), the same rule aliased D2D uses.
+		return {
+			static_cast<int>(ceilf((std::min)(left, right) - 0.5f)),
+			static_cast<int>(ceilf((std::min)(top, bottom) - 0.5f)),
+			static_cast<int>(ceilf((std::max)(left, right) - 0.5f)),
+			static_cast<int>(ceilf((std::max)(top, bottom) - 0.5f))
+		};
+	}
+
+	void CpuRenderBackend::drawRect(const PixelRect& rect, uint32_t color, bool bReplace)
+	{
+		const PixelRect& clip = mClipStack.back();
+		const PixelRect CLIPPED = {
+			(std::max)(rect.left, clip.left),
+			(std::max)(rect.top, clip.top),
+			(std::min)(rect.right, clip.right),
+			(std::min)(rect.bottom, clip.bottom)
+		};
+
+		if (CLIPPED.left >= CLIPPED.right || CLIPPED.top >= CLIPPED.bottom)
+		{
+			return;
+		}
+
+		if (mPool != nullptr)
+		{
+			mOps.push_back({ CLIPPED, color, UINT32_MAX, bReplace });
+		}
+		else if (bReplace || (color >> 24) == 255)
+		{
+			fillPixels(CLIPPED, color);
+		}
+		else
+		{
+			blendPixels(CLIPPED, color);
+		}
+	}
+
+	// Op indices go into every tile an op touches, in draw order.
+	void CpuRenderBackend::binOps()
+	{
+		for (std::vector<uint32_t>& tileOps : mTileOps)
+		{
+			tileOps.clear();
+		}
+
+		for (uint32_t i = 0; i < mOps.size(); ++i)
+		{
+			const PixelRect& rect = mOps[i].rect;
+			const uint32_t LEFT = static_cast<uint32_t>(rect.left) / CPU_TILE_SIZE;
+			const uint32_t TOP = static_cast<uint32_t>(rect.top) / CPU_TILE_SIZE;
+			const uint32_t RIGHT = static_cast<uint32_t>(rect.right - 1) / CPU_TILE_SIZE;
+			const uint32_t BOTTOM = static_cast<uint32_t>(rect.bottom - 1) / CPU_TILE_SIZE;
+
+			for (uint32_t y = TOP; y <= BOTTOM; ++y)
+			{
+				for (uint32_t x = LEFT; x <= RIGHT; ++x)
+				{
+					mTileOps[static_cast<size_t>(y) * mTilesX + x].push_back(i);
+				}
+			}
+		}
+	}
+
+	void CpuRenderBackend::rasterizeTile(size_t tile)
+	{
+		const std::vector<uint32_t>& tileOps = mTileOps[tile];
+
+		if (tileOps.empty())
+		{
+			return;
+		}
+
+		TraceScope scope("tile");
+
+		const int LEFT = static_cast<int>(tile % mTilesX) * CPU_TILE_SIZE;
+		const int TOP = static_cast<int>(tile / mTilesX) * CPU_TILE_SIZE;
+		const int RIGHT = (std::min)(LEFT + CPU_TILE_SIZE, static_cast<int>(mWidth));
+		const int BOTTOM = (std::min)(TOP + CPU_TILE_SIZE, static_cast<int>(mHeight));
+
+		for (uint32_t index : tileOps)
+		{
+			const DrawOp& op = mOps[index];
+			const PixelRect RECT = {
+				(std::max)(op.rect.left, LEFT),
+				(std::max)(op.rect.top, TOP),
+				(std::min)(op.rect.right, RIGHT),
+				(std::min)(op.rect.bottom, BOTTOM)
+			};
+
+			if (op.bitmap != UINT32_MAX)
+			{
+				copyPixels(RECT, mBitmaps[op.bitmap]);
+			}
+			else if (op.bReplace || (op.color >> 24) == 255)
+			{
+				fillPixels(RECT, op.color);
+			}
+			else
+			{
+				blendPixels(RECT, op.color);
+			}
+		}
+	}
+
+	void CpuRenderBackend::fillPixels(const PixelRect& rect, uint32_t color)
+	{
+		for (int y = rect.top; y < rect.bottom; ++y)
+		{
+			uint32_t* row = &mPixels[static_cast<size_t>(y) * mWidth];
+			std::fill(row + rect.left, row + rect.right, color);
+		}
+	}
+
+	void CpuRenderBackend::blendPixels(const PixelRect& rect, uint32_t color)
+	{
+		const uint32_t ALPHA = color >> 24;
+		const uint32_t INV_ALPHA = 255 - ALPHA;
+		const uint32_t SRC_R = (color & 0xFF) * ALPHA;
+		const uint32_t SRC_G = ((color >> 8) & 0xFF) * ALPHA;
+		const uint32_t SRC_B = ((color >> 16) & 0xFF) * ALPHA;
+
+		for (int y = rect.top; y < rect.bottom; ++y)
+		{
+			uint32_t* row = &mPixels[static_cast<size_t>(y) * mWidth];
+
+			for (int x = rect.left; x < rect.right; ++x)
+			{
+				const uint32_t DST = row[x];
+				const uint32_t R = (SRC_R + (DST & 0xFF) * INV_ALPHA + 127) / 255;
+				const uint32_t G = (SRC_G + ((DST >> 8) & 0xFF) * INV_ALPHA + 127) / 255;
+				const uint32_t B = (SRC_B + ((DST >> 16) & 0xFF) * INV_ALPHA + 127) / 255;
+				const uint32_t A = ALPHA + ((DST >> 24) * INV_ALPHA + 127) / 255;
+
+				row[x] = R | (G << 8) | (B << 16) | (A << 24);
+			}
+		}
+	}
+
+	void CpuRenderBackend::copyPixels(const PixelRect& rect, const Bitmap& bitmap)
+	{
+		const int MAX_X = static_cast<int>(bitmap.width) - 1;
+		const int MAX_Y = static_cast<int>(bitmap.height) - 1;
+
+		// Texels come from the absolute pixel position, never from where the
+		// clip or a tile starts, so tiled and whole-frame copies agree. In
+		// double, an unscaled column is exactly FIRST_X plus the pixel offset.
+		const double FIRST_X = floor(rect.left + 0.5 - static_cast<double>(bitmap.left));
+		const bool bCopyRows = bitmap.scaleX == 1.f && FIRST_X >= 0.0 && FIRST_X + (rect.right - rect.left) <= MAX_X + 1;
+
+		for (int y = rect.top; y < rect.bottom; ++y)
+		{
+			const int SRC_Y = getTexel(y, bitmap.top, bitmap.scaleY, MAX_Y);
+			const uint32_t* src = bitmap.pixels + static_cast<size_t>(SRC_Y) * bitmap.stride;
+			uint32_t* row = &mPixels[static_cast<size_t>(y) * mWidth];
+
+			if (bCopyRows)
+			{
+				memcpy(row + rect.left, src + static_cast<int>(FIRST_X), static_cast<size_t>(rect.right - rect.left) * sizeof(uint32_t));
+				continue;
+			}
+
+			for (int x = rect.left; x < rect.right; ++x)
+			{
+				row[x] = src[getTexel(x, bitmap.left, bitmap.scaleX, MAX_X)];
+			}
+		}
+	}
+
+	uint32_t CpuRenderBackend::packColor(const ColorF& color)
+	{
+		auto toByte = [](float value) -> uint32_t
+		{
+			return static_cast<uint32_t>((std::min)((std::max)(value, 0.f), 1.f) * 255.f + 0.5f);
+		};
+
+		return toByte(color.r) | (toByte(color.g) << 8) | (toByte(color.b) << 16) | (toByte(color.a) << 24);
+	}
+}
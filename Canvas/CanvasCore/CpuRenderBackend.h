@@ -0,0 +1,129 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "WorkStealingPool.h"
+
+namespace canvas
+{
+	// Rasterizes into a 32-bit RGBA buffer. With more than one thread, draws
+	// are recorded, binned into tiles and rasterized tile by tile in parallel
+	// at EndFrame. Every pixel still sees its draws in order, so the pixels
+	// match the single-threaded ones exactly.
+	class CpuRenderBackend final : public RenderBackend
+	{
+	public:
+		CpuRenderBackend(uint32_t width, uint32_t height, size_t threadsCount = 1);
+		~CpuRenderBackend() = default;
+		CpuRenderBackend(const CpuRenderBackend& other) = delete;
+		CpuRenderBackend& operator=(const CpuRenderBackend& rhs) = delete;
+
+		void Resize(uint32_t width, uint32_t height);
+
+		void BeginFrame() override;
+		bool EndFrame() override;
+
+		void Clear(const ColorF& color) override;
+		void PushClip(const RectF& rect) override;
+		void PopClip() override;
+
+		void FillRect(const RectF& rect, const ColorF& color) override;
+		void StrokeRect(const RectF& rect, const ColorF& color, float strokeWidth) override;
+		void FillRects(const RectF* rects, size_t count, const ColorF& color) override;
+		void StrokeRects(const RectF* rects, size_t count, const ColorF& color, float strokeWidth) override;
+		void DrawLabel(const RectF& rect, const char* text, const ColorF& color) override;
+		void DrawBitmap(const RectF& rect, const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t stride) override;
+
+		inline uint32_t GetWidth() const;
+		inline uint32_t GetHeight() const;
+		inline uint32_t GetPixel(uint32_t x, uint32_t y) const;
+		inline const std::vector<uint32_t>& GetPixels() const;
+		inline size_t GetThreadsCount() const;
+
+	private:
+		struct PixelRect
+		{
+			int left;
+			int top;
+			int right;
+			int bottom;
+		};
+
+		// Where a bitmap lands: pixel x maps to column floor((x + 0.5 - left) * scaleX).
+		struct Bitmap
+		{
+			const uint32_t* pixels;
+			uint32_t width;
+			uint32_t height;
+			uint32_t stride;
+			float left;
+			float top;
+			float scaleX;
+			float scaleY;
+		};
+
+		// A clipped rect that either replaces or blends over its pixels,
+		// or copies mBitmaps[bitmap] into them.
+		struct DrawOp
+		{
+			PixelRect rect;
+			uint32_t color;
+			uint32_t bitmap;
+			bool bReplace;
+		};
+
+		PixelRect toPixelRect(float left, float top, float right, float bottom) const;
+		void drawRect(const PixelRect& rect, uint32_t color, bool bReplace);
+		void binOps();
+		void rasterizeTile(size_t tile);
+		void fillPixels(const PixelRect& rect, uint32_t color);
+		void blendPixels(const PixelRect& rect, uint32_t color);
+		void copyPixels(const PixelRect& rect, const Bitmap& bitmap);
+		inline static int getTexel(int pixel, float origin, float scale, int maxTexel);
+		static uint32_t packColor(const ColorF& color);
+
+	private:
+		uint32_t mWidth;
+		uint32_t mHeight;
+		std::vector<uint32_t> mPixels;
+		std::vector<PixelRect> mClipStack;
+
+		std::unique_ptr<WorkStealingPool> mPool;
+		std::vector<DrawOp> mOps;
+		std::vector<Bitmap> mBitmaps;
+		std::vector<std::vector<uint32_t>> mTileOps;
+		uint32_t mTilesX;
+		uint32_t mTilesY;
+	};
+
+	inline uint32_t CpuRenderBackend::GetWidth() const
+	{
+		return mWidth;
+	}
+
+	inline uint32_t CpuRenderBackend::GetHeight() const
+	{
+		return mHeight;
+	}
+
+	inline uint32_t CpuRenderBackend::GetPixel(uint32_t x, uint32_t y) const
+	{
+		return mPixels[static_cast<size_t>(y) * mWidth + x];
+	}
+
+	inline int CpuRenderBackend::getTexel(int pixel, float origin, float scale, int maxTexel)
+	{
+		const double TEXEL = (pixel + 0.5 - static_cast<double>(origin)) * scale;
+
+		return static_cast<int>((std::min)((std::max)(TEXEL, 0.0), static_cast<double>(maxTexel)));
+	}
+
+	inline const std::vector<uint32_t>& CpuRenderBackend::GetPixels() const
+	{
+		return mPixels;
+	}
+
+	inline size_t CpuRenderBackend::GetThreadsCount() const
+	{
+		return mPool == nullptr ? 1 : mPool->GetThreadsCount();
+	}
+}
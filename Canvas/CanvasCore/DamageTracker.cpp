@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "DamageTracker.h"
+
+namespace canvas
+{
+	DamageTracker::DamageTracker()
+		: mbFull(true)
+	{
+		mRects.reserve(MAX_DIRTY_RECTS_COUNT + 1);
+	}
+
+	void DamageTracker::Add(const RectF& rect, float margin)
+	{
+		if (mbFull || (rect.left == NONE_POINT && rect.right == NONE_POINT))
+		{
+			return;
+		}
+
+		// Snap outwards to whole pixels so the aliased clip covers every touched pixel.
+		RectF dirty = {
+			floorf((std::min)(rect.left, rect.right) - margin),
+			floorf((std::min)(rect.top, rect.bottom) - margin),
+			ceilf((std::max)(rect.left, rect.right) + margin),
+			ceilf((std::max)(rect.top, rect.bottom) + margin)
+		};
+
+		for (size_t i = 0; i < mRects.size();)
+		{
+			if (isOverlapped(mRects[i], dirty))
+			{
+				dirty = getUnion(mRects[i], dirty);
+				mRects[i] = mRects.back();
+				mRects.pop_back();
+				i = 0;
+				continue;
+			}
+
+			++i;
+		}
+
+		mRects.push_back(dirty);
+
+		if (mRects.size() > MAX_DIRTY_RECTS_COUNT)
+		{
+			mergeClosestPair();
+		}
+	}
+
+	void DamageTracker::AddAll()
+	{
+		mbFull = true;
+		mRects.clear();
+	}
+
+	void DamageTracker::Reset()
+	{
+		mbFull = false;
+		mRects.clear();
+	}
+
+	void DamageTracker::mergeClosestPair()
+	{
+		size_t bestLhs = 0;
+		size_t bestRhs = 1;
+		float bestCost = FLT_MAX;
+
+		for (size_t i = 0; i < mRects.size(); ++i)
+		{
+			for (size_t j = i + 1; j < mRects.size(); ++j)
+			{
+				const float COST = getArea(getUnion(mRects[i], mRects[j])) - getArea(mRects[i]) - getArea(mRects[j]);
+
+				if (COST < bestCost)
+				{
+					bestCost = COST;
+					bestLhs = i;
+					bestRhs = j;
+				}
+			}
+		}
+
+		mRects[bestLhs] = getUnion(mRects[bestLhs], mRects[bestRhs]);
+		mRects[bestRhs] = mRects.back();
+		mRects.pop_back();
+	}
+}
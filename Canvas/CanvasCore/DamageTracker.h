@@ -0,0 +1,67 @@
+#pragma once
+
+namespace canvas
+{
+	class DamageTracker final
+	{
+	public:
+		DamageTracker();
+		~DamageTracker() = default;
+		DamageTracker(const DamageTracker& other) = delete;
+		DamageTracker& operator=(const DamageTracker& rhs) = delete;
+
+		void Add(const RectF& rect, float margin);
+		void AddAll();
+		void Reset();
+
+		inline bool IsEmpty() const;
+		inline bool IsFull() const;
+		inline const std::vector<RectF>& GetRects() const;
+
+	private:
+		void mergeClosestPair();
+
+		inline static float getArea(const RectF& rect);
+		inline static RectF getUnion(const RectF& lhs, const RectF& rhs);
+		inline static bool isOverlapped(const RectF& lhs, const RectF& rhs);
+
+	private:
+		std::vector<RectF> mRects;
+		bool mbFull;
+	};
+
+	inline bool DamageTracker::IsEmpty() const
+	{
+		return !mbFull && mRects.empty();
+	}
+
+	inline bool DamageTracker::IsFull() const
+	{
+		return mbFull;
+	}
+
+	inline const std::vector<RectF>& DamageTracker::GetRects() const
+	{
+		return mRects;
+	}
+
+	inline float DamageTracker::getArea(const RectF& rect)
+	{
+		return (rect.right - rect.left) * (rect.bottom - rect.top);
+	}
+
+	inline RectF DamageTracker::getUnion(const RectF& lhs, const RectF& rhs)
+	{
+		return {
+			(std::min)(lhs.left, rhs.left),
+			(std::min)(lhs.top, rhs.top),
+			(std::max)(lhs.right, rhs.right),
+			(std::max)(lhs.bottom, rhs.bottom)
+		};
+	}
+
+	inline bool DamageTracker::isOverlapped(const RectF& lhs, const RectF& rhs)
+	{
+		return lhs.left <= rhs.right && rhs.left <= lhs.right && lhs.top <= rhs.bottom && rhs.top <= lhs.bottom;
+	}
+}
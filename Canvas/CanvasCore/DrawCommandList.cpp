@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "DrawCommandList.h"
+
+namespace canvas
+{
+	DrawCommandList::DrawCommandList()
+		: mBounds{ 0.f, 0.f, 0.f, 0.f }
+		, mColumns(0)
+		, mRows(0)
+	{
+	}
+
+	void DrawCommandList::Reset(const RectF& bounds)
+	{
+		mBounds = bounds;
+		mColumns = (std::max)(static_cast<uint32_t>(ceilf((bounds.right - bounds.left) / DRAW_ORDER_CELL_SIZE)), 1u);
+		mRows = (std::max)(static_cast<uint32_t>(ceilf((bounds.bottom - bounds.top) / DRAW_ORDER_CELL_SIZE)), 1u);
+		mCells.assign(static_cast<size_t>(mColumns) * mRows, { 0, EMPTY_CELL_STYLE });
+
+		mCommands.clear();
+		mStyles.clear();
+		mStyleIndices.clear();
+	}
+
+	void DrawCommandList::Fill(const RectF& rect, const ColorF& color)
+	{
+		if (color.a <= 0.f)
+		{
+			return;
+		}
+
+		record(rect, { color, 0.f, eDrawOp::Fill }, 0.f);
+	}
+
+	void DrawCommandList::Stroke(const RectF& rect, const ColorF& color, float strokeWidth)
+	{
+		if (color.a <= 0.f || strokeWidth <= 0.f)
+		{
+			return;
+		}
+
+		record(rect, { color, strokeWidth, eDrawOp::Stroke }, strokeWidth / 2);
+	}
+
+	void DrawCommandList::Submit(RenderBackend& backend, RenderStats& outStats)
+	{
+		std::sort(mCommands.begin(), mCommands.end(), [](const DrawCommand& lhs, const DrawCommand& rhs)
+			{
+				if (lhs.layer != rhs.layer)
+				{
+					return lhs.layer < rhs.layer;
+				}
+
+				if (lhs.style != rhs.style)
+				{
+					return lhs.style < rhs.style;
+				}
+
+				return lhs.sequence < rhs.sequence;
+			});
+
+		const DrawStyle* prevStyle = nullptr;
+		size_t begin = 0;
+
+		while (begin < mCommands.size())
+		{
+			const DrawCommand& first = mCommands[begin];
+			const DrawStyle& style = mStyles[first.style];
+			size_t end = begin;
+
+			mBatchRects.clear();
+
+			while (end < mCommands.size() && mCommands[end].layer == first.layer && mCommands[end].style == first.style)
+			{
+				mBatchRects.push_back(mCommands[end].rect);
+				++end;
+			}
+
+			if (style.op == eDrawOp::Fill)
+			{
+				backend.FillRects(mBatchRects.data(), mBatchRects.size(), style.color);
+			}
+			else
+			{
+				backend.StrokeRects(mBatchRects.data(), mBatchRects.size(), style.color, style.strokeWidth);
+			}
+
+			if (prevStyle == nullptr || memcmp(&prevStyle->color, &style.color, sizeof(ColorF)) != 0)
+			{
+				++outStats.stateChangesCount;
+			}
+
+			++outStats.batchesCount;
+			prevStyle = &style;
+			begin = end;
+		}
+
+		outStats.commandsCount += static_cast<uint32_t>(mCommands.size());
+	}
+
+	void DrawCommandList::record(const RectF& rect, const DrawStyle& style, float margin)
+	{
+		const float LEFT = (std::min)(rect.left, rect.right) - margin;
+		const float TOP = (std::min)(rect.top, rect.bottom) - margin;
+		const float RIGHT = (std::max)(rect.left, rect.right) + margin;
+		const float BOTTOM = (std::max)(rect.top, rect.bottom) + margin;
+
+		if (RIGHT <= mBounds.left || LEFT >= mBounds.right || BOTTOM <= mBounds.top || TOP >= mBounds.bottom)
+		{
+			return;
+		}
+
+		const uint32_t STYLE = getStyleIndex(style);
+		const int MAX_COLUMN = static_cast<int>(mColumns) - 1;
+		const int MAX_ROW = static_cast<int>(mRows) - 1;
+		const int COLUMN_BEGIN = (std::max)(static_cast<int>(floorf((LEFT - mBounds.left) / DRAW_ORDER_CELL_SIZE)), 0);
+		const int COLUMN_END = (std::min)(static_cast<int>(floorf((RIGHT - mBounds.left) / DRAW_ORDER_CELL_SIZE)), MAX_COLUMN);
+		const int ROW_BEGIN = (std::max)(static_cast<int>(floorf((TOP - mBounds.top) / DRAW_ORDER_CELL_SIZE)), 0);
+		const int ROW_END = (std::min)(static_cast<int>(floorf((BOTTOM - mBounds.top) / DRAW_ORDER_CELL_SIZE)), MAX_ROW);
+
+		// A command may share a layer with the same style underneath it, but must sit above any other style
+		// it might overlap. Each cell only keeps its top layer, which is enough since lower layers are already below it.
+		uint32_t layer = 0;
+
+		for (int row = ROW_BEGIN; row <= ROW_END; ++row)
+		{
+			for (int column = COLUMN_BEGIN; column <= COLUMN_END; ++column)
+			{
+				const Cell& cell = mCells[static_cast<size_t>(row) * mColumns + column];
+
+				if (cell.style == EMPTY_CELL_STYLE)
+				{
+					continue;
+				}
+
+				layer = (std::max)(layer, cell.style == STYLE ? cell.layer : cell.layer + 1);
+			}
+		}
+
+		for (int row = ROW_BEGIN; row <= ROW_END; ++row)
+		{
+			for (int column = COLUMN_BEGIN; column <= COLUMN_END; ++column)
+			{
+				Cell& cell = mCells[static_cast<size_t>(row) * mColumns + column];
+
+				if (cell.style == EMPTY_CELL_STYLE || layer > cell.layer)
+				{
+					cell = { layer, STYLE };
+				}
+				else if (cell.style != STYLE)
+				{
+					cell.style = MIXED_CELL_STYLE;
+				}
+			}
+		}
+
+		mCommands.push_back({ rect, layer, STYLE, static_cast<uint32_t>(mCommands.size()) });
+	}
+
+	uint32_t DrawCommandList::getStyleIndex(const DrawStyle& style)
+	{
+		auto iter = mStyleIndices.find(style);
+
+		if (iter != mStyleIndices.end())
+		{
+			return iter->second;
+		}
+
+		const uint32_t INDEX = static_cast<uint32_t>(mStyles.size());
+		mStyles.push_back(style);
+		mStyleIndices.emplace(style, INDEX);
+
+		return INDEX;
+	}
+
+	size_t DrawCommandList::DrawStyleHash::operator()(const DrawStyle& style) const
+	{
+		const float VALUES[] = { style.color.r, style.color.g, style.color.b, style.color.a, style.strokeWidth };
+		size_t hash = static_cast<size_t>(style.op);
+
+		for (float value : VALUES)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			hash = hash * 31 + bits;
+		}
+
+		return hash;
+	}
+
+	bool DrawCommandList::DrawStyleEqual::operator()(const DrawStyle& lhs, const DrawStyle& rhs) const
+	{
+		return lhs.op == rhs.op
+			&& lhs.strokeWidth == rhs.strokeWidth
+			&& memcmp(&lhs.color, &rhs.color, sizeof(ColorF)) == 0;
+	}
+}
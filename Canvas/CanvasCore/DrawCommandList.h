@@ -0,0 +1,82 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+namespace canvas
+{
+	constexpr uint32_t EMPTY_CELL_STYLE = UINT32_MAX;
+	constexpr uint32_t MIXED_CELL_STYLE = UINT32_MAX - 1;
+
+	enum class eDrawOp : uint8_t
+	{
+		Fill,
+		Stroke
+	};
+
+	class DrawCommandList final
+	{
+	public:
+		DrawCommandList();
+		~DrawCommandList() = default;
+		DrawCommandList(const DrawCommandList& other) = delete;
+		DrawCommandList& operator=(const DrawCommandList& rhs) = delete;
+
+		void Reset(const RectF& bounds);
+		void Fill(const RectF& rect, const ColorF& color);
+		void Stroke(const RectF& rect, const ColorF& color, float strokeWidth);
+		void Submit(RenderBackend& backend, RenderStats& outStats);
+
+		inline size_t GetCount() const;
+
+	private:
+		struct DrawStyle
+		{
+			ColorF color;
+			float strokeWidth;
+			eDrawOp op;
+		};
+
+		struct DrawStyleHash
+		{
+			size_t operator()(const DrawStyle& style) const;
+		};
+
+		struct DrawStyleEqual
+		{
+			bool operator()(const DrawStyle& lhs, const DrawStyle& rhs) const;
+		};
+
+		struct DrawCommand
+		{
+			RectF rect;
+			uint32_t layer;
+			uint32_t style;
+			uint32_t sequence;
+		};
+
+		struct Cell
+		{
+			uint32_t layer;
+			uint32_t style;
+		};
+
+		void record(const RectF& rect, const DrawStyle& style, float margin);
+		uint32_t getStyleIndex(const DrawStyle& style);
+
+	private:
+		RectF mBounds;
+		uint32_t mColumns;
+		uint32_t mRows;
+		std::vector<Cell> mCells;
+
+		std::vector<DrawCommand> mCommands;
+		std::vector<DrawStyle> mStyles;
+		std::unordered_map<DrawStyle, uint32_t, DrawStyleHash, DrawStyleEqual> mStyleIndices;
+		std::vector<RectF> mBatchRects;
+	};
+
+	inline size_t DrawCommandList::GetCount() const
+	{
+		return mCommands.size();
+	}
+}
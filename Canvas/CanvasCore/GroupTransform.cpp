@@ -0,0 +1,33 @@
+#include "pch.h"
+#include "GroupTransform.h"
+
+namespace canvas
+{
+	GroupTransform::GroupTransform()
+		: mAnchor{ 0.f, 0.f }
+		, mScale{ 1.f, 1.f }
+		, mOffset{ 0.f, 0.f }
+	{
+	}
+
+	void GroupTransform::Reset()
+	{
+		mAnchor = { 0.f, 0.f };
+		mScale = { 1.f, 1.f };
+		mOffset = { 0.f, 0.f };
+	}
+
+	// Offsets add up, so a whole drag is one translation from where it began.
+	void GroupTransform::Translate(float x, float y)
+	{
+		mOffset.x += x;
+		mOffset.y += y;
+	}
+
+	// The scale is absolute, against the rects the drag started from.
+	void GroupTransform::SetScale(const PointF& anchor, float scaleX, float scaleY)
+	{
+		mAnchor = anchor;
+		mScale = { scaleX, scaleY };
+	}
+}
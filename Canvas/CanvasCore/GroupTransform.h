@@ -0,0 +1,63 @@
+#pragma once
+
+namespace canvas
+{
+	// The pending change to a dragged selection. Per axis a coordinate maps
+	// to anchor + (value - anchor) * scale + offset: a move only offsets and
+	// a group resize only scales about the corner that stays put.
+	class GroupTransform final
+	{
+	public:
+		GroupTransform();
+		~GroupTransform() = default;
+		GroupTransform(const GroupTransform& other) = delete;
+		GroupTransform& operator=(const GroupTransform& rhs) = delete;
+
+		void Reset();
+		void Translate(float x, float y);
+		void SetScale(const PointF& anchor, float scaleX, float scaleY);
+
+		inline bool IsIdentity() const;
+		inline bool IsTranslation() const;
+		inline const PointF& GetOffset() const;
+		inline float ApplyX(float x) const;
+		inline float ApplyY(float y) const;
+		inline RectF Apply(const RectF& rect) const;
+
+	private:
+		PointF mAnchor;
+		PointF mScale;
+		PointF mOffset;
+	};
+
+	inline bool GroupTransform::IsIdentity() const
+	{
+		return IsTranslation() && mOffset.x == 0.f && mOffset.y == 0.f;
+	}
+
+	inline bool GroupTransform::IsTranslation() const
+	{
+		return mScale.x == 1.f && mScale.y == 1.f;
+	}
+
+	inline const PointF& GroupTransform::GetOffset() const
+	{
+		return mOffset;
+	}
+
+	inline float GroupTransform::ApplyX(float x) const
+	{
+		return mAnchor.x + (x - mAnchor.x) * mScale.x + mOffset.x;
+	}
+
+	inline float GroupTransform::ApplyY(float y) const
+	{
+		return mAnchor.y + (y - mAnchor.y) * mScale.y + mOffset.y;
+	}
+
+	// A negative scale mirrors, so the result may come out flipped.
+	inline RectF GroupTransform::Apply(const RectF& rect) const
+	{
+		return { ApplyX(rect.left), ApplyY(rect.top), ApplyX(rect.right), ApplyY(rect.bottom) };
+	}
+}
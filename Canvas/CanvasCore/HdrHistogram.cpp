@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "HdrHistogram.h"
+
+namespace canvas
+{
+	HdrHistogram::HdrHistogram()
+	{
+		Clear();
+	}
+
+	void HdrHistogram::Clear()
+	{
+		memset(mCounts, 0, sizeof(mCounts));
+		mCount = 0;
+		mMax = 0;
+		mSum = 0.0;
+	}
+
+	// Reports the highest value of the bucket the percentile falls in.
+	uint64_t HdrHistogram::GetPercentile(double percentile) const
+	{
+		if (mCount == 0)
+		{
+			return 0;
+		}
+
+		const double RANK = ceil(percentile / 100.0 * static_cast<double>(mCount));
+		const uint64_t TARGET = (std::max)(static_cast<uint64_t>(RANK), static_cast<uint64_t>(1));
+		uint64_t seen = 0;
+
+		for (size_t bucket = 0; bucket < HDR_BUCKETS_COUNT; ++bucket)
+		{
+			seen += mCounts[bucket];
+
+			if (seen >= TARGET)
+			{
+				return (std::min)(getHighestValue(bucket), mMax);
+			}
+		}
+
+		return mMax;
+	}
+
+	double HdrHistogram::GetMean() const
+	{
+		return mCount > 0 ? mSum / static_cast<double>(mCount) : 0.0;
+	}
+}
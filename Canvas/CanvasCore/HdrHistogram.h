@@ -0,0 +1,93 @@
+#pragma once
+
+namespace canvas
+{
+	// Log-linear histogram over the whole uint64_t range. Each power of two is
+	// split into HDR_SUB_BUCKET_COUNT / 2 buckets, so any reported value is
+	// within 1.6% of a recorded one. Recording is a shift and an increment.
+	class HdrHistogram final
+	{
+	public:
+		HdrHistogram();
+		~HdrHistogram() = default;
+		HdrHistogram(const HdrHistogram& other) = delete;
+		HdrHistogram& operator=(const HdrHistogram& rhs) = delete;
+
+		inline void Record(uint64_t value);
+		void Clear();
+
+		uint64_t GetPercentile(double percentile) const;
+		double GetMean() const;
+
+		inline uint64_t GetCount() const;
+		inline uint64_t GetMax() const;
+
+	private:
+		inline static size_t getBucket(uint64_t value);
+		inline static uint64_t getHighestValue(size_t bucket);
+		inline static int getHighestBit(uint64_t value);
+
+	private:
+		uint32_t mCounts[HDR_BUCKETS_COUNT];
+		uint64_t mCount;
+		uint64_t mMax;
+		double mSum;
+	};
+
+	inline void HdrHistogram::Record(uint64_t value)
+	{
+		++mCounts[getBucket(value)];
+		++mCount;
+		mMax = (std::max)(mMax, value);
+		mSum += static_cast<double>(value);
+	}
+
+	inline uint64_t HdrHistogram::GetCount() const
+	{
+		return mCount;
+	}
+
+	inline uint64_t HdrHistogram::GetMax() const
+	{
+		return mMax;
+	}
+
+	inline size_t HdrHistogram::getBucket(uint64_t value)
+	{
+		if (value < HDR_SUB_BUCKET_COUNT)
+		{
+			return static_cast<size_t>(value);
+		}
+
+		const int SHIFT = getHighestBit(value) - (HDR_SUB_BUCKET_BITS - 1);
+		const size_t HALF = HDR_SUB_BUCKET_COUNT / 2;
+
+		return HDR_SUB_BUCKET_COUNT + (SHIFT - 1) * HALF + static_cast<size_t>(value >> SHIFT) - HALF;
+	}
+
+	inline uint64_t HdrHistogram::getHighestValue(size_t bucket)
+	{
+		if (bucket < HDR_SUB_BUCKET_COUNT)
+		{
+			return bucket;
+		}
+
+		const size_t HALF = HDR_SUB_BUCKET_COUNT / 2;
+		const int SHIFT = static_cast<int>((bucket - HDR_SUB_BUCKET_COUNT) / HALF) + 1;
+		const uint64_t SUB_BUCKET = (bucket - HDR_SUB_BUCKET_COUNT) % HALF + HALF;
+
+		return ((SUB_BUCKET + 1) << SHIFT) - 1;
+	}
+
+	inline int HdrHistogram::getHighestBit(uint64_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long bit;
+		_BitScanReverse64(&bit, value);
+
+		return static_cast<int>(bit);
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "InputQueue.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	InputQueue::InputQueue()
+		: mReceivedCount(0)
+	{
+	}
+
+	void InputQueue::Push(eInputType type, float x, float y, std::chrono::steady_clock::time_point time)
+	{
+		DEBUG_BREAK(type == eInputType::MouseDown || type == eInputType::MouseMove || type == eInputType::MouseUp || type == eInputType::Pan);
+
+		push({ type, x, y, 1.f }, time);
+	}
+
+	void InputQueue::PushZoom(float factor, float x, float y, std::chrono::steady_clock::time_point time)
+	{
+		push({ eInputType::Zoom, x, y, factor }, time);
+	}
+
+	// Returns the cursor asked for by the last event that changed it.
+	eCursor InputQueue::Apply(Scene& scene)
+	{
+		TraceScope scope("input");
+		eCursor cursor = eCursor::Unchanged;
+
+		for (const InputEvent& event : mEvents)
+		{
+			eCursor eventCursor = eCursor::Unchanged;
+
+			switch (event.type)
+			{
+			case eInputType::MouseDown:
+				eventCursor = scene.MouseDown(event.x, event.y);
+				break;
+			case eInputType::MouseMove:
+				eventCursor = scene.MouseMove(event.x, event.y);
+				break;
+			case eInputType::MouseUp:
+				eventCursor = scene.MouseUp();
+				break;
+			case eInputType::Pan:
+				scene.Pan(event.x, event.y);
+				break;
+			case eInputType::Zoom:
+				scene.Zoom(event.factor, event.x, event.y);
+				break;
+			default:
+				DEBUG_BREAK(false);
+				break;
+			}
+
+			if (eventCursor != eCursor::Unchanged)
+			{
+				cursor = eventCursor;
+			}
+		}
+
+		mEvents.clear();
+		mReceivedCount = 0;
+
+		return cursor;
+	}
+
+	void InputQueue::push(const InputEvent& event, std::chrono::steady_clock::time_point time)
+	{
+		if (mEvents.empty())
+		{
+			mOldestTime = time;
+		}
+
+		++mReceivedCount;
+
+		InputEvent* last = mEvents.empty() ? nullptr : &mEvents.back();
+
+		if (last != nullptr && last->type == event.type)
+		{
+			switch (event.type)
+			{
+			case eInputType::MouseMove:
+				last->x = event.x;
+				last->y = event.y;
+				return;
+			case eInputType::Pan:
+				last->x += event.x;
+				last->y += event.y;
+				return;
+			case eInputType::Zoom:
+				if (last->x == event.x && last->y == event.y)
+				{
+					last->factor *= event.factor;
+					return;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		mEvents.push_back(event);
+	}
+}
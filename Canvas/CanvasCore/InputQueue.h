@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Scene.h"
+
+namespace canvas
+{
+	// The queue only takes mouse and camera input; keys and frames appear in
+	// recordings. Pan carries a pixel offset in x and y, Zoom a factor
+	// around the cursor at x and y.
+	enum class eInputType : uint8_t
+	{
+		MouseDown,
+		MouseMove,
+		MouseUp,
+		KeyDown,
+		KeyUp,
+		Frame,
+		Pan,
+		Zoom,
+
+		Count
+	};
+
+	struct InputEvent
+	{
+		eInputType type;
+		float x;
+		float y;
+		float factor;
+	};
+
+	// Mouse input received between two frames. A run of moves collapses into
+	// its last position as it arrives, so the frame applies one move per run
+	// however fast the mouse reports. Runs of pans add up and runs of zooms
+	// around one point multiply the same way. Presses and releases keep their order.
+	class InputQueue final
+	{
+	public:
+		InputQueue();
+		~InputQueue() = default;
+		InputQueue(const InputQueue& other) = delete;
+		InputQueue& operator=(const InputQueue& rhs) = delete;
+
+		void Push(eInputType type, float x, float y, std::chrono::steady_clock::time_point time);
+		void PushZoom(float factor, float x, float y, std::chrono::steady_clock::time_point time);
+		eCursor Apply(Scene& scene);
+
+		inline bool IsEmpty() const;
+		inline size_t GetReceivedCount() const;
+		inline size_t GetPendingCount() const;
+		inline std::chrono::steady_clock::time_point GetOldestTime() const;
+
+	private:
+		void push(const InputEvent& event, std::chrono::steady_clock::time_point time);
+
+	private:
+		std::vector<InputEvent> mEvents;
+		size_t mReceivedCount;
+		std::chrono::steady_clock::time_point mOldestTime;
+	};
+
+	inline bool InputQueue::IsEmpty() const
+	{
+		return mEvents.empty();
+	}
+
+	inline size_t InputQueue::GetReceivedCount() const
+	{
+		return mReceivedCount;
+	}
+
+	inline size_t InputQueue::GetPendingCount() const
+	{
+		return mEvents.size();
+	}
+
+	inline std::chrono::steady_clock::time_point InputQueue::GetOldestTime() const
+	{
+		return mOldestTime;
+	}
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "InputRecording.h"
+#include "MappedFile.h"
+
+namespace canvas
+{
+	InputRecording::InputRecording()
+		: mbRecording(false)
+		, mWidth(0)
+		, mHeight(0)
+	{
+	}
+
+	void InputRecording::Start(uint32_t width, uint32_t height, std::chrono::steady_clock::time_point now)
+	{
+		mbRecording = true;
+		mWidth = width;
+		mHeight = height;
+		mStartTime = now;
+		mInputs.clear();
+	}
+
+	void InputRecording::Add(eInputType type, uint32_t keys, float x, float y, std::chrono::steady_clock::time_point time)
+	{
+		add({ 0, type, static_cast<uint16_t>(keys), x, y, 1.f }, time);
+	}
+
+	void InputRecording::AddZoom(float factor, float x, float y, std::chrono::steady_clock::time_point time)
+	{
+		add({ 0, eInputType::Zoom, 0, x, y, factor }, time);
+	}
+
+	bool InputRecording::Write(const char* path) const
+	{
+		static_assert(TOTAL_KEY_COUNT <= 16, "held keys are stored in 16 bits");
+
+		std::vector<uint8_t> bytes;
+		bytes.reserve(INPUT_FILE_HEADER_SIZE + mInputs.size() * 12);
+
+		storeLE(bytes, INPUT_FILE_MAGIC, 4);
+		storeLE(bytes, INPUT_FILE_VERSION, 2);
+		storeLE(bytes, 0, 2);
+		storeLE(bytes, mWidth, 4);
+		storeLE(bytes, mHeight, 4);
+		storeLE(bytes, mInputs.size(), 8);
+
+		uint64_t time = 0;
+
+		for (const RecordedInput& input : mInputs)
+		{
+			bytes.push_back(static_cast<uint8_t>(input.type));
+
+			for (uint64_t delta = input.time - time; ; delta >>= 7)
+			{
+				if (delta < 0x80)
+				{
+					bytes.push_back(static_cast<uint8_t>(delta));
+					break;
+				}
+
+				bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+			}
+
+			time = input.time;
+
+			if (isKey(input.type))
+			{
+				storeLE(bytes, input.keys, 2);
+			}
+			else if (input.type == eInputType::Zoom)
+			{
+				storeFloat(bytes, input.factor);
+			}
+
+			if (getPayloadSize(input.type) > 0)
+			{
+				storeFloat(bytes, input.x);
+				storeFloat(bytes, input.y);
+			}
+		}
+
+		FILE* file = OpenFile(path, "wb");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool bSucceeded = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+
+		return fclose(file) == 0 && bSucceeded;
+	}
+
+	bool InputRecording::Read(const char* path)
+	{
+		MappedFile file;
+		mbRecording = false;
+		mInputs.clear();
+
+		if (!file.Open(path) || file.GetSize() < INPUT_FILE_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		const uint8_t* data = file.GetData();
+		const uint8_t* end = data + file.GetSize();
+
+		const uint64_t MAGIC = loadLE(data, 4);
+		const uint64_t VERSION = loadLE(data + 4, 2);
+		const uint64_t COUNT = loadLE(data + 16, 8);
+
+		// Every input takes at least two bytes.
+		if (MAGIC != INPUT_FILE_MAGIC || VERSION == 0 || VERSION > INPUT_FILE_VERSION
+			|| COUNT > (file.GetSize() - INPUT_FILE_HEADER_SIZE) / 2)
+		{
+			return false;
+		}
+
+		mWidth = static_cast<uint32_t>(loadLE(data + 8, 4));
+		mHeight = static_cast<uint32_t>(loadLE(data + 12, 4));
+		mInputs.reserve(static_cast<size_t>(COUNT));
+
+		const uint8_t* cursor = data + INPUT_FILE_HEADER_SIZE;
+		uint64_t time = 0;
+
+		for (uint64_t i = 0; i < COUNT; ++i)
+		{
+			RecordedInput input = { 0, static_cast<eInputType>(*cursor++), 0, 0.f, 0.f, 1.f };
+
+			if (input.type >= eInputType::Count || (VERSION < 2 && input.type >= eInputType::Pan))
+			{
+				mInputs.clear();
+				return false;
+			}
+
+			uint64_t delta = 0;
+
+			for (int shift = 0; ; shift += 7)
+			{
+				if (cursor == end || shift > 63)
+				{
+					mInputs.clear();
+					return false;
+				}
+
+				const uint8_t BYTE = *cursor++;
+				delta |= static_cast<uint64_t>(BYTE & 0x7F) << shift;
+
+				if ((BYTE & 0x80) == 0)
+				{
+					break;
+				}
+			}
+
+			time += delta;
+			input.time = time;
+
+			const size_t PAYLOAD = getPayloadSize(input.type);
+
+			if (static_cast<size_t>(end - cursor) < PAYLOAD)
+			{
+				mInputs.clear();
+				return false;
+			}
+
+			if (isKey(input.type))
+			{
+				input.keys = static_cast<uint16_t>(loadLE(cursor, 2));
+				cursor += 2;
+			}
+			else if (input.type == eInputType::Zoom)
+			{
+				input.factor = loadFloat(cursor);
+				cursor += 4;
+			}
+
+			if (PAYLOAD > 0)
+			{
+				input.x = loadFloat(cursor);
+				input.y = loadFloat(cursor + 4);
+				cursor += 8;
+			}
+
+			mInputs.push_back(input);
+
+			if (cursor == end && i + 1 < COUNT)
+			{
+				mInputs.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void InputRecording::add(const RecordedInput& input, std::chrono::steady_clock::time_point time)
+	{
+		if (!mbRecording)
+		{
+			return;
+		}
+
+		const uint64_t MICROSECONDS = std::chrono::duration_cast<std::chrono::microseconds>(time - mStartTime).count();
+
+		// Keeps times ordered even if the caller's clock reads were not.
+		const uint64_t TIME = mInputs.empty() ? MICROSECONDS : (std::max)(MICROSECONDS, mInputs.back().time);
+
+		mInputs.push_back(input);
+		mInputs.back().time = TIME;
+	}
+}
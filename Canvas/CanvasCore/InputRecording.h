@@ -0,0 +1,149 @@
+#pragma once
+
+#include "InputQueue.h"
+
+namespace canvas
+{
+	struct RecordedInput
+	{
+		uint64_t time;
+		eInputType type;
+		uint16_t keys;
+		float x;
+		float y;
+		float factor;
+	};
+
+	// Input stream of one session, from an empty scene. Times are microseconds
+	// since the recording started. The file is little-endian:
+	//
+	//   header  magic "CVIN", u16 version, u16 reserved, u32 viewport width,
+	//           u32 viewport height, u64 inputs count
+	//   inputs  u8 type, varint microseconds since the previous input, then
+	//           mouse  f32 x, f32 y
+	//           pan    f32 x offset, f32 y offset
+	//           zoom   f32 factor, f32 cursor x, f32 cursor y
+	//           key    u16 held keys, f32 cursor x, f32 cursor y
+	//           frame  nothing
+	//
+	// Version 1 files have no pan or zoom inputs.
+	class InputRecording final
+	{
+	public:
+		InputRecording();
+		~InputRecording() = default;
+		InputRecording(const InputRecording& other) = delete;
+		InputRecording& operator=(const InputRecording& rhs) = delete;
+
+		void Start(uint32_t width, uint32_t height, std::chrono::steady_clock::time_point now);
+		void Add(eInputType type, uint32_t keys, float x, float y, std::chrono::steady_clock::time_point time);
+		void AddZoom(float factor, float x, float y, std::chrono::steady_clock::time_point time);
+
+		bool Write(const char* path) const;
+		bool Read(const char* path);
+
+		inline bool IsRecording() const;
+		inline uint32_t GetWidth() const;
+		inline uint32_t GetHeight() const;
+		inline const std::vector<RecordedInput>& GetInputs() const;
+
+	private:
+		void add(const RecordedInput& input, std::chrono::steady_clock::time_point time);
+
+		inline static bool isMouse(eInputType type);
+		inline static bool isKey(eInputType type);
+		inline static size_t getPayloadSize(eInputType type);
+		inline static void storeLE(std::vector<uint8_t>& out, uint64_t value, size_t bytes);
+		inline static void storeFloat(std::vector<uint8_t>& out, float value);
+		inline static uint64_t loadLE(const uint8_t* in, size_t bytes);
+		inline static float loadFloat(const uint8_t* in);
+
+	private:
+		bool mbRecording;
+		uint32_t mWidth;
+		uint32_t mHeight;
+		std::chrono::steady_clock::time_point mStartTime;
+		std::vector<RecordedInput> mInputs;
+	};
+
+	inline bool InputRecording::IsRecording() const
+	{
+		return mbRecording;
+	}
+
+	inline uint32_t InputRecording::GetWidth() const
+	{
+		return mWidth;
+	}
+
+	inline uint32_t InputRecording::GetHeight() const
+	{
+		return mHeight;
+	}
+
+	inline const std::vector<RecordedInput>& InputRecording::GetInputs() const
+	{
+		return mInputs;
+	}
+
+	inline bool InputRecording::isMouse(eInputType type)
+	{
+		return type == eInputType::MouseDown || type == eInputType::MouseMove || type == eInputType::MouseUp || type == eInputType::Pan;
+	}
+
+	inline bool InputRecording::isKey(eInputType type)
+	{
+		return type == eInputType::KeyDown || type == eInputType::KeyUp;
+	}
+
+	inline size_t InputRecording::getPayloadSize(eInputType type)
+	{
+		if (isKey(type))
+		{
+			return 10;
+		}
+
+		if (type == eInputType::Zoom)
+		{
+			return 12;
+		}
+
+		return isMouse(type) ? 8 : 0;
+	}
+
+	inline void InputRecording::storeLE(std::vector<uint8_t>& out, uint64_t value, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+		}
+	}
+
+	inline void InputRecording::storeFloat(std::vector<uint8_t>& out, float value)
+	{
+		uint32_t word;
+		memcpy(&word, &value, sizeof(word));
+		storeLE(out, word, 4);
+	}
+
+	inline uint64_t InputRecording::loadLE(const uint8_t* in, size_t bytes)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			value |= static_cast<uint64_t>(in[i]) << (i * 8);
+		}
+
+		return value;
+	}
+
+	inline float InputRecording::loadFloat(const uint8_t* in)
+	{
+		const uint32_t WORD = static_cast<uint32_t>(loadLE(in, 4));
+		float value;
+		memcpy(&value, &WORD, sizeof(value));
+
+		return value;
+	}
+}
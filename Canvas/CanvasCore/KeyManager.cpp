@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "KeyManager.h"
+
+namespace canvas
+{
+	KeyManager::KeyManager()
+		: mHeldKeys(0)
+		, mPressedKeys(0)
+		, mReleasedKeys(0)
+		, mLastKey(eKeyValue::Count)
+	{
+	}
+
+	// Returns the command bound to the chord. Autorepeat sends the held key
+	// down again, which runs its command again but is not a new edge.
+	eCommand KeyManager::KeyDown(eKeyValue key)
+	{
+		const uint32_t BIT = getBit(key);
+
+		if ((mHeldKeys & BIT) == 0)
+		{
+			mHeldKeys |= BIT;
+			mPressedKeys |= BIT;
+		}
+
+		mLastKey = key;
+
+		return FindCommand(key, mHeldKeys);
+	}
+
+	void KeyManager::KeyUp(eKeyValue key)
+	{
+		const uint32_t BIT = getBit(key);
+
+		if ((mHeldKeys & BIT) != 0)
+		{
+			mHeldKeys &= ~BIT;
+			mReleasedKeys |= BIT;
+		}
+
+		if (mLastKey == key)
+		{
+			mLastKey = eKeyValue::Count;
+		}
+	}
+
+	// For recordings, which store the held set after each key event. Keys
+	// that appear go down modifiers first; an unchanged set repeats the last key.
+	eCommand KeyManager::SetHeldKeys(uint32_t keys)
+	{
+		const uint32_t MODIFIER_KEYS = getBit(eKeyValue::Shift) | getBit(eKeyValue::Ctrl);
+		const uint32_t RELEASED = mHeldKeys & ~keys;
+		const uint32_t PRESSED = keys & ~mHeldKeys;
+		eCommand command = eCommand::None;
+
+		for (int i = 0; i < TOTAL_KEY_COUNT; ++i)
+		{
+			if ((RELEASED & (1u << i)) != 0)
+			{
+				KeyUp(static_cast<eKeyValue>(i));
+			}
+		}
+
+		for (int i = 0; i < TOTAL_KEY_COUNT; ++i)
+		{
+			if ((PRESSED & MODIFIER_KEYS & (1u << i)) != 0)
+			{
+				KeyDown(static_cast<eKeyValue>(i));
+			}
+		}
+
+		for (int i = 0; i < TOTAL_KEY_COUNT; ++i)
+		{
+			if ((PRESSED & ~MODIFIER_KEYS & (1u << i)) != 0)
+			{
+				const eCommand COMMAND = KeyDown(static_cast<eKeyValue>(i));
+				command = COMMAND != eCommand::None ? COMMAND : command;
+			}
+		}
+
+		if (RELEASED == 0 && PRESSED == 0 && mLastKey != eKeyValue::Count)
+		{
+			command = KeyDown(mLastKey);
+		}
+
+		return command;
+	}
+
+	// Key ups are lost while another window has the focus.
+	void KeyManager::Reset()
+	{
+		mReleasedKeys |= mHeldKeys;
+		mHeldKeys = 0;
+		mLastKey = eKeyValue::Count;
+	}
+
+	void KeyManager::EndFrame()
+	{
+		mPressedKeys = 0;
+		mReleasedKeys = 0;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Shortcuts.h"
+
+namespace canvas
+{
+	// Held keys as one bit per eKeyValue, kept from key events instead of
+	// polling the system. Pressed and released hold the edges since the last
+	// EndFrame.
+	class KeyManager final
+	{
+	public:
+		KeyManager();
+		~KeyManager() = default;
+		KeyManager(const KeyManager& other) = delete;
+		KeyManager& operator=(const KeyManager& rhs) = delete;
+
+		eCommand KeyDown(eKeyValue key);
+		void KeyUp(eKeyValue key);
+		eCommand SetHeldKeys(uint32_t keys);
+		void Reset();
+		void EndFrame();
+
+		inline uint32_t GetHeldKeys() const;
+		inline uint32_t GetPressedKeys() const;
+		inline uint32_t GetReleasedKeys() const;
+		inline bool IsKeyHeld(eKeyValue key) const;
+		inline bool WasKeyPressed(eKeyValue key) const;
+		inline bool WasKeyReleased(eKeyValue key) const;
+
+	private:
+		inline static uint32_t getBit(eKeyValue key);
+
+	private:
+		uint32_t mHeldKeys;
+		uint32_t mPressedKeys;
+		uint32_t mReleasedKeys;
+		eKeyValue mLastKey;
+	};
+
+	inline uint32_t KeyManager::GetHeldKeys() const
+	{
+		return mHeldKeys;
+	}
+
+	inline uint32_t KeyManager::GetPressedKeys() const
+	{
+		return mPressedKeys;
+	}
+
+	inline uint32_t KeyManager::GetReleasedKeys() const
+	{
+		return mReleasedKeys;
+	}
+
+	inline bool KeyManager::IsKeyHeld(eKeyValue key) const
+	{
+		return IsKeyInSet(mHeldKeys, key);
+	}
+
+	inline bool KeyManager::WasKeyPressed(eKeyValue key) const
+	{
+		return IsKeyInSet(mPressedKeys, key);
+	}
+
+	inline bool KeyManager::WasKeyReleased(eKeyValue key) const
+	{
+		return IsKeyInSet(mReleasedKeys, key);
+	}
+
+	inline uint32_t KeyManager::getBit(eKeyValue key)
+	{
+		DEBUG_BREAK(static_cast<int>(key) > -1);
+		DEBUG_BREAK(static_cast<int>(key) < TOTAL_KEY_COUNT);
+
+		return 1u << static_cast<int>(key);
+	}
+}
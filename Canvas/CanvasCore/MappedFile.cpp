@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace canvas
+{
+#ifdef _WIN32
+	namespace
+	{
+		bool widen(const char* text, std::vector<wchar_t>& outText)
+		{
+			const int LENGTH = MultiByteToWideChar(CP_UTF8, 0, text, -1, nullptr, 0);
+
+			if (LENGTH == 0)
+			{
+				return false;
+			}
+
+			outText.resize(LENGTH);
+			MultiByteToWideChar(CP_UTF8, 0, text, -1, outText.data(), LENGTH);
+
+			return true;
+		}
+	}
+
+	FILE* OpenFile(const char* path, const char* mode)
+	{
+		std::vector<wchar_t> widePath;
+		std::vector<wchar_t> wideMode;
+
+		if (!widen(path, widePath) || !widen(mode, wideMode))
+		{
+			return nullptr;
+		}
+
+		return _wfopen(widePath.data(), wideMode.data());
+	}
+
+	bool SeekFile(FILE* file, uint64_t offset)
+	{
+		return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+	}
+
+	bool SyncFile(FILE* file)
+	{
+		return _commit(_fileno(file)) == 0;
+	}
+
+	bool RenameFile(const char* from, const char* to)
+	{
+		std::vector<wchar_t> wideFrom;
+		std::vector<wchar_t> wideTo;
+
+		return widen(from, wideFrom) && widen(to, wideTo)
+			&& MoveFileExW(wideFrom.data(), wideTo.data(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+
+	bool RemoveFile(const char* path)
+	{
+		std::vector<wchar_t> widePath;
+
+		return widen(path, widePath) && _wremove(widePath.data()) == 0;
+	}
+#else
+	FILE* OpenFile(const char* path, const char* mode)
+	{
+		return fopen(path, mode);
+	}
+
+	bool SeekFile(FILE* file, uint64_t offset)
+	{
+		return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+	}
+
+	bool SyncFile(FILE* file)
+	{
+		return fsync(fileno(file)) == 0;
+	}
+
+	// The directory entry is synced too, so the new name survives a crash.
+	bool RenameFile(const char* from, const char* to)
+	{
+		if (rename(from, to) != 0)
+		{
+			return false;
+		}
+
+		const char* slash = strrchr(to, '/');
+		const std::string DIRECTORY = slash == nullptr ? std::string(".") : std::string(to, slash == to ? 1 : slash - to);
+		int fd = open(DIRECTORY.c_str(), O_RDONLY);
+
+		if (fd >= 0)
+		{
+			fsync(fd);
+			close(fd);
+		}
+
+		return true;
+	}
+
+	bool RemoveFile(const char* path)
+	{
+		return remove(path) == 0;
+	}
+#endif
+
+	MappedFile::MappedFile()
+		: mData(nullptr)
+		, mSize(0)
+#ifdef _WIN32
+		, mFile(INVALID_HANDLE_VALUE)
+		, mMapping(nullptr)
+#endif
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+		std::vector<wchar_t> widePath;
+
+		if (!widen(path, widePath))
+		{
+			return false;
+		}
+
+		mFile = CreateFileW(widePath.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		LARGE_INTEGER size;
+
+		if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mMapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (mData == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		mSize = static_cast<size_t>(size.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+		{
+			UnmapViewOfFile(mData);
+		}
+
+		if (mMapping != nullptr)
+		{
+			CloseHandle(mMapping);
+		}
+
+		if (mFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(mFile);
+		}
+
+		mData = nullptr;
+		mSize = 0;
+		mFile = INVALID_HANDLE_VALUE;
+		mMapping = nullptr;
+	}
+#else
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+		int fd = open(path, O_RDONLY);
+
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+
+		if (fstat(fd, &info) != 0 || info.st_size <= 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (data == MAP_FAILED)
+		{
+			return false;
+		}
+
+		madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(info.st_size);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+
+		mData = nullptr;
+		mSize = 0;
+	}
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace canvas
+{
+	FILE* OpenFile(const char* path, const char* mode);
+	bool SeekFile(FILE* file, uint64_t offset);
+	bool SyncFile(FILE* file);
+	bool RenameFile(const char* from, const char* to);
+	bool RemoveFile(const char* path);
+
+	// Read-only view of a whole file. Paths are UTF-8.
+	class MappedFile final
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& rhs) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		inline const uint8_t* GetData() const;
+		inline size_t GetSize() const;
+
+	private:
+		const uint8_t* mData;
+		size_t mSize;
+#ifdef _WIN32
+		void* mFile;
+		void* mMapping;
+#endif
+	};
+
+	inline const uint8_t* MappedFile::GetData() const
+	{
+		return mData;
+	}
+
+	inline size_t MappedFile::GetSize() const
+	{
+		return mSize;
+	}
+}
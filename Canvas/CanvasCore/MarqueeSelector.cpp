@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "MarqueeSelector.h"
+#include "RectKernels.h"
+#include "Profiler.h"
+
+namespace canvas
+{
+	MarqueeSelector::MarqueeSelector()
+		: mbActive(false)
+		, mbHasArea(false)
+		, mArea{ NONE_POINT, NONE_POINT, NONE_POINT, NONE_POINT }
+		, mVisitStamp(0)
+	{
+	}
+
+	void MarqueeSelector::Begin(const ObjectStore& objects)
+	{
+		DEBUG_BREAK(!mbActive);
+
+		const size_t COUNT = objects.GetCount();
+
+		sortEdges(objects.GetLefts(), COUNT, mEdges[EDGE_LEFT]);
+		sortEdges(objects.GetTops(), COUNT, mEdges[EDGE_TOP]);
+		sortEdges(objects.GetRights(), COUNT, mEdges[EDGE_RIGHT]);
+		sortEdges(objects.GetBottoms(), COUNT, mEdges[EDGE_BOTTOM]);
+
+		mContained.assign(COUNT, 0);
+		mVisitStamps.assign(COUNT, 0);
+		mVisitStamp = 0;
+
+		mbActive = true;
+		mbHasArea = false;
+	}
+
+	void MarqueeSelector::Update(const ObjectStore& objects, const RectF& area, std::vector<uint32_t>& outChanged)
+	{
+		DEBUG_BREAK(mbActive);
+		DEBUG_BREAK(objects.GetCount() == mContained.size());
+
+		outChanged.clear();
+
+		if (!mbHasArea)
+		{
+			RectKernels::ContainedInArea(objects.GetLefts(), objects.GetTops(), objects.GetRights(), objects.GetBottoms(),
+				mContained.size(), area, mContained.data());
+			Profiler::Count(eProfileCounter::ObjectsScanned, mContained.size());
+
+			for (uint32_t i = 0; i < mContained.size(); ++i)
+			{
+				if (mContained[i])
+				{
+					outChanged.push_back(i);
+				}
+			}
+
+			mArea = area;
+			mbHasArea = true;
+
+			return;
+		}
+
+		// An object can only change containment if one of its edges lies in the band
+		// swept by the matching marquee edge: left/top are tested with >=, right/bottom with <=.
+		if (++mVisitStamp == 0)
+		{
+			mVisitStamps.assign(mVisitStamps.size(), 0);
+			mVisitStamp = 1;
+		}
+
+		mCandidates.clear();
+		collectInRange(mEdges[EDGE_LEFT], mArea.left, area.left, true, mCandidates);
+		collectInRange(mEdges[EDGE_TOP], mArea.top, area.top, true, mCandidates);
+		collectInRange(mEdges[EDGE_RIGHT], mArea.right, area.right, false, mCandidates);
+		collectInRange(mEdges[EDGE_BOTTOM], mArea.bottom, area.bottom, false, mCandidates);
+
+		const float* lefts = objects.GetLefts();
+		const float* tops = objects.GetTops();
+		const float* rights = objects.GetRights();
+		const float* bottoms = objects.GetBottoms();
+
+		Profiler::Count(eProfileCounter::ObjectsScanned, mCandidates.size());
+
+		for (uint32_t index : mCandidates)
+		{
+			const uint8_t CONTAINED = lefts[index] >= area.left && rights[index] <= area.right
+				&& tops[index] >= area.top && bottoms[index] <= area.bottom;
+
+			if (CONTAINED != mContained[index])
+			{
+				mContained[index] = CONTAINED;
+				outChanged.push_back(index);
+			}
+		}
+
+		mArea = area;
+	}
+
+	void MarqueeSelector::End()
+	{
+		mbActive = false;
+		mbHasArea = false;
+	}
+
+	void MarqueeSelector::sortEdges(const float* edges, size_t count, SortedEdges& out)
+	{
+		mSortBuffer.resize(count);
+		mSortScratch.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			mSortBuffer[i] = (static_cast<uint64_t>(toSortableKey(edges[i])) << 32) | static_cast<uint32_t>(i);
+		}
+
+		// LSD radix sort on the 32-bit key half; four 8-bit passes keep Begin linear in the scene size.
+		for (int shift = 32; shift < 64; shift += 8)
+		{
+			size_t offsets[257] = { 0 };
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				++offsets[((mSortBuffer[i] >> shift) & 0xFF) + 1];
+			}
+
+			for (size_t i = 1; i < 257; ++i)
+			{
+				offsets[i] += offsets[i - 1];
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				mSortScratch[offsets[(mSortBuffer[i] >> shift) & 0xFF]++] = mSortBuffer[i];
+			}
+
+			mSortBuffer.swap(mSortScratch);
+		}
+
+		out.keys.resize(count);
+		out.indices.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t INDEX = static_cast<uint32_t>(mSortBuffer[i]);
+
+			out.keys[i] = edges[INDEX];
+			out.indices[i] = INDEX;
+		}
+	}
+
+	void MarqueeSelector::collectInRange(const SortedEdges& edges, float low, float high, bool bLowInclusive, std::vector<uint32_t>& outCandidates)
+	{
+		if (low == high)
+		{
+			return;
+		}
+
+		if (low > high)
+		{
+			const float temp = low;
+			low = high;
+			high = temp;
+		}
+
+		// [low, high) for left/top edges, (low, high] for right/bottom edges.
+		auto first = bLowInclusive
+			? std::lower_bound(edges.keys.begin(), edges.keys.end(), low)
+			: std::upper_bound(edges.keys.begin(), edges.keys.end(), low);
+		auto last = bLowInclusive
+			? std::lower_bound(first, edges.keys.end(), high)
+			: std::upper_bound(first, edges.keys.end(), high);
+
+		const size_t BEGIN = first - edges.keys.begin();
+		const size_t END = last - edges.keys.begin();
+
+		for (size_t i = BEGIN; i < END; ++i)
+		{
+			const uint32_t INDEX = edges.indices[i];
+
+			if (mVisitStamps[INDEX] != mVisitStamp)
+			{
+				mVisitStamps[INDEX] = mVisitStamp;
+				outCandidates.push_back(INDEX);
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ObjectStore.h"
+
+namespace canvas
+{
+	class MarqueeSelector final
+	{
+	public:
+		MarqueeSelector();
+		~MarqueeSelector() = default;
+		MarqueeSelector(const MarqueeSelector& other) = delete;
+		MarqueeSelector& operator=(const MarqueeSelector& rhs) = delete;
+
+		void Begin(const ObjectStore& objects);
+		void Update(const ObjectStore& objects, const RectF& area, std::vector<uint32_t>& outChanged);
+		void End();
+
+		inline bool IsActive() const;
+		inline bool IsContained(uint32_t index) const;
+
+	private:
+		enum eEdge
+		{
+			EDGE_LEFT,
+			EDGE_TOP,
+			EDGE_RIGHT,
+			EDGE_BOTTOM,
+
+			EDGE_COUNT
+		};
+
+		struct SortedEdges
+		{
+			std::vector<float> keys;
+			std::vector<uint32_t> indices;
+		};
+
+		void sortEdges(const float* edges, size_t count, SortedEdges& out);
+		void collectInRange(const SortedEdges& edges, float low, float high, bool bLowInclusive, std::vector<uint32_t>& outCandidates);
+
+		inline static uint32_t toSortableKey(float value);
+
+	private:
+		bool mbActive;
+		bool mbHasArea;
+		RectF mArea;
+
+		SortedEdges mEdges[EDGE_COUNT];
+		std::vector<uint8_t> mContained;
+		std::vector<uint32_t> mVisitStamps;
+		uint32_t mVisitStamp;
+
+		std::vector<uint64_t> mSortBuffer;
+		std::vector<uint64_t> mSortScratch;
+		std::vector<uint32_t> mCandidates;
+	};
+
+	inline bool MarqueeSelector::IsActive() const
+	{
+		return mbActive;
+	}
+
+	inline bool MarqueeSelector::IsContained(uint32_t index) const
+	{
+		return mContained[index] != 0;
+	}
+
+	inline uint32_t MarqueeSelector::toSortableKey(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+	}
+}
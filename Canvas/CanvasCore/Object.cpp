@@ -3,7 +3,7 @@
 
 namespace canvas
 {
-	Object::Object(D2D1_COLOR_F lineColor, D2D1_COLOR_F backgroundColor, float strokeWidth)
+	Object::Object(ColorF lineColor, ColorF backgroundColor, float strokeWidth)
 		: mRect({ NONE_POINT, NONE_POINT, NONE_POINT, NONE_POINT })
 		, mLineColor(lineColor)
 		, mBackgroundColor(backgroundColor)
@@ -11,7 +11,7 @@ namespace canvas
 	{
 	}
 
-	Object::Object(D2D1_RECT_F rect, D2D1_COLOR_F lineColor, D2D1_COLOR_F backgroundColor, float strokeWidth)
+	Object::Object(RectF rect, ColorF lineColor, ColorF backgroundColor, float strokeWidth)
 		: mRect(rect)
 		, mLineColor(lineColor)
 		, mBackgroundColor(backgroundColor)
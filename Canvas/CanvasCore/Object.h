@@ -2,14 +2,14 @@
 
 namespace canvas
 {
-	class App;
+	class Scene;
 
 	class Object final
 	{
-		friend App;
+		friend Scene;
 	public:
-		Object(D2D1_COLOR_F lineColor, D2D1_COLOR_F backgroundColor, float strokeWidth = 1.f);
-		Object(D2D1_RECT_F rect, D2D1_COLOR_F lineColor, D2D1_COLOR_F backgroundColor, float strokeWidth = 1.f);
+		Object(ColorF lineColor, ColorF backgroundColor, float strokeWidth = 1.f);
+		Object(RectF rect, ColorF lineColor, ColorF backgroundColor, float strokeWidth = 1.f);
 
 		~Object() = default;
 		Object(const Object& other) = default;
@@ -17,20 +17,20 @@ namespace canvas
 
 		inline float GetWidth() const;
 		inline float GetHeight() const;
-		inline D2D1_POINT_2F GetCenter() const;
+		inline PointF GetCenter() const;
 
-		inline void SetLeftTop(D2D1_POINT_2F& point);
-		inline void SetRightBottom(D2D1_POINT_2F& point);
-		inline void SetLineColor(D2D1::ColorF color);
-		inline void SetBackGroundColor(D2D1::ColorF color);
-		inline void SetRect(D2D1_RECT_F& rect);
+		inline void SetLeftTop(PointF& point);
+		inline void SetRightBottom(PointF& point);
+		inline void SetLineColor(ColorF color);
+		inline void SetBackGroundColor(ColorF color);
+		inline void SetRect(RectF& rect);
 		inline void SetStrokeWidth(float width);
 		inline void Move(float x, float y);
 
 	private:
-		D2D1_RECT_F mRect;
-		D2D1_COLOR_F mLineColor;
-		D2D1_COLOR_F mBackgroundColor;
+		RectF mRect;
+		ColorF mLineColor;
+		ColorF mBackgroundColor;
 		float mStrokeWidth;
 	};
 
@@ -44,35 +44,35 @@ namespace canvas
 		return mRect.bottom - mRect.top;
 	}
 
-	inline D2D1_POINT_2F Object::GetCenter() const
+	inline PointF Object::GetCenter() const
 	{
 		
 		return { mRect.right - GetWidth() / 2, mRect.bottom - GetHeight() / 2 };
 	}
 
-	inline void Object::SetLeftTop(D2D1_POINT_2F& point)
+	inline void Object::SetLeftTop(PointF& point)
 	{
 		mRect.left = point.x;
 		mRect.top = point.y;
 	}
 
-	inline void Object::SetRightBottom(D2D1_POINT_2F& point)
+	inline void Object::SetRightBottom(PointF& point)
 	{
 		mRect.right = point.x;
 		mRect.bottom = point.y;
 	}
 
-	inline void Object::SetLineColor(D2D1::ColorF color)
+	inline void Object::SetLineColor(ColorF color)
 	{
 		mLineColor = color;
 	}
 
-	inline void Object::SetBackGroundColor(D2D1::ColorF color)
+	inline void Object::SetBackGroundColor(ColorF color)
 	{
 		mBackgroundColor = color;
 	}
 
-	inline void Object::SetRect(D2D1_RECT_F& rect)
+	inline void Object::SetRect(RectF& rect)
 	{
 		mRect = rect;
 	}
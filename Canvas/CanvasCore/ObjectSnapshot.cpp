@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "ObjectSnapshot.h"
+
+namespace canvas
+{
+	ObjectSnapshot::ObjectSnapshot(size_t count, const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys)
+		: mCount(count)
+		, mLefts(lefts)
+		, mTops(tops)
+		, mRights(rights)
+		, mBottoms(bottoms)
+		, mLineColors(lineColors)
+		, mBackgroundColors(backgroundColors)
+		, mStrokeWidths(strokeWidths)
+		, mZKeys(zKeys)
+		, mStates((count + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE)
+		, mPages(mStates.size(), nullptr)
+		, mbFinished(false)
+	{
+	}
+
+	ObjectSnapshot::~ObjectSnapshot()
+	{
+		for (ObjectPage* page : mPages)
+		{
+			delete page;
+		}
+	}
+
+	// Called by the reader. A page nobody has touched is copied straight from
+	// the live columns; the CAS keeps the store from writing to it meanwhile.
+	const ObjectPage& ObjectSnapshot::ReadPage(size_t page, ObjectPage& scratch)
+	{
+		ePageState state = ePageState::Live;
+
+		if (mStates[page].compare_exchange_strong(state, ePageState::Copying, std::memory_order_acquire))
+		{
+			copyPage(page, scratch);
+			mStates[page].store(ePageState::Released, std::memory_order_release);
+
+			return scratch;
+		}
+
+		while (state == ePageState::Copying)
+		{
+			std::this_thread::yield();
+			state = mStates[page].load(std::memory_order_acquire);
+		}
+
+		DEBUG_BREAK(mPages[page] != nullptr);
+
+		return *mPages[page];
+	}
+
+	void ObjectSnapshot::ReleasePage(size_t page)
+	{
+		delete mPages[page];
+		mPages[page] = nullptr;
+	}
+
+	void ObjectSnapshot::Finish()
+	{
+		mbFinished.store(true, std::memory_order_release);
+	}
+
+	// Called by the store before it writes to objects [first, end).
+	void ObjectSnapshot::Preserve(size_t first, size_t end)
+	{
+		const size_t END_PAGE = (std::min)((end + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE, mStates.size());
+
+		for (size_t page = first / SNAPSHOT_PAGE_SIZE; page < END_PAGE; ++page)
+		{
+			ePageState state = mStates[page].load(std::memory_order_acquire);
+
+			if (state == ePageState::Live
+				&& mStates[page].compare_exchange_strong(state, ePageState::Copying, std::memory_order_acquire))
+			{
+				ObjectPage* copy = new ObjectPage;
+				copyPage(page, *copy);
+
+				mPages[page] = copy;
+				mStates[page].store(ePageState::Preserved, std::memory_order_release);
+
+				continue;
+			}
+
+			while (state == ePageState::Copying)
+			{
+				std::this_thread::yield();
+				state = mStates[page].load(std::memory_order_acquire);
+			}
+		}
+	}
+
+	void ObjectSnapshot::Retire(std::vector<float>& column)
+	{
+		mRetiredFloats.push_back(std::move(column));
+		column.clear();
+	}
+
+	void ObjectSnapshot::Retire(std::vector<ColorF>& column)
+	{
+		mRetiredColors.push_back(std::move(column));
+		column.clear();
+	}
+
+	void ObjectSnapshot::Retire(std::vector<uint64_t>& column)
+	{
+		mRetiredKeys.push_back(std::move(column));
+		column.clear();
+	}
+
+	void ObjectSnapshot::copyPage(size_t page, ObjectPage& outPage) const
+	{
+		const size_t FIRST = page * SNAPSHOT_PAGE_SIZE;
+		const size_t COUNT = GetPageCount(page);
+
+		memcpy(outPage.lefts, mLefts + FIRST, COUNT * sizeof(float));
+		memcpy(outPage.tops, mTops + FIRST, COUNT * sizeof(float));
+		memcpy(outPage.rights, mRights + FIRST, COUNT * sizeof(float));
+		memcpy(outPage.bottoms, mBottoms + FIRST, COUNT * sizeof(float));
+		memcpy(outPage.lineColors, mLineColors + FIRST, COUNT * sizeof(ColorF));
+		memcpy(outPage.backgroundColors, mBackgroundColors + FIRST, COUNT * sizeof(ColorF));
+		memcpy(outPage.strokeWidths, mStrokeWidths + FIRST, COUNT * sizeof(float));
+		memcpy(outPage.zKeys, mZKeys + FIRST, COUNT * sizeof(uint64_t));
+	}
+}
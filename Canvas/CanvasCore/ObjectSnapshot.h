@@ -0,0 +1,93 @@
+#pragma once
+
+namespace canvas
+{
+	struct ObjectPage
+	{
+		float lefts[SNAPSHOT_PAGE_SIZE];
+		float tops[SNAPSHOT_PAGE_SIZE];
+		float rights[SNAPSHOT_PAGE_SIZE];
+		float bottoms[SNAPSHOT_PAGE_SIZE];
+		ColorF lineColors[SNAPSHOT_PAGE_SIZE];
+		ColorF backgroundColors[SNAPSHOT_PAGE_SIZE];
+		float strokeWidths[SNAPSHOT_PAGE_SIZE];
+		uint64_t zKeys[SNAPSHOT_PAGE_SIZE];
+	};
+
+	// Point-in-time view of the ObjectStore columns that a reader thread can
+	// consume while editing goes on. Nothing is copied up front: the store
+	// calls Preserve before its first write to a page, and buffers it gives
+	// up are handed over with Retire, so the snapshot never sees a change.
+	class ObjectSnapshot final
+	{
+	public:
+		ObjectSnapshot(size_t count, const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys);
+		~ObjectSnapshot();
+		ObjectSnapshot(const ObjectSnapshot& other) = delete;
+		ObjectSnapshot& operator=(const ObjectSnapshot& rhs) = delete;
+
+		const ObjectPage& ReadPage(size_t page, ObjectPage& scratch);
+		void ReleasePage(size_t page);
+		void Finish();
+
+		void Preserve(size_t first, size_t end);
+		void Retire(std::vector<float>& column);
+		void Retire(std::vector<ColorF>& column);
+		void Retire(std::vector<uint64_t>& column);
+
+		inline size_t GetCount() const;
+		inline size_t GetPagesCount() const;
+		inline size_t GetPageCount(size_t page) const;
+		inline bool IsFinished() const;
+
+	private:
+		enum class ePageState : uint8_t
+		{
+			Live,
+			Copying,
+			Preserved,
+			Released
+		};
+
+		void copyPage(size_t page, ObjectPage& outPage) const;
+
+	private:
+		size_t mCount;
+		const float* mLefts;
+		const float* mTops;
+		const float* mRights;
+		const float* mBottoms;
+		const ColorF* mLineColors;
+		const ColorF* mBackgroundColors;
+		const float* mStrokeWidths;
+		const uint64_t* mZKeys;
+
+		std::vector<std::atomic<ePageState>> mStates;
+		std::vector<ObjectPage*> mPages;
+		std::vector<std::vector<float>> mRetiredFloats;
+		std::vector<std::vector<ColorF>> mRetiredColors;
+		std::vector<std::vector<uint64_t>> mRetiredKeys;
+		std::atomic<bool> mbFinished;
+	};
+
+	inline size_t ObjectSnapshot::GetCount() const
+	{
+		return mCount;
+	}
+
+	inline size_t ObjectSnapshot::GetPagesCount() const
+	{
+		return mStates.size();
+	}
+
+	inline size_t ObjectSnapshot::GetPageCount(size_t page) const
+	{
+		return (std::min)(SNAPSHOT_PAGE_SIZE, mCount - page * SNAPSHOT_PAGE_SIZE);
+	}
+
+	inline bool ObjectSnapshot::IsFinished() const
+	{
+		return mbFinished.load(std::memory_order_acquire);
+	}
+}
@@ -0,0 +1,530 @@
+#include "pch.h"
+#include "ObjectStore.h"
+#include "Profiler.h"
+
+namespace canvas
+{
+	ObjectStore::ObjectStore()
+		: mFreeSlot(UINT32_MAX)
+		, mMaxStrokeWidth(0.f)
+		, mLowestZKey(Z_KEY_ORIGIN)
+		, mHighestZKey(Z_KEY_ORIGIN - Z_KEY_SPACING)
+		, mZOrderVersion(0)
+	{
+		Reserve(DEFAULT_OBJECT_CAPACITY);
+	}
+
+	ObjectStore::~ObjectStore()
+	{
+		if (HasSnapshot())
+		{
+			retireColumns();
+		}
+	}
+
+	ObjectHandle ObjectStore::Add(const RectF& rect, const ColorF& lineColor, const ColorF& backgroundColor, float strokeWidth)
+	{
+		const uint32_t index = static_cast<uint32_t>(mSlotIndices.size());
+		const uint64_t Z_KEY = TakeTopZKeys(1);
+		uint32_t slotIndex;
+
+		if (mSlotIndices.size() == mSlotIndices.capacity())
+		{
+			Reserve(mSlotIndices.capacity() * 2);
+			Profiler::Count(eProfileCounter::Allocations, 1);
+		}
+
+		preserve(index);
+
+		if (mFreeSlot != UINT32_MAX)
+		{
+			slotIndex = mFreeSlot;
+			mFreeSlot = mSlots[slotIndex].index;
+		}
+		else
+		{
+			slotIndex = static_cast<uint32_t>(mSlots.size());
+			mSlots.push_back({ 0, 0 });
+		}
+
+		mSlots[slotIndex].index = index;
+		mMaxStrokeWidth = (std::max)(mMaxStrokeWidth, strokeWidth);
+		++mZOrderVersion;
+
+		mLefts.push_back(rect.left);
+		mTops.push_back(rect.top);
+		mRights.push_back(rect.right);
+		mBottoms.push_back(rect.bottom);
+		mLineColors.push_back(lineColor);
+		mBackgroundColors.push_back(backgroundColor);
+		mStrokeWidths.push_back(strokeWidth);
+		mZKeys.push_back(Z_KEY);
+		mSlotIndices.push_back(slotIndex);
+
+		return { slotIndex, mSlots[slotIndex].generation };
+	}
+
+	size_t ObjectStore::AddColumns(size_t count, const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys)
+	{
+		const uint64_t FIRST_Z_KEY = zKeys == nullptr ? TakeTopZKeys(count) : 0;
+		const size_t FIRST = appendSlots(count);
+
+		ParallelFor(count, [&](size_t begin, size_t end)
+		{
+			const size_t COUNT = end - begin;
+			const size_t INDEX = FIRST + begin;
+
+			memcpy(mLefts.data() + INDEX, lefts + begin, COUNT * sizeof(float));
+			memcpy(mTops.data() + INDEX, tops + begin, COUNT * sizeof(float));
+			memcpy(mRights.data() + INDEX, rights + begin, COUNT * sizeof(float));
+			memcpy(mBottoms.data() + INDEX, bottoms + begin, COUNT * sizeof(float));
+			memcpy(mLineColors.data() + INDEX, lineColors + begin, COUNT * sizeof(ColorF));
+			memcpy(mBackgroundColors.data() + INDEX, backgroundColors + begin, COUNT * sizeof(ColorF));
+			memcpy(mStrokeWidths.data() + INDEX, strokeWidths + begin, COUNT * sizeof(float));
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				mZKeys[FIRST + i] = zKeys == nullptr ? FIRST_Z_KEY + i * Z_KEY_SPACING : zKeys[i];
+			}
+		});
+
+		updateMaxStrokeWidth(FIRST);
+		updateZKeyBounds(FIRST);
+
+		return FIRST;
+	}
+
+	void ObjectStore::Remove(ObjectHandle handle)
+	{
+		DEBUG_BREAK(IsValid(handle));
+
+		const uint32_t index = mSlots[handle.index].index;
+		const uint32_t last = static_cast<uint32_t>(mSlotIndices.size() - 1);
+
+		preserve(index);
+
+		if (index != last)
+		{
+			mLefts[index] = mLefts[last];
+			mTops[index] = mTops[last];
+			mRights[index] = mRights[last];
+			mBottoms[index] = mBottoms[last];
+			mLineColors[index] = mLineColors[last];
+			mBackgroundColors[index] = mBackgroundColors[last];
+			mStrokeWidths[index] = mStrokeWidths[last];
+			mZKeys[index] = mZKeys[last];
+			mSlotIndices[index] = mSlotIndices[last];
+
+			mSlots[mSlotIndices[index]].index = index;
+		}
+
+		mLefts.pop_back();
+		mTops.pop_back();
+		mRights.pop_back();
+		mBottoms.pop_back();
+		mLineColors.pop_back();
+		mBackgroundColors.pop_back();
+		mStrokeWidths.pop_back();
+		mZKeys.pop_back();
+		mSlotIndices.pop_back();
+		++mZOrderVersion;
+
+		Slot& slot = mSlots[handle.index];
+		++slot.generation;
+		slot.index = mFreeSlot;
+		mFreeSlot = handle.index;
+	}
+
+	// Re-adds removed objects under the handles they had, so that handles held
+	// elsewhere (the undo journal) stay meaningful. The free list is rebuilt
+	// afterwards because the reclaimed slots may sit anywhere in it.
+	size_t ObjectStore::Restore(size_t count, const ObjectHandle* handles, const RectF* rects,
+		const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys)
+	{
+		const size_t FIRST = appendRows(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const size_t INDEX = FIRST + i;
+			const uint32_t slotIndex = handles[i].index;
+
+			DEBUG_BREAK(slotIndex < mSlots.size() && !isSlotUsed(slotIndex, FIRST));
+
+			mSlots[slotIndex] = { static_cast<uint32_t>(INDEX), handles[i].generation };
+			mSlotIndices[INDEX] = slotIndex;
+
+			mLefts[INDEX] = rects[i].left;
+			mTops[INDEX] = rects[i].top;
+			mRights[INDEX] = rects[i].right;
+			mBottoms[INDEX] = rects[i].bottom;
+			mLineColors[INDEX] = lineColors[i];
+			mBackgroundColors[INDEX] = backgroundColors[i];
+			mStrokeWidths[INDEX] = strokeWidths[i];
+			mZKeys[INDEX] = zKeys[i];
+		}
+
+		mFreeSlot = UINT32_MAX;
+
+		for (size_t i = mSlots.size(); i-- > 0;)
+		{
+			if (!isSlotUsed(static_cast<uint32_t>(i), mSlotIndices.size()))
+			{
+				mSlots[i].index = mFreeSlot;
+				mFreeSlot = static_cast<uint32_t>(i);
+			}
+		}
+
+		updateMaxStrokeWidth(FIRST);
+		updateZKeyBounds(FIRST);
+
+		return FIRST;
+	}
+
+	void ObjectStore::MoveRange(const uint32_t* indices, size_t count, float x, float y)
+	{
+		if (mSnapshot != nullptr)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				preserve(indices[i]);
+			}
+		}
+
+		ParallelFor(count, [this, indices, x, y](size_t begin, size_t end)
+		{
+			float* lefts = mLefts.data();
+			float* tops = mTops.data();
+			float* rights = mRights.data();
+			float* bottoms = mBottoms.data();
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint32_t INDEX = indices[i];
+
+				lefts[INDEX] += x;
+				tops[INDEX] += y;
+				rights[INDEX] += x;
+				bottoms[INDEX] += y;
+			}
+		});
+	}
+
+	void ObjectStore::TransformRange(const uint32_t* indices, size_t count, const GroupTransform& transform)
+	{
+		if (mSnapshot != nullptr)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				preserve(indices[i]);
+			}
+		}
+
+		ParallelFor(count, [this, indices, &transform](size_t begin, size_t end)
+		{
+			float* lefts = mLefts.data();
+			float* tops = mTops.data();
+			float* rights = mRights.data();
+			float* bottoms = mBottoms.data();
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint32_t INDEX = indices[i];
+
+				lefts[INDEX] = transform.ApplyX(lefts[INDEX]);
+				tops[INDEX] = transform.ApplyY(tops[INDEX]);
+				rights[INDEX] = transform.ApplyX(rights[INDEX]);
+				bottoms[INDEX] = transform.ApplyY(bottoms[INDEX]);
+			}
+		});
+	}
+
+	size_t ObjectStore::appendRows(size_t count)
+	{
+		const size_t FIRST = mSlotIndices.size();
+		const size_t SIZE = FIRST + count;
+
+		if (SIZE > mSlotIndices.capacity())
+		{
+			Reserve((std::max)(SIZE, mSlotIndices.capacity() * 2));
+		}
+
+		preserveRange(FIRST, SIZE);
+
+		mLefts.resize(SIZE);
+		mTops.resize(SIZE);
+		mRights.resize(SIZE);
+		mBottoms.resize(SIZE);
+		mLineColors.resize(SIZE);
+		mBackgroundColors.resize(SIZE);
+		mStrokeWidths.resize(SIZE);
+		mZKeys.resize(SIZE);
+		mSlotIndices.resize(SIZE);
+		++mZOrderVersion;
+
+		return FIRST;
+	}
+
+	size_t ObjectStore::appendSlots(size_t count)
+	{
+		const size_t FIRST = appendRows(count);
+		const size_t SIZE = FIRST + count;
+
+		for (size_t index = FIRST; index < SIZE; ++index)
+		{
+			uint32_t slotIndex;
+
+			if (mFreeSlot != UINT32_MAX)
+			{
+				slotIndex = mFreeSlot;
+				mFreeSlot = mSlots[slotIndex].index;
+			}
+			else
+			{
+				slotIndex = static_cast<uint32_t>(mSlots.size());
+				mSlots.push_back({ 0, 0 });
+			}
+
+			mSlots[slotIndex].index = static_cast<uint32_t>(index);
+			mSlotIndices[index] = slotIndex;
+		}
+
+		return FIRST;
+	}
+
+	void ObjectStore::updateMaxStrokeWidth(size_t first)
+	{
+		for (size_t i = first; i < mStrokeWidths.size(); ++i)
+		{
+			mMaxStrokeWidth = (std::max)(mMaxStrokeWidth, mStrokeWidths[i]);
+		}
+	}
+
+	void ObjectStore::updateZKeyBounds(size_t first)
+	{
+		for (size_t i = first; i < mZKeys.size(); ++i)
+		{
+			mLowestZKey = (std::min)(mLowestZKey, mZKeys[i]);
+			mHighestZKey = (std::max)(mHighestZKey, mZKeys[i]);
+		}
+	}
+
+	// Returns the first of count keys, Z_KEY_SPACING apart, above every
+	// object. The keys are spent even if the caller does not use them all.
+	uint64_t ObjectStore::TakeTopZKeys(size_t count)
+	{
+		if (mHighestZKey > UINT64_MAX - (count + 1) * Z_KEY_SPACING)
+		{
+			RenumberZKeys();
+		}
+
+		const uint64_t FIRST = mHighestZKey + Z_KEY_SPACING;
+		mHighestZKey += count * Z_KEY_SPACING;
+
+		return FIRST;
+	}
+
+	// Returns the first of count keys, Z_KEY_SPACING apart, below every object.
+	uint64_t ObjectStore::TakeBottomZKeys(size_t count)
+	{
+		if (mLowestZKey < (count + 1) * Z_KEY_SPACING)
+		{
+			RenumberZKeys();
+		}
+
+		mLowestZKey -= count * Z_KEY_SPACING;
+
+		return mLowestZKey;
+	}
+
+	// Spreads the keys out evenly in their current order, for when a reorder
+	// finds no key left between two neighbours or either end runs out. Every
+	// key changes; the old ones are kept sorted so that keys saved elsewhere
+	// can follow with RemapZKey.
+	void ObjectStore::RenumberZKeys()
+	{
+		const size_t COUNT = mZKeys.size();
+		std::vector<uint32_t> order(COUNT);
+
+		for (uint32_t i = 0; i < COUNT; ++i)
+		{
+			order[i] = i;
+		}
+
+		std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs)
+		{
+			return IsAbove(rhs, lhs);
+		});
+
+		preserveRange(0, COUNT);
+
+		std::vector<uint64_t>& staleKeys = mStaleZKeys.emplace_back(COUNT);
+
+		for (size_t rank = 0; rank < COUNT; ++rank)
+		{
+			staleKeys[rank] = mZKeys[order[rank]];
+			mZKeys[order[rank]] = Z_KEY_ORIGIN + rank * Z_KEY_SPACING;
+		}
+
+		mLowestZKey = Z_KEY_ORIGIN;
+		mHighestZKey = Z_KEY_ORIGIN + (static_cast<uint64_t>(COUNT) - 1) * Z_KEY_SPACING;
+		++mZOrderVersion;
+	}
+
+	// Moves a key saved before the renumbers since ReleaseStaleZKeys to
+	// where it falls now, so saved and live keys keep their order.
+	uint64_t ObjectStore::RemapZKey(uint64_t key) const
+	{
+		for (const std::vector<uint64_t>& staleKeys : mStaleZKeys)
+		{
+			key = remapZKey(staleKeys, key);
+		}
+
+		return key;
+	}
+
+	void ObjectStore::ReleaseStaleZKeys()
+	{
+		mStaleZKeys.clear();
+		mStaleZKeys.shrink_to_fit();
+	}
+
+	// A key an object had maps to that object's new key. One between two
+	// old keys lands the same fraction of the way between their new keys;
+	// the ends stretch to zero and UINT64_MAX.
+	uint64_t ObjectStore::remapZKey(const std::vector<uint64_t>& staleKeys, uint64_t key)
+	{
+		const size_t COUNT = staleKeys.size();
+
+		if (COUNT == 0)
+		{
+			return key;
+		}
+
+		const size_t RANK = std::lower_bound(staleKeys.begin(), staleKeys.end(), key) - staleKeys.begin();
+
+		if (RANK < COUNT && staleKeys[RANK] == key)
+		{
+			return Z_KEY_ORIGIN + RANK * Z_KEY_SPACING;
+		}
+
+		const uint64_t LOW = RANK == 0 ? 0 : staleKeys[RANK - 1];
+		const uint64_t HIGH = RANK == COUNT ? UINT64_MAX : staleKeys[RANK];
+		const uint64_t NEW_LOW = RANK == 0 ? 0 : Z_KEY_ORIGIN + (RANK - 1) * Z_KEY_SPACING;
+		const uint64_t NEW_HIGH = RANK == COUNT ? UINT64_MAX : Z_KEY_ORIGIN + RANK * Z_KEY_SPACING;
+		const uint64_t RANGE = NEW_HIGH - NEW_LOW;
+		const double FRACTION = static_cast<double>(key - LOW) / static_cast<double>(HIGH - LOW);
+		const uint64_t OFFSET = static_cast<uint64_t>(FRACTION * static_cast<double>(RANGE));
+
+		return NEW_LOW + (std::min)((std::max)(OFFSET, static_cast<uint64_t>(RANK > 0)), RANGE - (RANK < COUNT));
+	}
+
+	void ObjectStore::Reserve(size_t capacity)
+	{
+		if (capacity > mLefts.capacity() && HasSnapshot())
+		{
+			growColumns(capacity);
+		}
+
+		mLefts.reserve(capacity);
+		mTops.reserve(capacity);
+		mRights.reserve(capacity);
+		mBottoms.reserve(capacity);
+		mLineColors.reserve(capacity);
+		mBackgroundColors.reserve(capacity);
+		mStrokeWidths.reserve(capacity);
+		mZKeys.reserve(capacity);
+		mSlotIndices.reserve(capacity);
+		mSlots.reserve(capacity);
+	}
+
+	void ObjectStore::Clear()
+	{
+		if (HasSnapshot())
+		{
+			retireColumns();
+		}
+
+		mLefts.clear();
+		mTops.clear();
+		mRights.clear();
+		mBottoms.clear();
+		mLineColors.clear();
+		mBackgroundColors.clear();
+		mStrokeWidths.clear();
+		mZKeys.clear();
+		mSlotIndices.clear();
+
+		mLowestZKey = Z_KEY_ORIGIN;
+		mHighestZKey = Z_KEY_ORIGIN - Z_KEY_SPACING;
+		++mZOrderVersion;
+
+		for (size_t i = 0; i < mSlots.size(); ++i)
+		{
+			++mSlots[i].generation;
+			mSlots[i].index = i + 1 < mSlots.size() ? static_cast<uint32_t>(i + 1) : UINT32_MAX;
+		}
+
+		mFreeSlot = mSlots.empty() ? UINT32_MAX : 0;
+	}
+
+	// The snapshot sees the columns as they are now. Pages are copied into it
+	// only when the store is about to write to them, so taking one is O(pages).
+	std::shared_ptr<ObjectSnapshot> ObjectStore::TakeSnapshot()
+	{
+		DEBUG_BREAK(!HasSnapshot());
+
+		mSnapshot = std::make_shared<ObjectSnapshot>(mSlotIndices.size(), mLefts.data(), mTops.data(), mRights.data(), mBottoms.data(),
+			mLineColors.data(), mBackgroundColors.data(), mStrokeWidths.data(), mZKeys.data());
+
+		return mSnapshot;
+	}
+
+	void ObjectStore::preserveRange(size_t first, size_t end)
+	{
+		if (HasSnapshot())
+		{
+			mSnapshot->Preserve(first, end);
+		}
+	}
+
+	bool ObjectStore::HasSnapshot()
+	{
+		if (mSnapshot != nullptr && mSnapshot->IsFinished())
+		{
+			mSnapshot.reset();
+		}
+
+		return mSnapshot != nullptr;
+	}
+
+	// Hands the current buffers over to the snapshot, which then never needs
+	// another page copy, and leaves the store with empty columns.
+	void ObjectStore::retireColumns()
+	{
+		mSnapshot->Retire(mLefts);
+		mSnapshot->Retire(mTops);
+		mSnapshot->Retire(mRights);
+		mSnapshot->Retire(mBottoms);
+		mSnapshot->Retire(mLineColors);
+		mSnapshot->Retire(mBackgroundColors);
+		mSnapshot->Retire(mStrokeWidths);
+		mSnapshot->Retire(mZKeys);
+
+		mSnapshot.reset();
+	}
+
+	void ObjectStore::growColumns(size_t capacity)
+	{
+		growColumn(mLefts, capacity);
+		growColumn(mTops, capacity);
+		growColumn(mRights, capacity);
+		growColumn(mBottoms, capacity);
+		growColumn(mLineColors, capacity);
+		growColumn(mBackgroundColors, capacity);
+		growColumn(mStrokeWidths, capacity);
+		growColumn(mZKeys, capacity);
+
+		mSnapshot.reset();
+	}
+}
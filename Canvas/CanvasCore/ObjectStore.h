@@ -0,0 +1,354 @@
+#pragma once
+
+#include "ParallelFor.h"
+#include "ObjectSnapshot.h"
+#include "GroupTransform.h"
+
+namespace canvas
+{
+	struct ObjectHandle
+	{
+		uint32_t index;
+		uint32_t generation;
+	};
+
+	constexpr ObjectHandle INVALID_OBJECT_HANDLE = { UINT32_MAX, 0 };
+
+	inline bool operator==(const ObjectHandle& lhs, const ObjectHandle& rhs)
+	{
+		return lhs.index == rhs.index && lhs.generation == rhs.generation;
+	}
+
+	inline bool operator!=(const ObjectHandle& lhs, const ObjectHandle& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	struct ObjectHandleHash
+	{
+		size_t operator()(const ObjectHandle& handle) const
+		{
+			return std::hash<uint64_t>()((static_cast<uint64_t>(handle.generation) << 32) | handle.index);
+		}
+	};
+
+	class ObjectStore final
+	{
+	public:
+		ObjectStore();
+		~ObjectStore();
+		ObjectStore(const ObjectStore& other) = delete;
+		ObjectStore& operator=(const ObjectStore& rhs) = delete;
+
+		ObjectHandle Add(const RectF& rect, const ColorF& lineColor, const ColorF& backgroundColor, float strokeWidth);
+		template<typename Builder>
+		size_t AddRange(size_t count, const Builder& builder);
+		size_t AddColumns(size_t count, const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys);
+		size_t Restore(size_t count, const ObjectHandle* handles, const RectF* rects,
+			const ColorF* lineColors, const ColorF* backgroundColors, const float* strokeWidths, const uint64_t* zKeys);
+		void Remove(ObjectHandle handle);
+		void Reserve(size_t capacity);
+		void Clear();
+		std::shared_ptr<ObjectSnapshot> TakeSnapshot();
+		bool HasSnapshot();
+
+		inline bool IsValid(ObjectHandle handle) const;
+		inline size_t GetIndex(ObjectHandle handle) const;
+		inline ObjectHandle GetHandle(size_t index) const;
+		inline size_t GetCount() const;
+		inline float GetMaxStrokeWidth() const;
+
+		inline RectF GetRect(size_t index) const;
+		inline const ColorF& GetLineColor(size_t index) const;
+		inline const ColorF& GetBackgroundColor(size_t index) const;
+		inline float GetStrokeWidth(size_t index) const;
+		inline bool IsFilled(size_t index) const;
+		inline uint64_t GetZKey(size_t index) const;
+		inline bool IsAbove(size_t index, size_t other) const;
+
+		inline const float* GetLefts() const;
+		inline const float* GetTops() const;
+		inline const float* GetRights() const;
+		inline const float* GetBottoms() const;
+		inline const ColorF* GetLineColors() const;
+		inline const ColorF* GetBackgroundColors() const;
+		inline const float* GetStrokeWidths() const;
+		inline const uint64_t* GetZKeys() const;
+		inline uint64_t GetZOrderVersion() const;
+		inline bool HasStaleZKeys() const;
+
+		inline void SetRect(size_t index, const RectF& rect);
+		inline void Move(size_t index, float x, float y);
+		void MoveRange(const uint32_t* indices, size_t count, float x, float y);
+		void TransformRange(const uint32_t* indices, size_t count, const GroupTransform& transform);
+
+		inline void SetZKey(size_t index, uint64_t key);
+		uint64_t TakeTopZKeys(size_t count);
+		uint64_t TakeBottomZKeys(size_t count);
+		void RenumberZKeys();
+		uint64_t RemapZKey(uint64_t key) const;
+		void ReleaseStaleZKeys();
+
+	private:
+		size_t appendRows(size_t count);
+		size_t appendSlots(size_t count);
+		void updateMaxStrokeWidth(size_t first);
+		void updateZKeyBounds(size_t first);
+		void preserveRange(size_t first, size_t end);
+		void retireColumns();
+		void growColumns(size_t capacity);
+		template<typename T>
+		void growColumn(std::vector<T>& column, size_t capacity);
+
+		inline void preserve(size_t index);
+		inline bool isSlotUsed(uint32_t slotIndex, size_t count) const;
+
+		static uint64_t remapZKey(const std::vector<uint64_t>& staleKeys, uint64_t key);
+
+	private:
+		struct Slot
+		{
+			uint32_t index;
+			uint32_t generation;
+		};
+
+	private:
+		std::vector<float> mLefts;
+		std::vector<float> mTops;
+		std::vector<float> mRights;
+		std::vector<float> mBottoms;
+		std::vector<ColorF> mLineColors;
+		std::vector<ColorF> mBackgroundColors;
+		std::vector<float> mStrokeWidths;
+		std::vector<uint64_t> mZKeys;
+		std::vector<uint32_t> mSlotIndices;
+
+		std::vector<Slot> mSlots;
+		uint32_t mFreeSlot;
+		float mMaxStrokeWidth;
+		uint64_t mLowestZKey;
+		uint64_t mHighestZKey;
+		uint64_t mZOrderVersion;
+		std::vector<std::vector<uint64_t>> mStaleZKeys;
+		std::shared_ptr<ObjectSnapshot> mSnapshot;
+	};
+
+	// Appends count objects in one pass and returns the index of the first.
+	// builder(i, rect, lineColor, backgroundColor, strokeWidth) fills the i-th
+	// one and may run concurrently on disjoint ranges, so it must only read.
+	template<typename Builder>
+	size_t ObjectStore::AddRange(size_t count, const Builder& builder)
+	{
+		const uint64_t FIRST_Z_KEY = TakeTopZKeys(count);
+		const size_t FIRST = appendSlots(count);
+
+		ParallelFor(count, [this, &builder, FIRST, FIRST_Z_KEY](size_t begin, size_t end)
+		{
+			RectF rect;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const size_t INDEX = FIRST + i;
+				builder(i, rect, mLineColors[INDEX], mBackgroundColors[INDEX], mStrokeWidths[INDEX]);
+
+				mLefts[INDEX] = rect.left;
+				mTops[INDEX] = rect.top;
+				mRights[INDEX] = rect.right;
+				mBottoms[INDEX] = rect.bottom;
+				mZKeys[INDEX] = FIRST_Z_KEY + i * Z_KEY_SPACING;
+			}
+		});
+
+		updateMaxStrokeWidth(FIRST);
+
+		return FIRST;
+	}
+
+	inline bool ObjectStore::IsValid(ObjectHandle handle) const
+	{
+		if (handle.index >= mSlots.size())
+		{
+			return false;
+		}
+
+		const Slot& slot = mSlots[handle.index];
+
+		return slot.generation == handle.generation && slot.index < mSlotIndices.size()
+			&& mSlotIndices[slot.index] == handle.index;
+	}
+
+	inline size_t ObjectStore::GetIndex(ObjectHandle handle) const
+	{
+		DEBUG_BREAK(IsValid(handle));
+
+		return mSlots[handle.index].index;
+	}
+
+	inline ObjectHandle ObjectStore::GetHandle(size_t index) const
+	{
+		DEBUG_BREAK(index < mSlotIndices.size());
+
+		const uint32_t slotIndex = mSlotIndices[index];
+
+		return { slotIndex, mSlots[slotIndex].generation };
+	}
+
+	inline size_t ObjectStore::GetCount() const
+	{
+		return mSlotIndices.size();
+	}
+
+	inline float ObjectStore::GetMaxStrokeWidth() const
+	{
+		return mMaxStrokeWidth;
+	}
+
+	inline RectF ObjectStore::GetRect(size_t index) const
+	{
+		return { mLefts[index], mTops[index], mRights[index], mBottoms[index] };
+	}
+
+	inline const ColorF& ObjectStore::GetLineColor(size_t index) const
+	{
+		return mLineColors[index];
+	}
+
+	inline const ColorF& ObjectStore::GetBackgroundColor(size_t index) const
+	{
+		return mBackgroundColors[index];
+	}
+
+	inline float ObjectStore::GetStrokeWidth(size_t index) const
+	{
+		return mStrokeWidths[index];
+	}
+
+	inline bool ObjectStore::IsFilled(size_t index) const
+	{
+		return mBackgroundColors[index].a > 0.f;
+	}
+
+	inline uint64_t ObjectStore::GetZKey(size_t index) const
+	{
+		return mZKeys[index];
+	}
+
+	// A reorder only looks at overlapping objects, so it can land on the key
+	// of one elsewhere. The slot settles such ties, and it survives removals.
+	inline bool ObjectStore::IsAbove(size_t index, size_t other) const
+	{
+		return mZKeys[index] > mZKeys[other] || (mZKeys[index] == mZKeys[other] && mSlotIndices[index] > mSlotIndices[other]);
+	}
+
+	inline const float* ObjectStore::GetLefts() const
+	{
+		return mLefts.data();
+	}
+
+	inline const float* ObjectStore::GetTops() const
+	{
+		return mTops.data();
+	}
+
+	inline const float* ObjectStore::GetRights() const
+	{
+		return mRights.data();
+	}
+
+	inline const float* ObjectStore::GetBottoms() const
+	{
+		return mBottoms.data();
+	}
+
+	inline const ColorF* ObjectStore::GetLineColors() const
+	{
+		return mLineColors.data();
+	}
+
+	inline const ColorF* ObjectStore::GetBackgroundColors() const
+	{
+		return mBackgroundColors.data();
+	}
+
+	inline const float* ObjectStore::GetStrokeWidths() const
+	{
+		return mStrokeWidths.data();
+	}
+
+	inline const uint64_t* ObjectStore::GetZKeys() const
+	{
+		return mZKeys.data();
+	}
+
+	// Changes whenever paint order may have: objects added or removed, or a
+	// key set.
+	inline uint64_t ObjectStore::GetZOrderVersion() const
+	{
+		return mZOrderVersion;
+	}
+
+	// Keys saved outside the store before a renumber need RemapZKey.
+	inline bool ObjectStore::HasStaleZKeys() const
+	{
+		return !mStaleZKeys.empty();
+	}
+
+	inline void ObjectStore::SetRect(size_t index, const RectF& rect)
+	{
+		preserve(index);
+
+		mLefts[index] = rect.left;
+		mTops[index] = rect.top;
+		mRights[index] = rect.right;
+		mBottoms[index] = rect.bottom;
+	}
+
+	inline void ObjectStore::Move(size_t index, float x, float y)
+	{
+		preserve(index);
+
+		mLefts[index] += x;
+		mTops[index] += y;
+		mRights[index] += x;
+		mBottoms[index] += y;
+	}
+
+	inline void ObjectStore::SetZKey(size_t index, uint64_t key)
+	{
+		preserve(index);
+
+		mZKeys[index] = key;
+		mLowestZKey = (std::min)(mLowestZKey, key);
+		mHighestZKey = (std::max)(mHighestZKey, key);
+		++mZOrderVersion;
+	}
+
+	inline void ObjectStore::preserve(size_t index)
+	{
+		if (mSnapshot != nullptr)
+		{
+			preserveRange(index, index + 1);
+		}
+	}
+
+	inline bool ObjectStore::isSlotUsed(uint32_t slotIndex, size_t count) const
+	{
+		const uint32_t index = mSlots[slotIndex].index;
+
+		return index < count && mSlotIndices[index] == slotIndex;
+	}
+
+	// Keeps a grown column's old buffer alive for the snapshot instead of
+	// freeing it, so the snapshot reads it unchanged from then on.
+	template<typename T>
+	void ObjectStore::growColumn(std::vector<T>& column, size_t capacity)
+	{
+		std::vector<T> grown;
+		grown.reserve(capacity);
+		grown.assign(column.begin(), column.end());
+
+		mSnapshot->Retire(column);
+		column.swap(grown);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "WorkStealingPool.h"
+
+namespace canvas
+{
+	// Splits [0, count) into up to one contiguous chunk per hardware thread, each
+	// at least minChunkSize long, and runs func(begin, end) on each on the shared
+	// pool. A batch too small to split runs inline on the caller.
+	template<typename Func>
+	void ParallelFor(size_t count, size_t minChunkSize, const Func& func)
+	{
+		const size_t THREADS_COUNT = (std::max)(std::thread::hardware_concurrency(), 1u);
+		const size_t CHUNKS_COUNT = (std::min)(THREADS_COUNT, count / (std::max)(minChunkSize, static_cast<size_t>(1)));
+
+		if (CHUNKS_COUNT <= 1)
+		{
+			func(static_cast<size_t>(0), count);
+			return;
+		}
+
+		const size_t CHUNK_SIZE = (count + CHUNKS_COUNT - 1) / CHUNKS_COUNT;
+		const size_t CHUNKS_USED = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		WorkStealingPool::RunShared(CHUNKS_USED, [&func, count, CHUNK_SIZE](size_t chunk)
+		{
+			const size_t BEGIN = chunk * CHUNK_SIZE;
+			func(BEGIN, (std::min)(BEGIN + CHUNK_SIZE, count));
+		});
+	}
+
+	template<typename Func>
+	void ParallelFor(size_t count, const Func& func)
+	{
+		ParallelFor(count, PARALLEL_MIN_CHUNK_SIZE, func);
+	}
+}
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "MappedFile.h"
+
+namespace canvas
+{
+	bool Profiler::mbEnabled = false;
+	uint32_t Profiler::mEnableCount = 0;
+	uint64_t Profiler::mFramesCount = 0;
+
+	uint64_t Profiler::mFrameTimes[TIMERS_COUNT] = {};
+	uint64_t Profiler::mFrameCounts[COUNTERS_COUNT] = {};
+	bool Profiler::mbTimersUsed[TIMERS_COUNT] = {};
+	bool Profiler::mbCountersUsed[COUNTERS_COUNT] = {};
+	uint64_t Profiler::mLastFrameTimes[TIMERS_COUNT] = {};
+	uint64_t Profiler::mLastFrameCounts[COUNTERS_COUNT] = {};
+
+	HdrHistogram Profiler::mTimeHistograms[TIMERS_COUNT];
+	HdrHistogram Profiler::mCountHistograms[COUNTERS_COUNT];
+
+	// Enabling is counted, so the overlay and a dump can ask independently.
+	void Profiler::Enable()
+	{
+		++mEnableCount;
+		mbEnabled = true;
+	}
+
+	void Profiler::Disable()
+	{
+		DEBUG_BREAK(mEnableCount > 0);
+
+		mEnableCount -= mEnableCount > 0 ? 1 : 0;
+		mbEnabled = mEnableCount > 0;
+	}
+
+	// Timers and counters that were not reported during the frame are left
+	// out of their histograms rather than recorded as zero.
+	void Profiler::EndFrame()
+	{
+		if (!mbEnabled)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < TIMERS_COUNT; ++i)
+		{
+			if (mbTimersUsed[i])
+			{
+				mTimeHistograms[i].Record(mFrameTimes[i]);
+			}
+
+			mLastFrameTimes[i] = mFrameTimes[i];
+			mFrameTimes[i] = 0;
+			mbTimersUsed[i] = false;
+		}
+
+		for (size_t i = 0; i < COUNTERS_COUNT; ++i)
+		{
+			if (mbCountersUsed[i])
+			{
+				mCountHistograms[i].Record(mFrameCounts[i]);
+			}
+
+			mLastFrameCounts[i] = mFrameCounts[i];
+			mFrameCounts[i] = 0;
+			mbCountersUsed[i] = false;
+		}
+
+		++mFramesCount;
+	}
+
+	void Profiler::Reset()
+	{
+		for (size_t i = 0; i < TIMERS_COUNT; ++i)
+		{
+			mTimeHistograms[i].Clear();
+			mFrameTimes[i] = 0;
+			mLastFrameTimes[i] = 0;
+			mbTimersUsed[i] = false;
+		}
+
+		for (size_t i = 0; i < COUNTERS_COUNT; ++i)
+		{
+			mCountHistograms[i].Clear();
+			mFrameCounts[i] = 0;
+			mLastFrameCounts[i] = 0;
+			mbCountersUsed[i] = false;
+		}
+
+		mFramesCount = 0;
+	}
+
+	// Writes one line per timer (microseconds) and counter, over the frames
+	// that used them.
+	bool Profiler::Dump(const char* path)
+	{
+		FILE* file = OpenFile(path, "w");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		fprintf(file, "%llu frames, times in microseconds\n", static_cast<unsigned long long>(mFramesCount));
+		fprintf(file, "%-20s %10s %12s %12s %12s %12s %12s %12s\n", "name", "frames", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+		for (size_t i = 0; i < TIMERS_COUNT; ++i)
+		{
+			const HdrHistogram& histogram = mTimeHistograms[i];
+
+			fprintf(file, "%-20s %10llu %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n",
+				GetName(static_cast<eProfileTimer>(i)), static_cast<unsigned long long>(histogram.GetCount()),
+				histogram.GetMean() / 1e3, histogram.GetPercentile(50.0) / 1e3, histogram.GetPercentile(90.0) / 1e3,
+				histogram.GetPercentile(99.0) / 1e3, histogram.GetPercentile(99.9) / 1e3, histogram.GetMax() / 1e3);
+		}
+
+		for (size_t i = 0; i < COUNTERS_COUNT; ++i)
+		{
+			const HdrHistogram& histogram = mCountHistograms[i];
+
+			fprintf(file, "%-20s %10llu %12.1f %12llu %12llu %12llu %12llu %12llu\n",
+				GetName(static_cast<eProfileCounter>(i)), static_cast<unsigned long long>(histogram.GetCount()), histogram.GetMean(),
+				static_cast<unsigned long long>(histogram.GetPercentile(50.0)), static_cast<unsigned long long>(histogram.GetPercentile(90.0)),
+				static_cast<unsigned long long>(histogram.GetPercentile(99.0)), static_cast<unsigned long long>(histogram.GetPercentile(99.9)),
+				static_cast<unsigned long long>(histogram.GetMax()));
+		}
+
+		return fclose(file) == 0;
+	}
+
+	const char* Profiler::GetName(eProfileTimer timer)
+	{
+		switch (timer)
+		{
+		case eProfileTimer::HitTest:
+			return "hit-test";
+		case eProfileTimer::Marquee:
+			return "marquee";
+		case eProfileTimer::SelectionBoundary:
+			return "selection-bounds";
+		case eProfileTimer::Move:
+			return "move";
+		case eProfileTimer::Resize:
+			return "resize";
+		case eProfileTimer::Commit:
+			return "commit";
+		case eProfileTimer::Render:
+			return "render";
+		default:
+			DEBUG_BREAK(false);
+			return "";
+		}
+	}
+
+	const char* Profiler::GetName(eProfileCounter counter)
+	{
+		switch (counter)
+		{
+		case eProfileCounter::ObjectsScanned:
+			return "objects-scanned";
+		case eProfileCounter::ObjectsDrawn:
+			return "objects-drawn";
+		case eProfileCounter::DrawCommands:
+			return "draw-commands";
+		case eProfileCounter::BrushChanges:
+			return "brush-changes";
+		case eProfileCounter::Allocations:
+			return "allocations";
+		default:
+			DEBUG_BREAK(false);
+			return "";
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "HdrHistogram.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	enum class eProfileTimer
+	{
+		HitTest,
+		Marquee,
+		SelectionBoundary,
+		Move,
+		Resize,
+		Commit,
+		Render,
+
+		Count
+	};
+
+	// Allocations counts slab and object store growths, not every new.
+	enum class eProfileCounter
+	{
+		ObjectsScanned,
+		ObjectsDrawn,
+		DrawCommands,
+		BrushChanges,
+		Allocations,
+
+		Count
+	};
+
+	// Per-frame totals of the hot paths, folded into one histogram each by
+	// EndFrame. Only the thread that owns the scene may report. While
+	// disabled, a timer or counter costs one load and a branch.
+	class Profiler final
+	{
+	public:
+		static void Enable();
+		static void Disable();
+		static void EndFrame();
+		static void Reset();
+		static bool Dump(const char* path);
+
+		inline static bool IsEnabled();
+		inline static void AddTime(eProfileTimer timer, std::chrono::steady_clock::duration time);
+		inline static void Count(eProfileCounter counter, uint64_t value);
+
+		inline static const HdrHistogram& GetHistogram(eProfileTimer timer);
+		inline static const HdrHistogram& GetHistogram(eProfileCounter counter);
+		inline static uint64_t GetLastFrameValue(eProfileTimer timer);
+		inline static uint64_t GetLastFrameValue(eProfileCounter counter);
+		inline static uint64_t GetFramesCount();
+
+		static const char* GetName(eProfileTimer timer);
+		static const char* GetName(eProfileCounter counter);
+
+	private:
+		Profiler() = delete;
+
+		static constexpr size_t TIMERS_COUNT = static_cast<size_t>(eProfileTimer::Count);
+		static constexpr size_t COUNTERS_COUNT = static_cast<size_t>(eProfileCounter::Count);
+
+	private:
+		static bool mbEnabled;
+		static uint32_t mEnableCount;
+		static uint64_t mFramesCount;
+
+		static uint64_t mFrameTimes[TIMERS_COUNT];
+		static uint64_t mFrameCounts[COUNTERS_COUNT];
+		static bool mbTimersUsed[TIMERS_COUNT];
+		static bool mbCountersUsed[COUNTERS_COUNT];
+		static uint64_t mLastFrameTimes[TIMERS_COUNT];
+		static uint64_t mLastFrameCounts[COUNTERS_COUNT];
+
+		static HdrHistogram mTimeHistograms[TIMERS_COUNT];
+		static HdrHistogram mCountHistograms[COUNTERS_COUNT];
+	};
+
+	// Adds the time until the end of the scope to the frame total of a timer,
+	// and to the trace as a span named after it.
+	class ProfileScope final
+	{
+	public:
+		inline ProfileScope(eProfileTimer timer);
+		inline ~ProfileScope();
+		ProfileScope(const ProfileScope& other) = delete;
+		ProfileScope& operator=(const ProfileScope& rhs) = delete;
+
+	private:
+		eProfileTimer mTimer;
+		bool mbProfiling;
+		bool mbTracing;
+		std::chrono::steady_clock::time_point mBegin;
+	};
+
+	inline bool Profiler::IsEnabled()
+	{
+		return mbEnabled;
+	}
+
+	inline void Profiler::AddTime(eProfileTimer timer, std::chrono::steady_clock::duration time)
+	{
+		const size_t INDEX = static_cast<size_t>(timer);
+
+		mFrameTimes[INDEX] += std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+		mbTimersUsed[INDEX] = true;
+	}
+
+	inline void Profiler::Count(eProfileCounter counter, uint64_t value)
+	{
+		if (mbEnabled)
+		{
+			const size_t INDEX = static_cast<size_t>(counter);
+
+			mFrameCounts[INDEX] += value;
+			mbCountersUsed[INDEX] = true;
+		}
+	}
+
+	inline const HdrHistogram& Profiler::GetHistogram(eProfileTimer timer)
+	{
+		return mTimeHistograms[static_cast<size_t>(timer)];
+	}
+
+	inline const HdrHistogram& Profiler::GetHistogram(eProfileCounter counter)
+	{
+		return mCountHistograms[static_cast<size_t>(counter)];
+	}
+
+	inline uint64_t Profiler::GetLastFrameValue(eProfileTimer timer)
+	{
+		return mLastFrameTimes[static_cast<size_t>(timer)];
+	}
+
+	inline uint64_t Profiler::GetLastFrameValue(eProfileCounter counter)
+	{
+		return mLastFrameCounts[static_cast<size_t>(counter)];
+	}
+
+	inline uint64_t Profiler::GetFramesCount()
+	{
+		return mFramesCount;
+	}
+
+	inline ProfileScope::ProfileScope(eProfileTimer timer)
+		: mTimer(timer)
+		, mbProfiling(Profiler::IsEnabled())
+		, mbTracing(Tracer::IsEnabled())
+	{
+		if (mbProfiling || mbTracing)
+		{
+			mBegin = std::chrono::steady_clock::now();
+		}
+	}
+
+	inline ProfileScope::~ProfileScope()
+	{
+		if (!mbProfiling && !mbTracing)
+		{
+			return;
+		}
+
+		const std::chrono::steady_clock::time_point END = std::chrono::steady_clock::now();
+
+		if (mbProfiling)
+		{
+			Profiler::AddTime(mTimer, END - mBegin);
+		}
+
+		if (mbTracing)
+		{
+			Tracer::AddEvent(Profiler::GetName(mTimer), mBegin, END);
+		}
+	}
+}
@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "RectKernels.h"
+
+namespace canvas
+{
+	eSimdLevel RectKernels::mSimdLevel = RectKernels::detectSimdLevel();
+
+	eSimdLevel RectKernels::GetSimdLevel()
+	{
+		return mSimdLevel;
+	}
+
+	void RectKernels::SetSimdLevel(eSimdLevel level)
+	{
+		DEBUG_BREAK(level <= detectSimdLevel());
+
+		mSimdLevel = level;
+	}
+
+	eSimdLevel RectKernels::detectSimdLevel()
+	{
+#if defined(CANVAS_X86) && defined(_MSC_VER)
+		int cpuInfo[4];
+
+		__cpuid(cpuInfo, 0);
+		const int MAX_LEAF = cpuInfo[0];
+
+		__cpuid(cpuInfo, 1);
+		const bool bSse2 = (cpuInfo[3] & (1 << 26)) != 0;
+		const bool bOsxsave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool bAvx = (cpuInfo[2] & (1 << 28)) != 0;
+
+		if (MAX_LEAF >= 7 && bOsxsave && bAvx && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(cpuInfo, 7, 0);
+
+			if ((cpuInfo[1] & (1 << 5)) != 0)
+			{
+				return eSimdLevel::Avx2;
+			}
+		}
+
+		return bSse2 ? eSimdLevel::Sse2 : eSimdLevel::Scalar;
+#elif defined(CANVAS_X86)
+		// Runs from a static initializer, before the compiler's own CPU model is set up.
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return eSimdLevel::Avx2;
+		}
+
+		return __builtin_cpu_supports("sse2") ? eSimdLevel::Sse2 : eSimdLevel::Scalar;
+#else
+		return eSimdLevel::Scalar;
+#endif
+	}
+
+	void RectKernels::ContainedInArea(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, const RectF& area, uint8_t* outMask)
+	{
+		switch (mSimdLevel)
+		{
+		case eSimdLevel::Avx2:
+			containedInAreaAvx2(lefts, tops, rights, bottoms, count, area, outMask);
+			break;
+		case eSimdLevel::Sse2:
+			containedInAreaSse2(lefts, tops, rights, bottoms, count, area, outMask);
+			break;
+		default:
+			containedInAreaScalar(lefts, tops, rights, bottoms, 0, count, area, outMask);
+			break;
+		}
+	}
+
+	void RectKernels::HitTest(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, float x, float y, float margin, uint8_t* outMask)
+	{
+		switch (mSimdLevel)
+		{
+		case eSimdLevel::Avx2:
+			hitTestAvx2(lefts, tops, rights, bottoms, count, x, y, margin, outMask);
+			break;
+		case eSimdLevel::Sse2:
+			hitTestSse2(lefts, tops, rights, bottoms, count, x, y, margin, outMask);
+			break;
+		default:
+			hitTestScalar(lefts, tops, rights, bottoms, 0, count, x, y, margin, outMask);
+			break;
+		}
+	}
+
+	void RectKernels::containedInAreaScalar(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t begin, size_t end, const RectF& area, uint8_t* outMask)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			outMask[i] = lefts[i] >= area.left && rights[i] <= area.right
+				&& tops[i] >= area.top && bottoms[i] <= area.bottom;
+		}
+	}
+
+	TARGET_SSE2 void RectKernels::containedInAreaSse2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, const RectF& area, uint8_t* outMask)
+	{
+#ifdef CANVAS_X86
+		const __m128 AREA_LEFT = _mm_set1_ps(area.left);
+		const __m128 AREA_TOP = _mm_set1_ps(area.top);
+		const __m128 AREA_RIGHT = _mm_set1_ps(area.right);
+		const __m128 AREA_BOTTOM = _mm_set1_ps(area.bottom);
+
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 contained = _mm_cmpge_ps(_mm_loadu_ps(lefts + i), AREA_LEFT);
+			contained = _mm_and_ps(contained, _mm_cmpge_ps(_mm_loadu_ps(tops + i), AREA_TOP));
+			contained = _mm_and_ps(contained, _mm_cmple_ps(_mm_loadu_ps(rights + i), AREA_RIGHT));
+			contained = _mm_and_ps(contained, _mm_cmple_ps(_mm_loadu_ps(bottoms + i), AREA_BOTTOM));
+
+			const int BITS = _mm_movemask_ps(contained);
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				outMask[i + j] = (BITS >> j) & 1;
+			}
+		}
+
+		containedInAreaScalar(lefts, tops, rights, bottoms, i, count, area, outMask);
+#else
+		containedInAreaScalar(lefts, tops, rights, bottoms, 0, count, area, outMask);
+#endif
+	}
+
+	TARGET_AVX2 void RectKernels::containedInAreaAvx2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, const RectF& area, uint8_t* outMask)
+	{
+#ifdef CANVAS_X86
+		const __m256 AREA_LEFT = _mm256_set1_ps(area.left);
+		const __m256 AREA_TOP = _mm256_set1_ps(area.top);
+		const __m256 AREA_RIGHT = _mm256_set1_ps(area.right);
+		const __m256 AREA_BOTTOM = _mm256_set1_ps(area.bottom);
+
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 contained = _mm256_cmp_ps(_mm256_loadu_ps(lefts + i), AREA_LEFT, _CMP_GE_OQ);
+			contained = _mm256_and_ps(contained, _mm256_cmp_ps(_mm256_loadu_ps(tops + i), AREA_TOP, _CMP_GE_OQ));
+			contained = _mm256_and_ps(contained, _mm256_cmp_ps(_mm256_loadu_ps(rights + i), AREA_RIGHT, _CMP_LE_OQ));
+			contained = _mm256_and_ps(contained, _mm256_cmp_ps(_mm256_loadu_ps(bottoms + i), AREA_BOTTOM, _CMP_LE_OQ));
+
+			const int BITS = _mm256_movemask_ps(contained);
+
+			for (size_t j = 0; j < 8; ++j)
+			{
+				outMask[i + j] = (BITS >> j) & 1;
+			}
+		}
+
+		containedInAreaScalar(lefts, tops, rights, bottoms, i, count, area, outMask);
+#else
+		containedInAreaScalar(lefts, tops, rights, bottoms, 0, count, area, outMask);
+#endif
+	}
+
+	void RectKernels::hitTestScalar(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t begin, size_t end, float x, float y, float margin, uint8_t* outMask)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const bool bOuter = x >= lefts[i] - margin && x <= rights[i] + margin
+				&& y >= tops[i] - margin && y <= bottoms[i] + margin;
+			const bool bInner = x > lefts[i] + margin && x < rights[i] - margin
+				&& y > tops[i] + margin && y < bottoms[i] - margin;
+
+			outMask[i] = (bOuter ? HIT_TEST_OUTER : HIT_TEST_NONE) | (bInner ? HIT_TEST_INNER : HIT_TEST_NONE);
+		}
+	}
+
+	TARGET_SSE2 void RectKernels::hitTestSse2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, float x, float y, float margin, uint8_t* outMask)
+	{
+#ifdef CANVAS_X86
+		const __m128 X = _mm_set1_ps(x);
+		const __m128 Y = _mm_set1_ps(y);
+		const __m128 MARGIN = _mm_set1_ps(margin);
+
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 LEFT = _mm_loadu_ps(lefts + i);
+			const __m128 TOP = _mm_loadu_ps(tops + i);
+			const __m128 RIGHT = _mm_loadu_ps(rights + i);
+			const __m128 BOTTOM = _mm_loadu_ps(bottoms + i);
+
+			__m128 outer = _mm_cmpge_ps(X, _mm_sub_ps(LEFT, MARGIN));
+			outer = _mm_and_ps(outer, _mm_cmple_ps(X, _mm_add_ps(RIGHT, MARGIN)));
+			outer = _mm_and_ps(outer, _mm_cmpge_ps(Y, _mm_sub_ps(TOP, MARGIN)));
+			outer = _mm_and_ps(outer, _mm_cmple_ps(Y, _mm_add_ps(BOTTOM, MARGIN)));
+
+			__m128 inner = _mm_cmpgt_ps(X, _mm_add_ps(LEFT, MARGIN));
+			inner = _mm_and_ps(inner, _mm_cmplt_ps(X, _mm_sub_ps(RIGHT, MARGIN)));
+			inner = _mm_and_ps(inner, _mm_cmpgt_ps(Y, _mm_add_ps(TOP, MARGIN)));
+			inner = _mm_and_ps(inner, _mm_cmplt_ps(Y, _mm_sub_ps(BOTTOM, MARGIN)));
+
+			const int OUTER_BITS = _mm_movemask_ps(outer);
+			const int INNER_BITS = _mm_movemask_ps(inner);
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				outMask[i + j] = static_cast<uint8_t>(((OUTER_BITS >> j) & 1) | (((INNER_BITS >> j) & 1) << 1));
+			}
+		}
+
+		hitTestScalar(lefts, tops, rights, bottoms, i, count, x, y, margin, outMask);
+#else
+		hitTestScalar(lefts, tops, rights, bottoms, 0, count, x, y, margin, outMask);
+#endif
+	}
+
+	TARGET_AVX2 void RectKernels::hitTestAvx2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+		size_t count, float x, float y, float margin, uint8_t* outMask)
+	{
+#ifdef CANVAS_X86
+		const __m256 X = _mm256_set1_ps(x);
+		const __m256 Y = _mm256_set1_ps(y);
+		const __m256 MARGIN = _mm256_set1_ps(margin);
+
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 LEFT = _mm256_loadu_ps(lefts + i);
+			const __m256 TOP = _mm256_loadu_ps(tops + i);
+			const __m256 RIGHT = _mm256_loadu_ps(rights + i);
+			const __m256 BOTTOM = _mm256_loadu_ps(bottoms + i);
+
+			__m256 outer = _mm256_cmp_ps(X, _mm256_sub_ps(LEFT, MARGIN), _CMP_GE_OQ);
+			outer = _mm256_and_ps(outer, _mm256_cmp_ps(X, _mm256_add_ps(RIGHT, MARGIN), _CMP_LE_OQ));
+			outer = _mm256_and_ps(outer, _mm256_cmp_ps(Y, _mm256_sub_ps(TOP, MARGIN), _CMP_GE_OQ));
+			outer = _mm256_and_ps(outer, _mm256_cmp_ps(Y, _mm256_add_ps(BOTTOM, MARGIN), _CMP_LE_OQ));
+
+			__m256 inner = _mm256_cmp_ps(X, _mm256_add_ps(LEFT, MARGIN), _CMP_GT_OQ);
+			inner = _mm256_and_ps(inner, _mm256_cmp_ps(X, _mm256_sub_ps(RIGHT, MARGIN), _CMP_LT_OQ));
+			inner = _mm256_and_ps(inner, _mm256_cmp_ps(Y, _mm256_add_ps(TOP, MARGIN), _CMP_GT_OQ));
+			inner = _mm256_and_ps(inner, _mm256_cmp_ps(Y, _mm256_sub_ps(BOTTOM, MARGIN), _CMP_LT_OQ));
+
+			const int OUTER_BITS = _mm256_movemask_ps(outer);
+			const int INNER_BITS = _mm256_movemask_ps(inner);
+
+			for (size_t j = 0; j < 8; ++j)
+			{
+				outMask[i + j] = static_cast<uint8_t>(((OUTER_BITS >> j) & 1) | (((INNER_BITS >> j) & 1) << 1));
+			}
+		}
+
+		hitTestScalar(lefts, tops, rights, bottoms, i, count, x, y, margin, outMask);
+#else
+		hitTestScalar(lefts, tops, rights, bottoms, 0, count, x, y, margin, outMask);
+#endif
+	}
+}
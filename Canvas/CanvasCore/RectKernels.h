@@ -0,0 +1,52 @@
+#pragma once
+
+namespace canvas
+{
+	enum class eSimdLevel
+	{
+		Scalar,
+		Sse2,
+		Avx2,
+	};
+
+	enum eHitTestMask : uint8_t
+	{
+		HIT_TEST_NONE = 0,
+		HIT_TEST_OUTER = 1 << 0,
+		HIT_TEST_INNER = 1 << 1,
+	};
+
+	class RectKernels final
+	{
+	public:
+		static eSimdLevel GetSimdLevel();
+		static void SetSimdLevel(eSimdLevel level);
+
+		static void ContainedInArea(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, const RectF& area, uint8_t* outMask);
+		static void HitTest(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, float x, float y, float margin, uint8_t* outMask);
+
+	private:
+		RectKernels() = delete;
+
+		static eSimdLevel detectSimdLevel();
+
+		static void containedInAreaScalar(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t begin, size_t end, const RectF& area, uint8_t* outMask);
+		static void containedInAreaSse2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, const RectF& area, uint8_t* outMask);
+		static void containedInAreaAvx2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, const RectF& area, uint8_t* outMask);
+
+		static void hitTestScalar(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t begin, size_t end, float x, float y, float margin, uint8_t* outMask);
+		static void hitTestSse2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, float x, float y, float margin, uint8_t* outMask);
+		static void hitTestAvx2(const float* lefts, const float* tops, const float* rights, const float* bottoms,
+			size_t count, float x, float y, float margin, uint8_t* outMask);
+
+	private:
+		static eSimdLevel mSimdLevel;
+	};
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace canvas
+{
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() = default;
+
+		virtual void BeginFrame() = 0;
+		virtual bool EndFrame() = 0;
+
+		virtual void Clear(const ColorF& color) = 0;
+		virtual void PushClip(const RectF& rect) = 0;
+		virtual void PopClip() = 0;
+
+		virtual void FillRect(const RectF& rect, const ColorF& color) = 0;
+		virtual void StrokeRect(const RectF& rect, const ColorF& color, float strokeWidth) = 0;
+		virtual void FillRects(const RectF* rects, size_t count, const ColorF& color) = 0;
+		virtual void StrokeRects(const RectF* rects, size_t count, const ColorF& color, float strokeWidth) = 0;
+		virtual void DrawLabel(const RectF& rect, const char* text, const ColorF& color) = 0;
+		// Opaque width x height pixels packed as R | G << 8 | B << 16 | A << 24, stride pixels
+		// apart from one row to the next, scaled to rect. pixels must stay valid until EndFrame.
+		virtual void DrawBitmap(const RectF& rect, const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t stride) = 0;
+	};
+}
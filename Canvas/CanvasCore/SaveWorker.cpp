@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "SaveWorker.h"
+#include "SceneFile.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	SaveWorker::SaveWorker()
+		: mbBusy(false)
+	{
+	}
+
+	SaveWorker::~SaveWorker()
+	{
+		Wait();
+	}
+
+	bool SaveWorker::Start(const char* path, const std::shared_ptr<ObjectSnapshot>& snapshot, const std::function<void(bool)>& onCompleted)
+	{
+		if (IsBusy())
+		{
+			return false;
+		}
+
+		Wait();
+		mbBusy.store(true, std::memory_order_release);
+
+		mThread = std::thread([this, path = std::string(path), snapshot, onCompleted]()
+		{
+			Tracer::SetThreadName("save");
+
+			bool bSucceeded;
+
+			{
+				TraceScope scope("save");
+				bSucceeded = SceneFile::Write(path.c_str(), *snapshot);
+			}
+
+			mbBusy.store(false, std::memory_order_release);
+
+			if (onCompleted)
+			{
+				onCompleted(bSucceeded);
+			}
+		});
+
+		return true;
+	}
+
+	void SaveWorker::Wait()
+	{
+		if (mThread.joinable())
+		{
+			mThread.join();
+		}
+	}
+}
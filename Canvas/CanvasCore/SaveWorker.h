@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ObjectSnapshot.h"
+
+namespace canvas
+{
+	// Writes one snapshot at a time to a scene file on its own thread.
+	// onCompleted runs on that thread once the file is on disk or has failed.
+	class SaveWorker final
+	{
+	public:
+		SaveWorker();
+		~SaveWorker();
+		SaveWorker(const SaveWorker& other) = delete;
+		SaveWorker& operator=(const SaveWorker& rhs) = delete;
+
+		bool Start(const char* path, const std::shared_ptr<ObjectSnapshot>& snapshot, const std::function<void(bool)>& onCompleted);
+		void Wait();
+
+		inline bool IsBusy() const;
+
+	private:
+		std::thread mThread;
+		std::atomic<bool> mbBusy;
+	};
+
+	inline bool SaveWorker::IsBusy() const
+	{
+		return mbBusy.load(std::memory_order_acquire);
+	}
+}
@@ -0,0 +1,2100 @@
+#include "pch.h"
+#include "Scene.h"
+
+namespace canvas
+{
+	Scene::Scene(uint32_t width, uint32_t height)
+		: mWidth(width)
+		, mHeight(height)
+		, mbLButtonDown(false)
+		, mbDragging(false)
+		, mStartPoint{ NONE_POINT, NONE_POINT }
+		, mEndPoint{ NONE_POINT, NONE_POINT }
+		, mCurrMode(eMouseMode::Select)
+		, mSelectedObjects(mObjects)
+		, mJournal(UNDO_JOURNAL_BUDGET)
+		, mObjectGrid(GRID_CELL_SIZE)
+		, mSelectedResizingRect(nullptr)
+		, mResizingDirection(eResizingDirection::None)
+		, mVisibleResizingRects(0)
+		, mbSelectionVisible(false)
+		, mPaintOrderVersion(UINT64_MAX)
+		, mStaticLayer(0, 0)
+		, mbStaticLayerValid(false)
+		, mDragBounds{ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX }
+		, mDragOrigin{ 0.f, 0.f, 0.f, 0.f }
+		, mRenderStats{ 0, 0, 0, 0, 0, 0 }
+		, mbProfilerVisible(false)
+	{
+		mCopiedObjectInfo.reserve(DEFAULT_OBJECT_CAPACITY);
+
+		mDragSelectionArea = new Object(MakeColor(0x000000, 0.3f), MakeColor(0x6495ED, 0.2f));
+		mSelectedBoundary = new Object(MakeColor(0x0000FF, 1.f), MakeColor(0xFFFFFF, 0.f));
+		mNewObjectArea = new Object(MakeColor(0x000000, 1.f), MakeColor(0xFFFFFF, 0.f));
+
+		for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
+		{
+			mResizingRects[i] = new Object(MakeColor(0x0000FF, 1.f), MakeColor(0xFFFFFF, 1.0f));
+		}
+
+		for (RectF& rect : mPrevChromeRects)
+		{
+			rect = { NONE_POINT, NONE_POINT, NONE_POINT, NONE_POINT };
+		}
+	}
+
+	Scene::~Scene()
+	{
+		if (mbProfilerVisible)
+		{
+			Profiler::Disable();
+		}
+
+		for (auto obj : mResizingRects)
+		{
+			delete obj;
+		}
+
+		delete mSelectedBoundary;
+		delete mDragSelectionArea;
+		delete mNewObjectArea;
+	}
+
+	eCursor Scene::MouseDown(float x, float y)
+	{
+		DEBUG_BREAK(!mbLButtonDown);
+		mbLButtonDown = true;
+		mbStaticLayerValid = false;
+		mStartPoint = mCamera.ToWorld(x, y);
+
+		eCursor cursor = eCursor::Unchanged;
+
+		switch (mCurrMode)
+		{
+		case eMouseMode::Select:
+		case eMouseMode::Selected:
+		{
+			Object* chrome = getSelectionChromeOnCursor(mStartPoint.x, mStartPoint.y);
+			ObjectHandle selected = INVALID_OBJECT_HANDLE;
+
+			if (chrome == nullptr)
+			{
+				selected = GetObjectOnCursor(mStartPoint.x, mStartPoint.y);
+			}
+
+			if (chrome == nullptr && selected == INVALID_OBJECT_HANDLE)
+			{
+				hideSelectionBoundary();
+				mCurrMode = eMouseMode::Select;
+				break;
+			}
+			else if (mResizingDirection != eResizingDirection::None)
+			{
+				mCurrMode = eMouseMode::Resize;
+				cursor = getResizingCursor(mResizingDirection);
+				break;
+			}
+			else if (chrome == mSelectedBoundary)
+			{
+				cursor = eCursor::SizeAll;
+				break;
+			}
+
+			mSelectedObjects.Clear();
+
+			cursor = eCursor::SizeAll;
+			mSelectedObjects.Insert(selected);
+
+			const float MARGIN = SELECTED_RECT_MARGIN / mCamera.GetZoom();
+			RectF rect = mObjects.GetRect(mObjects.GetIndex(selected));
+			ADD_MARGIN_TO_RECT(rect, MARGIN);
+			mSelectedBoundary->SetRect(rect);
+			mbSelectionVisible = true;
+
+			mCurrMode = eMouseMode::Selected;
+		}
+			break;
+		case eMouseMode::Rect:
+			cursor = eCursor::Cross;
+			hideSelectionBoundary();
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+
+		return cursor;
+	}
+
+	eCursor Scene::MouseMove(float x, float y)
+	{
+		eCursor cursor = eCursor::Unchanged;
+		const PointF POINT = mCamera.ToWorld(x, y);
+
+		if (mbLButtonDown)
+		{
+			mEndPoint = POINT;
+			mbDragging = true;
+
+			switch (mCurrMode)
+			{
+			case eMouseMode::Select:
+				mDragSelectionArea->SetLeftTop(mStartPoint);
+				mDragSelectionArea->SetRightBottom(mEndPoint);
+
+				addObjectsInDraggingArea();
+
+				updateSelectionBoundary();
+				break;
+			case eMouseMode::Selected:
+				cursor = eCursor::SizeAll;
+
+				moveSelectedObjects(mEndPoint.x - mStartPoint.x, mEndPoint.y - mStartPoint.y);
+
+				mStartPoint.x = mEndPoint.x;
+				mStartPoint.y = mEndPoint.y;
+				break;
+			case eMouseMode::Resize:
+				cursor = getResizingCursor(mResizingDirection);
+
+				resizeSelectedObjects();
+				break;
+			case eMouseMode::Rect:
+				cursor = eCursor::Cross;
+				mNewObjectArea->SetLeftTop(mStartPoint);
+				mNewObjectArea->SetRightBottom(mEndPoint);
+				break;
+			default:
+				DEBUG_BREAK(false);
+				break;
+			}
+		}
+		else
+		{
+			switch (mCurrMode)
+			{
+			case eMouseMode::Select:
+			case eMouseMode::Selected:
+				if (getSelectionChromeOnCursor(POINT.x, POINT.y) != nullptr || GetObjectOnCursor(POINT.x, POINT.y) != INVALID_OBJECT_HANDLE)
+				{
+					cursor = getResizingCursor(mResizingDirection);
+				}
+				break;
+			case eMouseMode::Rect:
+				cursor = eCursor::Cross;
+				break;
+			default:
+				DEBUG_BREAK(false);
+				break;
+			}
+		}
+
+		return cursor;
+	}
+
+	eCursor Scene::MouseUp()
+	{
+		DEBUG_BREAK(mbLButtonDown);
+
+		eCursor cursor = eCursor::Unchanged;
+
+		commitDragTransform();
+
+		// The drag drew the selection over everything; put it back in paint
+		// order, and drop the tiles it went over now that they are drawn again.
+		if (mDragBounds.left <= mDragBounds.right)
+		{
+			RectF bounds;
+
+			if (mSelectedObjects.GetBounds(bounds))
+			{
+				mDamage.Add(mCamera.ToScreen(bounds), mObjects.GetMaxStrokeWidth() * mCamera.GetZoom() / 2 + DAMAGE_MARGIN);
+			}
+
+			mTilePyramid.Invalidate(mDragBounds, mObjects.GetMaxStrokeWidth() / 2);
+			mDragBounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+		}
+
+		mbStaticLayerValid = false;
+
+		switch (mCurrMode)
+		{
+		case eMouseMode::Select:
+			mMarqueeSelector.End();
+
+			if (mSelectedObjects.GetCount() > 0)
+			{
+				mCurrMode = eMouseMode::Selected;
+			}
+
+			SET_NONE_RECT(mDragSelectionArea);
+			break;
+		case eMouseMode::Selected:
+			if (mSelectedObjects.GetCount() > 0)
+			{
+				cursor = eCursor::SizeAll;
+				mCurrMode = eMouseMode::Selected;
+			}
+			break;
+		case eMouseMode::Resize:
+			mCurrMode = eMouseMode::Selected;
+			mSelectedResizingRect = nullptr;
+			mResizingDirection = eResizingDirection::None;
+			break;
+		case eMouseMode::Rect:
+			addObject();
+
+			SET_NONE_RECT(mNewObjectArea);
+
+			mCurrMode = eMouseMode::Select;
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+
+		mbLButtonDown = false;
+		mbDragging = false;
+
+		mJournal.Seal();
+
+		return cursor;
+	}
+
+	void Scene::SetMode(eMouseMode mode)
+	{
+		commitDragTransform();
+		mCurrMode = mode;
+	}
+
+	void Scene::CopySelectedObjects()
+	{
+		commitDragTransform();
+
+		mCopiedObjectInfo.clear();
+
+		auto center = mSelectedBoundary->GetCenter();
+
+		mZOrderHandles.assign(mSelectedObjects.begin(), mSelectedObjects.end());
+		sortByZOrder(mZOrderHandles);
+
+		for (auto handle : mZOrderHandles)
+		{
+			const size_t index = mObjects.GetIndex(handle);
+			const RectF rect = mObjects.GetRect(index);
+
+			mCopiedObjectInfo.push_back({
+				rect.left - center.x,
+				rect.top - center.y,
+				rect.right - rect.left,
+				rect.bottom - rect.top,
+				mObjects.GetLineColor(index),
+				mObjects.GetBackgroundColor(index),
+				mObjects.GetStrokeWidth(index)
+			});
+		}
+	}
+
+	void Scene::PasteCopiedObjects(float x, float y)
+	{
+		mMarqueeSelector.End();
+		commitDragTransform();
+
+		const std::vector<ObjectInfo>& infos = mCopiedObjectInfo;
+		const size_t FIRST = mObjects.AddRange(infos.size(), [&infos, x, y](size_t i, RectF& rect, ColorF& lineColor, ColorF& backgroundColor, float& strokeWidth)
+		{
+			const ObjectInfo& info = infos[i];
+			const float LEFT = x + info.leftFromCenter;
+			const float TOP = y + info.topFromCenter;
+
+			rect = { LEFT, TOP, LEFT + info.width, TOP + info.height };
+			lineColor = info.lineColor;
+			backgroundColor = info.backgroundColor;
+			strokeWidth = info.strokeWidth;
+		});
+
+		addObjectRange(FIRST, infos.size());
+		recordRange(FIRST, infos.size());
+	}
+
+	void Scene::DuplicateSelectedObjects()
+	{
+		mMarqueeSelector.End();
+		commitDragTransform();
+
+		mZOrderHandles.assign(mSelectedObjects.begin(), mSelectedObjects.end());
+		sortByZOrder(mZOrderHandles);
+
+		const ObjectStore& objects = mObjects;
+		const auto SOURCES = mZOrderHandles.begin();
+		const size_t COUNT = mZOrderHandles.size();
+
+		const size_t FIRST = mObjects.AddRange(COUNT, [&objects, SOURCES](size_t i, RectF& rect, ColorF& lineColor, ColorF& backgroundColor, float& strokeWidth)
+		{
+			const size_t INDEX = objects.GetIndex(SOURCES[i]);
+
+			rect = objects.GetRect(INDEX);
+			rect.left += OBJECT_MARGIN;
+			rect.top += OBJECT_MARGIN;
+			rect.right += OBJECT_MARGIN;
+			rect.bottom += OBJECT_MARGIN;
+			lineColor = objects.GetLineColor(INDEX);
+			backgroundColor = objects.GetBackgroundColor(INDEX);
+			strokeWidth = objects.GetStrokeWidth(INDEX);
+		});
+
+		addObjectRange(FIRST, COUNT);
+		recordRange(FIRST, COUNT);
+	}
+
+	void Scene::RemoveSelectedObjects()
+	{
+		mMarqueeSelector.End();
+		commitDragTransform();
+
+		JournalEntry entry;
+		recordSelection(eJournalOperation::Remove, entry);
+
+		eraseSelectedObjects();
+	}
+
+	void Scene::BringToFront()
+	{
+		stackSelectedObjects(true);
+	}
+
+	void Scene::SendToBack()
+	{
+		stackSelectedObjects(false);
+	}
+
+	void Scene::BringForward()
+	{
+		stepSelectedObjects(true);
+	}
+
+	void Scene::SendBackward()
+	{
+		stepSelectedObjects(false);
+	}
+
+	bool Scene::Undo()
+	{
+		JournalEntry entry;
+
+		if (mbLButtonDown || !mJournal.Undo(entry))
+		{
+			return false;
+		}
+
+		applyEntry(entry, true);
+
+		return true;
+	}
+
+	bool Scene::Redo()
+	{
+		JournalEntry entry;
+
+		if (mbLButtonDown || !mJournal.Redo(entry))
+		{
+			return false;
+		}
+
+		applyEntry(entry, false);
+
+		return true;
+	}
+
+	void Scene::SetUndoBudget(size_t budget)
+	{
+		mJournal.SetBudget(budget);
+	}
+
+	// Runs a shortcut that only involves the scene. Returns false for the ones
+	// left to the caller, such as Save and Open; x and y are where Paste lands.
+	bool Scene::RunCommand(eCommand command, float x, float y)
+	{
+		TraceScope scope("command");
+
+		switch (command)
+		{
+		case eCommand::SelectMode:
+			SetMode(eMouseMode::Select);
+			break;
+		case eCommand::RectMode:
+			SetMode(eMouseMode::Rect);
+			break;
+		case eCommand::Remove:
+			RemoveSelectedObjects();
+			break;
+		case eCommand::Copy:
+			CopySelectedObjects();
+			break;
+		case eCommand::Paste:
+		{
+			const PointF POINT = mCamera.ToWorld(x, y);
+			PasteCopiedObjects(POINT.x, POINT.y);
+		}
+			break;
+		case eCommand::Duplicate:
+			DuplicateSelectedObjects();
+			break;
+		case eCommand::BringToFront:
+			BringToFront();
+			break;
+		case eCommand::SendToBack:
+			SendToBack();
+			break;
+		case eCommand::BringForward:
+			BringForward();
+			break;
+		case eCommand::SendBackward:
+			SendBackward();
+			break;
+		case eCommand::Undo:
+			Undo();
+			break;
+		case eCommand::Redo:
+			Redo();
+			break;
+		case eCommand::ToggleProfiler:
+			ToggleProfiler();
+			break;
+		default:
+			return false;
+		}
+
+		return true;
+	}
+
+	void Scene::ToggleProfiler()
+	{
+		mbProfilerVisible = !mbProfilerVisible;
+		mDamage.Add(getProfilerOverlayRect(), 0.f);
+
+		if (mbProfilerVisible)
+		{
+			Profiler::Enable();
+		}
+		else
+		{
+			Profiler::Disable();
+		}
+	}
+
+	void Scene::Pan(float x, float y)
+	{
+		if (mCamera.Pan(x, y))
+		{
+			updateCamera();
+		}
+	}
+
+	void Scene::Zoom(float factor, float x, float y)
+	{
+		if (mCamera.Zoom(factor, x, y))
+		{
+			updateCamera();
+		}
+	}
+
+	void Scene::ResetCamera()
+	{
+		mCamera.Reset();
+		updateCamera();
+	}
+
+	// Below threshold zoom, frames draw pre-rasterized tiles; zero turns them off.
+	void Scene::SetLodThreshold(float threshold)
+	{
+		mTilePyramid.SetThreshold(threshold);
+		mDamage.AddAll();
+	}
+
+	void Scene::eraseSelectedObjects()
+	{
+		RectF bounds;
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+
+		for (auto handle : mSelectedObjects)
+		{
+			DEBUG_BREAK(mObjects.IsValid(handle));
+
+			mObjectGrid.Remove(handle);
+			mObjects.Remove(handle);
+		}
+
+		mSelectedObjects.Clear();
+
+		hideSelectionBoundary();
+		mCurrMode = eMouseMode::Select;
+	}
+
+	bool Scene::Save(const char* path)
+	{
+		if (mSaveWorker.IsBusy())
+		{
+			return false;
+		}
+
+		mTilePyramid.Cancel();
+		commitDragTransform();
+
+		return SceneFile::Write(path, *mObjects.TakeSnapshot());
+	}
+
+	// Only the snapshot is taken here; the file is written on the save worker
+	// while editing continues.
+	bool Scene::SaveAsync(const char* path, const std::function<void(bool)>& onCompleted)
+	{
+		if (mSaveWorker.IsBusy())
+		{
+			return false;
+		}
+
+		mTilePyramid.Cancel();
+		commitDragTransform();
+
+		return mSaveWorker.Start(path, mObjects.TakeSnapshot(), onCompleted);
+	}
+
+	bool Scene::Load(const char* path)
+	{
+		mMarqueeSelector.End();
+		commitDragTransform();
+		mTilePyramid.Clear();
+		mbStaticLayerValid = false;
+
+		if (!SceneFile::Read(path, mObjects))
+		{
+			return false;
+		}
+
+		mSelectedObjects.Clear();
+		mObjectGrid.Clear();
+		mObjectGrid.InsertRange(mObjects, 0, mObjects.GetCount());
+		mJournal.Clear();
+		mObjects.ReleaseStaleZKeys();
+
+		hideSelectionBoundary();
+		mCurrMode = eMouseMode::Select;
+
+		Invalidate({ 0.f, 0.f, static_cast<float>(mWidth), static_cast<float>(mHeight) });
+
+		return true;
+	}
+
+	ObjectHandle Scene::AddObject(const RectF& rect, const ColorF& lineColor, const ColorF& backgroundColor, float strokeWidth)
+	{
+		mMarqueeSelector.End();
+
+		ObjectHandle handle = mObjects.Add(rect, lineColor, backgroundColor, strokeWidth);
+
+		mObjectGrid.Insert(handle, rect, backgroundColor.a > 0.f);
+		addObjectDamage(rect);
+		recordRange(mObjects.GetIndex(handle), 1);
+
+		return handle;
+	}
+
+	void Scene::addObjectRange(size_t first, size_t count)
+	{
+		mObjectGrid.InsertRange(mObjects, first, count);
+
+		mBatchHandles.resize(count);
+
+		ParallelFor(count, [this, first](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				mBatchHandles[i] = mObjects.GetHandle(first + i);
+			}
+		});
+
+		mSelectedObjects.Assign(mBatchHandles);
+
+		updateSelectionBoundary();
+
+		if (mbSelectionVisible)
+		{
+			addObjectDamage(mSelectedBoundary->mRect);
+		}
+	}
+
+	ObjectHandle Scene::GetObjectOnCursor(float x, float y)
+	{
+		ProfileScope scope(eProfileTimer::HitTest);
+		size_t candidatesCount = 0;
+		const ObjectHandle* candidates = mObjectGrid.GetCandidates(x, y, candidatesCount);
+		size_t firstDragged = candidatesCount;
+
+		// The grid still files a dragged selection where the drag began, so it
+		// is tested on its own, where it is drawn.
+		if (!mDragTransform.IsIdentity())
+		{
+			mHitCandidates.clear();
+
+			for (size_t i = 0; i < candidatesCount; ++i)
+			{
+				if (!mSelectedObjects.Contains(candidates[i]))
+				{
+					mHitCandidates.push_back(candidates[i]);
+				}
+			}
+
+			firstDragged = mHitCandidates.size();
+			mHitCandidates.insert(mHitCandidates.end(), mSelectedObjects.begin(), mSelectedObjects.end());
+
+			candidates = mHitCandidates.data();
+			candidatesCount = mHitCandidates.size();
+		}
+
+		if (candidatesCount == 0)
+		{
+			return INVALID_OBJECT_HANDLE;
+		}
+
+		const size_t COUNT = candidatesCount;
+		Profiler::Count(eProfileCounter::ObjectsScanned, COUNT);
+		mCandidateEdges.resize(COUNT * 4);
+		mObjectMask.resize(COUNT);
+
+		float* lefts = mCandidateEdges.data();
+		float* tops = lefts + COUNT;
+		float* rights = tops + COUNT;
+		float* bottoms = rights + COUNT;
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			RectF rect = mObjects.GetRect(mObjects.GetIndex(candidates[i]));
+
+			if (i >= firstDragged)
+			{
+				rect = mDragTransform.Apply(rect);
+			}
+
+			lefts[i] = rect.left;
+			tops[i] = rect.top;
+			rights[i] = rect.right;
+			bottoms[i] = rect.bottom;
+		}
+
+		RectKernels::HitTest(lefts, tops, rights, bottoms, COUNT, x, y, getHitMargin(), mObjectMask.data());
+
+		ObjectHandle hit = INVALID_OBJECT_HANDLE;
+		size_t hitIndex = 0;
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			if ((mObjectMask[i] & HIT_TEST_OUTER) == 0)
+			{
+				continue;
+			}
+
+			const size_t INDEX = mObjects.GetIndex(candidates[i]);
+
+			// Hollow objects are only hit on their edge bands, never deep inside.
+			if (((mObjectMask[i] & HIT_TEST_INNER) == 0 || mObjects.IsFilled(INDEX))
+				&& (hit == INVALID_OBJECT_HANDLE || mObjects.IsAbove(INDEX, hitIndex)))
+			{
+				hit = candidates[i];
+				hitIndex = INDEX;
+			}
+		}
+
+		return hit;
+	}
+
+	void Scene::Invalidate(const RectF& rect)
+	{
+		mDamage.Add(rect, 0.f);
+	}
+
+	// Every call ends a profiler frame, whether or not anything was damaged.
+	// Tiles the frame asked for start building once it is drawn.
+	bool Scene::Render(RenderBackend& backend)
+	{
+		bool bSucceeded;
+
+		{
+			ProfileScope scope(eProfileTimer::Render);
+			mTilePyramid.Update();
+			bSucceeded = renderDamage(backend);
+			mTilePyramid.Build(mObjects);
+		}
+
+		Profiler::EndFrame();
+
+		return bSucceeded;
+	}
+
+	bool Scene::renderDamage(RenderBackend& backend)
+	{
+		if (mbDragging)
+		{
+			switch (mCurrMode)
+			{
+			case eMouseMode::Select:
+				mDragSelectionArea->SetLeftTop(mStartPoint);
+				mDragSelectionArea->SetRightBottom(mEndPoint);
+				break;
+			case eMouseMode::Rect:
+				mNewObjectArea->SetLeftTop(mStartPoint);
+				mNewObjectArea->SetRightBottom(mEndPoint);
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (mbSelectionVisible)
+		{
+			setResizingRectsPoint();
+		}
+		else
+		{
+			setResizingRectsNone();
+		}
+
+		addChromeDamage();
+
+		if (mbProfilerVisible)
+		{
+			mDamage.Add(getProfilerOverlayRect(), 0.f);
+		}
+
+		mRenderStats = { 0, 0, 0, 0, 0, 0 };
+
+		if (mDamage.IsEmpty())
+		{
+			return true;
+		}
+
+		backend.BeginFrame();
+		{
+			// Objects are looked up in world space; strokes reach half their
+			// width past the rect, and a pixel of antialiasing past that.
+			const float MARGIN = mObjects.GetMaxStrokeWidth() / 2 + DAMAGE_MARGIN / mCamera.GetZoom();
+			const bool bLayer = isDraggingSelection();
+			const bool bTiles = mTilePyramid.IsActive(mCamera.GetZoom());
+
+			if (bLayer && !mbStaticLayerValid)
+			{
+				buildStaticLayer(MARGIN);
+			}
+
+			if (mDamage.IsFull())
+			{
+				const RectF VIEWPORT = { 0.f, 0.f, static_cast<float>(mWidth), static_cast<float>(mHeight) };
+				uint32_t drawn;
+
+				if (bLayer)
+				{
+					drawStaticLayer(backend, VIEWPORT);
+					mDrawCommands.Reset(VIEWPORT);
+					drawn = drawLiveObjects(mCamera.ToWorld(VIEWPORT), MARGIN);
+				}
+				else if (bTiles)
+				{
+					backend.Clear(MakeColor(0xFFFFFF, 1.f));
+					drawn = drawTiles(backend, VIEWPORT, MARGIN);
+					mDrawCommands.Reset(VIEWPORT);
+				}
+				else
+				{
+					backend.Clear(MakeColor(0xFFFFFF, 1.f));
+					mDrawCommands.Reset(VIEWPORT);
+					getVisibleObjects(mCamera.ToWorld(VIEWPORT), MARGIN, mDirtyObjects);
+
+					for (uint32_t index : mDirtyObjects)
+					{
+						drawObject(index);
+					}
+
+					drawn = static_cast<uint32_t>(mDirtyObjects.size());
+				}
+
+				drawChrome();
+				mDrawCommands.Submit(backend, mRenderStats);
+
+				mRenderStats.dirtyRectsCount = 1;
+				mRenderStats.objectsRedrawn = drawn;
+				mRenderStats.pixelsRedrawn = static_cast<uint64_t>(mWidth) * mHeight;
+			}
+			else
+			{
+				for (const RectF& dirty : mDamage.GetRects())
+				{
+					uint32_t drawn;
+
+					backend.PushClip(dirty);
+
+					if (bLayer)
+					{
+						drawStaticLayer(backend, dirty);
+						mDrawCommands.Reset(dirty);
+						drawn = drawLiveObjects(mCamera.ToWorld(dirty), MARGIN);
+					}
+					else if (bTiles)
+					{
+						backend.Clear(MakeColor(0xFFFFFF, 1.f));
+						drawn = drawTiles(backend, dirty, MARGIN);
+						mDrawCommands.Reset(dirty);
+					}
+					else
+					{
+						backend.Clear(MakeColor(0xFFFFFF, 1.f));
+						mDrawCommands.Reset(dirty);
+						getObjectsInRect(mCamera.ToWorld(dirty), MARGIN, mDirtyObjects);
+
+						for (uint32_t index : mDirtyObjects)
+						{
+							drawObject(index);
+						}
+
+						drawn = static_cast<uint32_t>(mDirtyObjects.size());
+					}
+
+					drawChrome();
+					mDrawCommands.Submit(backend, mRenderStats);
+
+					backend.PopClip();
+
+					const float WIDTH = (std::min)(dirty.right, static_cast<float>(mWidth)) - (std::max)(dirty.left, 0.f);
+					const float HEIGHT = (std::min)(dirty.bottom, static_cast<float>(mHeight)) - (std::max)(dirty.top, 0.f);
+
+					++mRenderStats.dirtyRectsCount;
+					mRenderStats.objectsRedrawn += drawn;
+					mRenderStats.pixelsRedrawn += WIDTH > 0 && HEIGHT > 0 ? static_cast<uint64_t>(WIDTH * HEIGHT) : 0;
+				}
+			}
+		}
+
+		if (mbProfilerVisible)
+		{
+			drawProfilerOverlay(backend);
+		}
+
+		mDamage.Reset();
+
+		Profiler::Count(eProfileCounter::ObjectsDrawn, mRenderStats.objectsRedrawn);
+		Profiler::Count(eProfileCounter::DrawCommands, mRenderStats.commandsCount);
+		Profiler::Count(eProfileCounter::BrushChanges, mRenderStats.stateChangesCount);
+
+		return backend.EndFrame();
+	}
+
+	// Shows the last finished frame and the percentiles of all frames so far.
+	void Scene::drawProfilerOverlay(RenderBackend& backend)
+	{
+		const RectF OVERLAY = getProfilerOverlayRect();
+		const ColorF TEXT_COLOR = MakeColor(0xFFFFFF, 1.f);
+
+		RectF line = { OVERLAY.left + 8.f, OVERLAY.top + 4.f, OVERLAY.right - 8.f, OVERLAY.top + 4.f + PROFILER_OVERLAY_LINE_HEIGHT };
+		char text[PROFILER_LABEL_LENGTH];
+
+		backend.FillRect(OVERLAY, MakeColor(0x000000, 0.75f));
+
+		snprintf(text, sizeof(text), "%-20s %10s %10s %10s", "frame", "last", "p50", "p99");
+		backend.DrawLabel(line, text, TEXT_COLOR);
+
+		for (size_t i = 0; i < static_cast<size_t>(eProfileTimer::Count); ++i)
+		{
+			const eProfileTimer TIMER = static_cast<eProfileTimer>(i);
+			const HdrHistogram& histogram = Profiler::GetHistogram(TIMER);
+
+			line.top += PROFILER_OVERLAY_LINE_HEIGHT;
+			line.bottom += PROFILER_OVERLAY_LINE_HEIGHT;
+
+			snprintf(text, sizeof(text), "%-17s ms %10.3f %10.3f %10.3f", Profiler::GetName(TIMER),
+				Profiler::GetLastFrameValue(TIMER) / 1e6, histogram.GetPercentile(50.0) / 1e6, histogram.GetPercentile(99.0) / 1e6);
+			backend.DrawLabel(line, text, TEXT_COLOR);
+		}
+
+		for (size_t i = 0; i < static_cast<size_t>(eProfileCounter::Count); ++i)
+		{
+			const eProfileCounter COUNTER = static_cast<eProfileCounter>(i);
+			const HdrHistogram& histogram = Profiler::GetHistogram(COUNTER);
+
+			line.top += PROFILER_OVERLAY_LINE_HEIGHT;
+			line.bottom += PROFILER_OVERLAY_LINE_HEIGHT;
+
+			snprintf(text, sizeof(text), "%-20s %10llu %10llu %10llu", Profiler::GetName(COUNTER),
+				static_cast<unsigned long long>(Profiler::GetLastFrameValue(COUNTER)),
+				static_cast<unsigned long long>(histogram.GetPercentile(50.0)),
+				static_cast<unsigned long long>(histogram.GetPercentile(99.0)));
+			backend.DrawLabel(line, text, TEXT_COLOR);
+		}
+	}
+
+	// Zoomed out, each tile of the pyramid stands in for the objects under it.
+	// A tile that is not built yet is drawn from its objects, clipped to it.
+	// Returns how many objects were drawn that way.
+	uint32_t Scene::drawTiles(RenderBackend& backend, const RectF& clip, float margin)
+	{
+		const uint32_t LEVEL = mTilePyramid.GetLevel(mCamera.GetZoom());
+		const RectF WORLD = mCamera.ToWorld(clip);
+		const int LEFT = mTilePyramid.GetTileCoord(WORLD.left, LEVEL);
+		const int TOP = mTilePyramid.GetTileCoord(WORLD.top, LEVEL);
+		const int RIGHT = mTilePyramid.GetTileCoord(WORLD.right, LEVEL);
+		const int BOTTOM = mTilePyramid.GetTileCoord(WORLD.bottom, LEVEL);
+		uint32_t drawn = 0;
+
+		for (int y = TOP; y <= BOTTOM; ++y)
+		{
+			for (int x = LEFT; x <= RIGHT; ++x)
+			{
+				const RectF TILE = mCamera.ToScreen(mTilePyramid.GetTileRect(LEVEL, x, y));
+				const uint32_t* pixels = mTilePyramid.FindTile(LEVEL, x, y);
+
+				if (pixels != nullptr)
+				{
+					backend.DrawBitmap(TILE, pixels, LOD_TILE_SIZE, LOD_TILE_SIZE, LOD_TILE_SIZE);
+					continue;
+				}
+
+				const RectF AREA = {
+					(std::max)(TILE.left, clip.left),
+					(std::max)(TILE.top, clip.top),
+					(std::min)(TILE.right, clip.right),
+					(std::min)(TILE.bottom, clip.bottom)
+				};
+
+				backend.PushClip(AREA);
+				mDrawCommands.Reset(AREA);
+				getObjectsInRect(mCamera.ToWorld(AREA), margin, mDirtyObjects);
+
+				for (uint32_t index : mDirtyObjects)
+				{
+					drawObject(index);
+				}
+
+				mDrawCommands.Submit(backend, mRenderStats);
+				backend.PopClip();
+
+				drawn += static_cast<uint32_t>(mDirtyObjects.size());
+			}
+		}
+
+		return drawn;
+	}
+
+	// Everything but the selection, drawn once when a drag starts; the
+	// selection is drawn over it, live, on every frame of the drag.
+	void Scene::buildStaticLayer(float margin)
+	{
+		const RectF VIEWPORT = { 0.f, 0.f, static_cast<float>(mWidth), static_cast<float>(mHeight) };
+
+		if (mStaticLayer.GetWidth() != mWidth || mStaticLayer.GetHeight() != mHeight)
+		{
+			mStaticLayer.Resize(mWidth, mHeight);
+		}
+
+		mLiveObjects.clear();
+
+		for (auto handle : mSelectedObjects)
+		{
+			mLiveObjects.push_back(static_cast<uint32_t>(mObjects.GetIndex(handle)));
+		}
+
+		sortPaintOrder(mLiveObjects);
+
+		auto drawUnselected = [this]()
+		{
+			for (uint32_t index : mDirtyObjects)
+			{
+				if (!mSelectedObjects.Contains(mObjects.GetHandle(index)))
+				{
+					drawObject(index);
+				}
+			}
+
+			mDrawCommands.Submit(mStaticLayer, mRenderStats);
+		};
+
+		mStaticLayer.BeginFrame();
+		mStaticLayer.Clear(MakeColor(0xFFFFFF, 1.f));
+
+		// Zoomed out, tiles are far cheaper. They are not dropped during a drag
+		// and still show the selection where it was, so the area it has been
+		// over is drawn again without it.
+		if (mTilePyramid.IsActive(mCamera.GetZoom()))
+		{
+			RectF bounds;
+
+			drawTiles(mStaticLayer, VIEWPORT, margin);
+
+			if (mSelectedObjects.GetBounds(bounds))
+			{
+				addDragBounds(bounds);
+			}
+
+			if (mDragBounds.left <= mDragBounds.right)
+			{
+				bounds = mDragBounds;
+				ADD_MARGIN_TO_RECT(bounds, margin);
+				const RectF AREA = mCamera.ToScreen(bounds);
+
+				mStaticLayer.PushClip(AREA);
+				mStaticLayer.Clear(MakeColor(0xFFFFFF, 1.f));
+				mDrawCommands.Reset(AREA);
+				getObjectsInRect(bounds, margin, mDirtyObjects);
+				drawUnselected();
+				mStaticLayer.PopClip();
+			}
+		}
+		else
+		{
+			mDrawCommands.Reset(VIEWPORT);
+			getVisibleObjects(mCamera.ToWorld(VIEWPORT), margin, mDirtyObjects);
+			drawUnselected();
+		}
+
+		mStaticLayer.EndFrame();
+
+		mbStaticLayerValid = true;
+	}
+
+	// Copies the layer pixels under clip one to one.
+	void Scene::drawStaticLayer(RenderBackend& backend, const RectF& clip)
+	{
+		const int LEFT = (std::max)(static_cast<int>(ceilf(clip.left - 0.5f)), 0);
+		const int TOP = (std::max)(static_cast<int>(ceilf(clip.top - 0.5f)), 0);
+		const int RIGHT = (std::min)(static_cast<int>(ceilf(clip.right - 0.5f)), static_cast<int>(mWidth));
+		const int BOTTOM = (std::min)(static_cast<int>(ceilf(clip.bottom - 0.5f)), static_cast<int>(mHeight));
+
+		if (LEFT >= RIGHT || TOP >= BOTTOM)
+		{
+			return;
+		}
+
+		backend.DrawBitmap({ static_cast<float>(LEFT), static_cast<float>(TOP), static_cast<float>(RIGHT), static_cast<float>(BOTTOM) },
+			mStaticLayer.GetPixels().data() + static_cast<size_t>(TOP) * mWidth + LEFT,
+			static_cast<uint32_t>(RIGHT - LEFT), static_cast<uint32_t>(BOTTOM - TOP), mWidth);
+	}
+
+	uint32_t Scene::drawLiveObjects(const RectF& rect, float margin)
+	{
+		uint32_t drawn = 0;
+
+		for (uint32_t index : mLiveObjects)
+		{
+			const RectF RECT = mDragTransform.Apply(mObjects.GetRect(index));
+
+			if (isOverlapping(RECT, rect, margin))
+			{
+				drawObject(index, RECT);
+				++drawn;
+			}
+		}
+
+		return drawn;
+	}
+
+	void Scene::drawObject(size_t index)
+	{
+		drawObject(index, mObjects.GetRect(index));
+	}
+
+	// Mid-drag the selection is drawn where the pending transform puts it.
+	void Scene::drawObject(size_t index, const RectF& worldRect)
+	{
+		const RectF rect = mCamera.ToScreen(worldRect);
+
+		mDrawCommands.Fill(rect, mObjects.GetBackgroundColor(index));
+		mDrawCommands.Stroke(rect, mObjects.GetLineColor(index), mObjects.GetStrokeWidth(index) * mCamera.GetZoom());
+	}
+
+	// Chrome keeps its pixel stroke widths at any zoom.
+	void Scene::drawChrome()
+	{
+		if (isChromeVisible(mDragSelectionArea))
+		{
+			const RectF DRAG_SELECTION_AREA = mCamera.ToScreen(mDragSelectionArea->mRect);
+			mDrawCommands.Fill(DRAG_SELECTION_AREA, mDragSelectionArea->mBackgroundColor);
+			mDrawCommands.Stroke(DRAG_SELECTION_AREA, mDragSelectionArea->mLineColor, mDragSelectionArea->mStrokeWidth);
+		}
+
+		if (isChromeVisible(mSelectedBoundary))
+		{
+			mDrawCommands.Stroke(mCamera.ToScreen(mSelectedBoundary->mRect), mSelectedBoundary->mLineColor, mSelectedBoundary->mStrokeWidth);
+		}
+
+		for (auto obj : mResizingRects)
+		{
+			if (isChromeVisible(obj))
+			{
+				const RectF RECT = mCamera.ToScreen(obj->mRect);
+				mDrawCommands.Fill(RECT, obj->mBackgroundColor);
+				mDrawCommands.Stroke(RECT, obj->mLineColor, obj->mStrokeWidth);
+			}
+		}
+
+		if (isChromeVisible(mNewObjectArea))
+		{
+			mDrawCommands.Stroke(mCamera.ToScreen(mNewObjectArea->mRect), mNewObjectArea->mLineColor, mNewObjectArea->mStrokeWidth);
+		}
+	}
+
+	void Scene::addChromeDamage()
+	{
+		Object* chrome[CHROME_OBJECTS_COUNT] = { mDragSelectionArea, mSelectedBoundary, mNewObjectArea };
+
+		for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
+		{
+			chrome[i + 3] = mResizingRects[i];
+		}
+
+		// Compared on screen, so a camera change damages chrome that did not
+		// move in the world. Hidden chrome is a none rect, which adds no damage.
+		for (size_t i = 0; i < CHROME_OBJECTS_COUNT; ++i)
+		{
+			const RectF rect = isChromeVisible(chrome[i]) ? mCamera.ToScreen(chrome[i]->mRect) : RectF{ NONE_POINT, NONE_POINT, NONE_POINT, NONE_POINT };
+			RectF& prevRect = mPrevChromeRects[i];
+
+			if (rect.left != prevRect.left || rect.top != prevRect.top || rect.right != prevRect.right || rect.bottom != prevRect.bottom)
+			{
+				const float MARGIN = chrome[i]->mStrokeWidth / 2 + DAMAGE_MARGIN;
+
+				mDamage.Add(prevRect, MARGIN);
+				mDamage.Add(rect, MARGIN);
+				prevRect = rect;
+			}
+		}
+	}
+
+	// Damage is tracked on screen; rect is in the world. Any change but to
+	// the selection stales the static layer of a drag.
+	void Scene::addObjectDamage(const RectF& rect)
+	{
+		mbStaticLayerValid = false;
+		addSelectionDamage(rect);
+	}
+
+	// Tiles are not drawn while the selection is dragged; the ones it goes
+	// over are dropped when it is let go.
+	void Scene::addSelectionDamage(const RectF& rect)
+	{
+		mDamage.Add(mCamera.ToScreen(rect), mObjects.GetMaxStrokeWidth() * mCamera.GetZoom() / 2 + DAMAGE_MARGIN);
+
+		if (isDraggingSelection())
+		{
+			addDragBounds(rect);
+			return;
+		}
+
+		mTilePyramid.Invalidate(rect, mObjects.GetMaxStrokeWidth() / 2);
+	}
+
+	void Scene::getObjectsInRect(const RectF& rect, float margin, std::vector<uint32_t>& outIndices)
+	{
+		gatherObjectsInRect(rect, margin, outIndices);
+		sortPaintOrder(outIndices);
+	}
+
+	// Unordered, and an object can appear more than once.
+	void Scene::gatherObjectsInRect(const RectF& rect, float margin, std::vector<uint32_t>& outIndices)
+	{
+		mObjectGrid.GetCandidates(rect, mDirtyCandidates);
+		outIndices.clear();
+		Profiler::Count(eProfileCounter::ObjectsScanned, mDirtyCandidates.size());
+
+		for (auto handle : mDirtyCandidates)
+		{
+			const uint32_t INDEX = static_cast<uint32_t>(mObjects.GetIndex(handle));
+
+			if (isOverlapping(mObjects.GetRect(INDEX), rect, margin))
+			{
+				outIndices.push_back(INDEX);
+			}
+		}
+	}
+
+	// Back to front. With most of the document in view, filtering the cached
+	// paint order is cheaper than sorting what the grid returns.
+	void Scene::getVisibleObjects(const RectF& rect, float margin, std::vector<uint32_t>& outIndices)
+	{
+		gatherObjectsInRect(rect, margin, outIndices);
+
+		if (outIndices.size() * CULL_SORT_RATIO < mObjects.GetCount())
+		{
+			sortPaintOrder(outIndices);
+			return;
+		}
+
+		outIndices.clear();
+
+		for (uint32_t index : getPaintOrder())
+		{
+			if (isOverlapping(mObjects.GetRect(index), rect, margin))
+			{
+				outIndices.push_back(index);
+			}
+		}
+	}
+
+	// Cells overlap in coverage, so drop duplicates and restore full-frame paint order.
+	void Scene::sortPaintOrder(std::vector<uint32_t>& indices) const
+	{
+		std::sort(indices.begin(), indices.end(), [this](uint32_t lhs, uint32_t rhs)
+		{
+			return mObjects.IsAbove(rhs, lhs);
+		});
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	}
+
+	// The closest and second closest objects above or below index in paint
+	// order that overlap it, or UINT32_MAX, in one pass over the grid. Keys
+	// are compared first, so only a candidate that would be one of the two
+	// has its rect read. Only reads, so lookups may run concurrently.
+	void Scene::getNearestOverlapping(uint32_t index, bool bAbove, std::vector<ObjectHandle>& candidates, uint32_t& outNext, uint32_t& outBeyond) const
+	{
+		const RectF RECT = mObjects.GetRect(index);
+		const float MARGIN = mObjects.GetMaxStrokeWidth() / 2 + DAMAGE_MARGIN;
+
+		mObjectGrid.GetCandidates(RECT, candidates);
+		outNext = UINT32_MAX;
+		outBeyond = UINT32_MAX;
+
+		auto isNearer = [this, bAbove](uint32_t other, uint32_t than)
+		{
+			return bAbove ? mObjects.IsAbove(than, other) : mObjects.IsAbove(other, than);
+		};
+
+		for (auto handle : candidates)
+		{
+			const uint32_t OTHER = static_cast<uint32_t>(mObjects.GetIndex(handle));
+
+			if (OTHER == outNext || OTHER == outBeyond || !isNearer(index, OTHER)
+				|| (outBeyond != UINT32_MAX && !isNearer(OTHER, outBeyond))
+				|| !isOverlapping(mObjects.GetRect(OTHER), RECT, MARGIN))
+			{
+				continue;
+			}
+
+			if (outNext == UINT32_MAX || isNearer(OTHER, outNext))
+			{
+				outBeyond = outNext;
+				outNext = OTHER;
+			}
+			else
+			{
+				outBeyond = OTHER;
+			}
+		}
+	}
+
+	// Back to front. Only adding, removing or reordering objects sorts it again.
+	const std::vector<uint32_t>& Scene::getPaintOrder()
+	{
+		if (mPaintOrderVersion != mObjects.GetZOrderVersion())
+		{
+			mPaintOrder.resize(mObjects.GetCount());
+
+			for (uint32_t i = 0; i < mPaintOrder.size(); ++i)
+			{
+				mPaintOrder[i] = i;
+			}
+
+			std::sort(mPaintOrder.begin(), mPaintOrder.end(), [this](uint32_t lhs, uint32_t rhs)
+			{
+				return mObjects.IsAbove(rhs, lhs);
+			});
+
+			mPaintOrderVersion = mObjects.GetZOrderVersion();
+		}
+
+		return mPaintOrder;
+	}
+
+	void Scene::addObject()
+	{
+		if (mStartPoint.x > mEndPoint.x)
+		{
+			const float temp = mStartPoint.x;
+			mStartPoint.x = mEndPoint.x;
+			mEndPoint.x = temp;
+		}
+
+		if (mStartPoint.y > mEndPoint.y)
+		{
+			const float temp = mStartPoint.y;
+			mStartPoint.y = mEndPoint.y;
+			mEndPoint.y = temp;
+		}
+
+		const RectF rect{ mStartPoint.x, mStartPoint.y, mEndPoint.x, mEndPoint.y };
+
+		AddObject(rect, MakeColor(0x000000, 1.f), MakeColor(0xFFFFFF, 0.f), 1.0f);
+	}
+
+	Object* Scene::getSelectionChromeOnCursor(float x, float y)
+	{
+		if (mCurrMode == eMouseMode::Selected && mbSelectionVisible)
+		{
+			for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
+			{
+				if (isChromeVisible(mResizingRects[i])
+					&& x >= mResizingRects[i]->mRect.left && x <= mResizingRects[i]->mRect.right
+					&& y >= mResizingRects[i]->mRect.top && y <= mResizingRects[i]->mRect.bottom)
+				{
+					mSelectedResizingRect = mResizingRects[i];
+					mResizingDirection = static_cast<eResizingDirection>(i);
+
+					return mResizingRects[i];
+				}
+			}
+
+			mResizingDirection = eResizingDirection::None;
+
+			const float MARGIN = OBJECT_MARGIN / mCamera.GetZoom();
+
+			if (x >= mSelectedBoundary->mRect.left - MARGIN && x <= mSelectedBoundary->mRect.right + MARGIN
+				&& y >= mSelectedBoundary->mRect.top - MARGIN && y <= mSelectedBoundary->mRect.bottom + MARGIN)
+			{
+				return mSelectedBoundary;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void Scene::addObjectsInDraggingArea()
+	{
+		ProfileScope scope(eProfileTimer::Marquee);
+		RectF dragSelectionArea = { mStartPoint.x, mStartPoint.y, mEndPoint.x, mEndPoint.y };
+
+		if (mStartPoint.x > mEndPoint.x)
+		{
+			dragSelectionArea.left = mEndPoint.x;
+			dragSelectionArea.right = mStartPoint.x;
+		}
+
+		if (mStartPoint.y > mEndPoint.y)
+		{
+			dragSelectionArea.top = mEndPoint.y;
+			dragSelectionArea.bottom = mStartPoint.y;
+		}
+
+		if (!mMarqueeSelector.IsActive())
+		{
+			mSelectedObjects.Clear();
+			mMarqueeSelector.Begin(mObjects);
+		}
+
+		mMarqueeSelector.Update(mObjects, dragSelectionArea, mChangedObjects);
+
+		for (uint32_t index : mChangedObjects)
+		{
+			if (mMarqueeSelector.IsContained(index))
+			{
+				mSelectedObjects.Insert(mObjects.GetHandle(index));
+			}
+			else
+			{
+				mSelectedObjects.Erase(mObjects.GetHandle(index));
+			}
+		}
+	}
+
+	void Scene::updateSelectionBoundary()
+	{
+		ProfileScope scope(eProfileTimer::SelectionBoundary);
+
+		if (!mSelectedObjects.GetBounds(mSelectedBoundary->mRect))
+		{
+			DEBUG_BREAK(mSelectedObjects.GetCount() == 0);
+
+			hideSelectionBoundary();
+			return;
+		}
+
+		const float MARGIN = SELECTED_RECT_MARGIN / mCamera.GetZoom();
+		ADD_MARGIN_TO_RECT(mSelectedBoundary->mRect, MARGIN);
+		mbSelectionVisible = true;
+	}
+
+	void Scene::hideSelectionBoundary()
+	{
+		SET_NONE_RECT(mSelectedBoundary);
+		mbSelectionVisible = false;
+	}
+
+	void Scene::getResizeRect(RectF& out)
+	{
+		const float DIFF_X = mEndPoint.x - mStartPoint.x;
+		const float DIFF_Y = mEndPoint.y - mStartPoint.y;
+
+		switch (mResizingDirection)
+		{
+		case eResizingDirection::NorthWest:
+			out = { DIFF_X, DIFF_Y, 0, 0 };
+			break;
+		case eResizingDirection::North:
+			out = { 0, DIFF_Y, 0, 0 };
+			break;
+		case eResizingDirection::NorthEast:
+			out = { 0, DIFF_Y, DIFF_X, 0 };
+			break;
+		case eResizingDirection::West:
+			out = { DIFF_X, 0, 0, 0 };
+			break;
+		case eResizingDirection::East:
+			out = { 0, 0, DIFF_X, 0 };
+			break;
+		case eResizingDirection::SouthWest:
+			out = { DIFF_X, 0, 0, DIFF_Y };
+			break;
+		case eResizingDirection::South:
+			out = { 0, 0, 0, DIFF_Y };
+			break;
+		case eResizingDirection::SouthEast:
+			out = { 0, 0, DIFF_X, DIFF_Y };
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+	}
+
+	// The selection keeps its own stacking order and goes above or below
+	// every other object. The keys are taken first, so that a renumber they
+	// cause happens before the old ones are journaled.
+	void Scene::stackSelectedObjects(bool bFront)
+	{
+		commitDragTransform();
+
+		const size_t COUNT = mSelectedObjects.GetCount();
+
+		if (COUNT == 0)
+		{
+			return;
+		}
+
+		const uint64_t FIRST_KEY = bFront ? mObjects.TakeTopZKeys(COUNT) : mObjects.TakeBottomZKeys(COUNT);
+		remapStaleZKeys();
+
+		JournalEntry entry;
+		recordSelection(eJournalOperation::Reorder, entry);
+
+		mZOrderHandles.assign(mSelectedObjects.begin(), mSelectedObjects.end());
+		sortByZOrder(mZOrderHandles);
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			mObjects.SetZKey(mObjects.GetIndex(mZOrderHandles[i]), FIRST_KEY + i * Z_KEY_SPACING);
+		}
+
+		RectF bounds;
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+	}
+
+	// Each selected object swaps places with the next object it overlaps,
+	// unless that one is selected too, landing just short of the object after
+	// it. Objects are taken from the far end of the selection first, so any
+	// selected neighbour has already moved. A fixed step rather than the
+	// midpoint leaves room for a stack of them in one gap.
+	void Scene::stepSelectedObjects(bool bForward)
+	{
+		commitDragTransform();
+
+		const size_t COUNT = mSelectedObjects.GetCount();
+
+		if (COUNT == 0)
+		{
+			return;
+		}
+
+		JournalEntry entry;
+		recordSelection(eJournalOperation::Reorder, entry);
+
+		mZOrderHandles.assign(mSelectedObjects.begin(), mSelectedObjects.end());
+		sortByZOrder(mZOrderHandles);
+
+		if (bForward)
+		{
+			std::reverse(mZOrderHandles.begin(), mZOrderHandles.end());
+		}
+
+		// Neighbours are looked up in parallel from the order before the step.
+		// The selection only moves away from the objects still to come, so a
+		// lookup goes stale only if it found a selected object that has moved
+		// by the time its turn comes; those are looked up again.
+		const uint8_t SELECTED = 1;
+		const uint8_t MOVED = 2;
+
+		mNearestObjects.resize(COUNT * 2);
+		mObjectMask.assign(mObjects.GetCount(), 0);
+
+		for (const ObjectHandle handle : mZOrderHandles)
+		{
+			mObjectMask[mObjects.GetIndex(handle)] = SELECTED;
+		}
+
+		ParallelFor(COUNT, [this, bForward](size_t begin, size_t end)
+		{
+			std::vector<ObjectHandle> candidates;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				getNearestOverlapping(static_cast<uint32_t>(mObjects.GetIndex(mZOrderHandles[i])), bForward,
+					candidates, mNearestObjects[i * 2], mNearestObjects[i * 2 + 1]);
+			}
+		});
+
+		auto getMask = [this](uint32_t index)
+		{
+			return index == UINT32_MAX ? 0 : mObjectMask[index];
+		};
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			const uint32_t INDEX = static_cast<uint32_t>(mObjects.GetIndex(mZOrderHandles[i]));
+			uint32_t next = mNearestObjects[i * 2];
+			uint32_t beyond = mNearestObjects[i * 2 + 1];
+
+			if (((getMask(next) | getMask(beyond)) & MOVED) != 0)
+			{
+				getNearestOverlapping(INDEX, bForward, mDirtyCandidates, next, beyond);
+			}
+
+			if (next == UINT32_MAX || (getMask(next) & SELECTED) != 0)
+			{
+				continue;
+			}
+
+			mObjectMask[INDEX] |= MOVED;
+
+			if (beyond == UINT32_MAX)
+			{
+				mObjects.SetZKey(INDEX, bForward ? mObjects.TakeTopZKeys(1) : mObjects.TakeBottomZKeys(1));
+				continue;
+			}
+
+			if ((std::max)(mObjects.GetZKey(next), mObjects.GetZKey(beyond)) - (std::min)(mObjects.GetZKey(next), mObjects.GetZKey(beyond)) < 2)
+			{
+				mObjects.RenumberZKeys();
+			}
+
+			const uint64_t NEAR_KEY = mObjects.GetZKey(next);
+			const uint64_t FAR_KEY = mObjects.GetZKey(beyond);
+
+			if (bForward)
+			{
+				mObjects.SetZKey(INDEX, FAR_KEY - (std::min)((FAR_KEY - NEAR_KEY) / 2, Z_KEY_STEP));
+			}
+			else
+			{
+				mObjects.SetZKey(INDEX, FAR_KEY + (std::min)((NEAR_KEY - FAR_KEY) / 2, Z_KEY_STEP));
+			}
+		}
+
+		remapStaleZKeys();
+
+		RectF bounds;
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+	}
+
+	void Scene::sortByZOrder(std::vector<ObjectHandle>& handles) const
+	{
+		std::sort(handles.begin(), handles.end(), [this](ObjectHandle lhs, ObjectHandle rhs)
+		{
+			return mObjects.IsAbove(mObjects.GetIndex(rhs), mObjects.GetIndex(lhs));
+		});
+	}
+
+	// Everything on screen moves, and the selection chrome is sized in pixels.
+	void Scene::updateCamera()
+	{
+		if (!mbLButtonDown && mbSelectionVisible)
+		{
+			updateSelectionBoundary();
+		}
+
+		mbStaticLayerValid = false;
+		mDamage.AddAll();
+	}
+
+	// All moves of one drag add up into a single journal entry, and into one
+	// offset the objects only take on when the drag is committed.
+	void Scene::moveSelectedObjects(float x, float y)
+	{
+		ProfileScope scope(eProfileTimer::Move);
+		JournalEntry entry;
+
+		if (mJournal.GetOpenEntry(eJournalOperation::Move, entry) || recordSelection(eJournalOperation::Move, entry))
+		{
+			entry.offset->x += x;
+			entry.offset->y += y;
+		}
+
+		RectF bounds;
+
+		if (getDraggedBounds(bounds))
+		{
+			addSelectionDamage(bounds);
+		}
+
+		mDragTransform.Translate(x, y);
+		mSelectedBoundary->Move(x, y);
+
+		if (getDraggedBounds(bounds))
+		{
+			addSelectionDamage(bounds);
+		}
+	}
+
+	void Scene::resizeSelectedObjects()
+	{
+		ProfileScope scope(eProfileTimer::Resize);
+		DEBUG_BREAK(mSelectedResizingRect != nullptr);
+		DEBUG_BREAK(mSelectedObjects.GetCount() > 0);
+		RectF resize;
+
+		JournalEntry entry;
+
+		if (!mJournal.GetOpenEntry(eJournalOperation::Resize, entry))
+		{
+			recordSelection(eJournalOperation::Resize, entry);
+		}
+
+		if (mSelectedObjects.GetCount() == 1)
+		{
+			getResizeRect(resize);
+
+			const ObjectHandle handle = *mSelectedObjects.begin();
+			const size_t index = mObjects.GetIndex(handle);
+
+			RectF rect = mObjects.GetRect(index);
+			addSelectionDamage(rect);
+
+			rect.left += resize.left;
+			rect.top += resize.top;
+			rect.right += resize.right;
+			rect.bottom += resize.bottom;
+
+			mObjects.SetRect(index, rect);
+			mObjectGrid.Update(handle, rect, mObjects.IsFilled(index));
+			mSelectedObjects.Update(handle);
+			addSelectionDamage(rect);
+		}
+		else
+		{
+			const float WIDTH = mSelectedBoundary->mRect.right - mSelectedBoundary->mRect.left;
+			const float HEIGHT = mSelectedBoundary->mRect.bottom - mSelectedBoundary->mRect.top;
+			float outwardX;
+			float outwardY;
+			float oppositePointX;
+			float oppositePointY;
+
+			switch (mResizingDirection)
+			{
+			case eResizingDirection::NorthWest:
+				outwardX = -1;
+				outwardY = -1;
+				oppositePointX = mSelectedBoundary->mRect.right;
+				oppositePointY = mSelectedBoundary->mRect.bottom;
+				break;
+			case eResizingDirection::NorthEast:
+				outwardX = 1;
+				outwardY = -1;
+				oppositePointX = mSelectedBoundary->mRect.left;
+				oppositePointY = mSelectedBoundary->mRect.bottom;
+				break;
+			case eResizingDirection::SouthWest:
+				outwardX = -1;
+				outwardY = 1;
+				oppositePointX = mSelectedBoundary->mRect.right;
+				oppositePointY = mSelectedBoundary->mRect.top;
+				break;
+			case eResizingDirection::SouthEast:
+				outwardX = 1;
+				outwardY = 1;
+				oppositePointX = mSelectedBoundary->mRect.left;
+				oppositePointY = mSelectedBoundary->mRect.top;
+				break;
+			default:
+				DEBUG_BREAK(false);
+				return;
+			}
+
+			// The corner moves along the boundary's diagonal by the drag
+			// projected onto it, so the aspect ratio holds for a drag in any
+			// direction and at any zoom. The diagonal keeps its direction as
+			// the boundary scales, so coalesced moves project the same as
+			// single ones. The larger side never shrinks below one unit.
+			const float DIAGONAL_X = outwardX * WIDTH;
+			const float DIAGONAL_Y = outwardY * HEIGHT;
+			const float LENGTH = DIAGONAL_X * DIAGONAL_X + DIAGONAL_Y * DIAGONAL_Y;
+			float along = 0;
+
+			if (LENGTH > 0)
+			{
+				along = ((mEndPoint.x - mStartPoint.x) * DIAGONAL_X + (mEndPoint.y - mStartPoint.y) * DIAGONAL_Y) / LENGTH;
+				along = (std::max)(along, (std::min)(0.f, 1.f / (std::max)(WIDTH, HEIGHT) - 1.f));
+			}
+
+			if (along == 0)
+			{
+				mStartPoint.x = mEndPoint.x;
+				mStartPoint.y = mEndPoint.y;
+				return;
+			}
+
+			const float DIFF_X = along * DIAGONAL_X;
+			const float DIFF_Y = along * DIAGONAL_Y;
+
+			resize = {
+				outwardX < 0 ? DIFF_X : 0,
+				outwardY < 0 ? DIFF_Y : 0,
+				outwardX > 0 ? DIFF_X : 0,
+				outwardY > 0 ? DIFF_Y : 0
+			};
+
+			addSelectionDamage(mSelectedBoundary->mRect);
+
+			const RectF BOUNDARY = {
+				mSelectedBoundary->mRect.left + resize.left,
+				mSelectedBoundary->mRect.top + resize.top,
+				mSelectedBoundary->mRect.right + resize.right,
+				mSelectedBoundary->mRect.bottom + resize.bottom
+			};
+
+			if (mDragTransform.IsIdentity())
+			{
+				mDragOrigin = mSelectedBoundary->mRect;
+			}
+
+			// Objects keep their share of the boundary by scaling about the
+			// opposite corner, always from the rects the drag began with.
+			mDragTransform.SetScale({ oppositePointX, oppositePointY },
+				(BOUNDARY.right - BOUNDARY.left) / (mDragOrigin.right - mDragOrigin.left),
+				(BOUNDARY.bottom - BOUNDARY.top) / (mDragOrigin.bottom - mDragOrigin.top));
+
+			addSelectionDamage(BOUNDARY);
+		}
+
+		mSelectedBoundary->mRect.left += resize.left;
+		mSelectedBoundary->mRect.top += resize.top;
+		mSelectedBoundary->mRect.right += resize.right;
+		mSelectedBoundary->mRect.bottom += resize.bottom;
+
+		mStartPoint.x = mEndPoint.x;
+		mStartPoint.y = mEndPoint.y;
+	}
+
+	// Bakes a drag into the objects: the store in one batched pass, then the
+	// grid and the selection bounds.
+	void Scene::commitDragTransform()
+	{
+		if (mDragTransform.IsIdentity())
+		{
+			return;
+		}
+
+		ProfileScope scope(eProfileTimer::Commit);
+		const size_t COUNT = mSelectedObjects.GetCount();
+		const auto HANDLES = mSelectedObjects.begin();
+
+		mBatchIndices.resize(COUNT);
+
+		ParallelFor(COUNT, [this, HANDLES](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				mBatchIndices[i] = static_cast<uint32_t>(mObjects.GetIndex(HANDLES[i]));
+			}
+		});
+
+		mObjects.TransformRange(mBatchIndices.data(), COUNT, mDragTransform);
+
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			const uint32_t INDEX = mBatchIndices[i];
+			mObjectGrid.Update(HANDLES[i], mObjects.GetRect(INDEX), mObjects.IsFilled(INDEX));
+		}
+
+		if (mDragTransform.IsTranslation())
+		{
+			mSelectedObjects.Translate(mDragTransform.GetOffset().x, mDragTransform.GetOffset().y);
+		}
+		else
+		{
+			mSelectedObjects.Invalidate();
+		}
+
+		mDragTransform.Reset();
+	}
+
+	// Where the selection is drawn, which mid-drag is not where it is stored.
+	bool Scene::getDraggedBounds(RectF& outBounds)
+	{
+		if (!mSelectedObjects.GetBounds(outBounds))
+		{
+			return false;
+		}
+
+		outBounds = mDragTransform.Apply(outBounds);
+
+		return true;
+	}
+
+	RectF Scene::getProfilerOverlayRect()
+	{
+		const float LINES_COUNT = static_cast<float>(1 + static_cast<int>(eProfileTimer::Count) + static_cast<int>(eProfileCounter::Count));
+
+		return { 8.f, 8.f, 8.f + PROFILER_OVERLAY_WIDTH, 8.f + (LINES_COUNT + 0.5f) * PROFILER_OVERLAY_LINE_HEIGHT };
+	}
+
+	eCursor Scene::getResizingCursor(eResizingDirection direction)
+	{
+		switch (direction)
+		{
+		case eResizingDirection::NorthWest:
+		case eResizingDirection::SouthEast:
+			return eCursor::SizeNWSE;
+		case eResizingDirection::South:
+		case eResizingDirection::North:
+			return eCursor::SizeNS;
+		case eResizingDirection::NorthEast:
+		case eResizingDirection::SouthWest:
+			return eCursor::SizeNESW;
+		case eResizingDirection::West:
+		case eResizingDirection::East:
+			return eCursor::SizeWE;
+		case eResizingDirection::None:
+			return eCursor::SizeAll;
+		default:
+			DEBUG_BREAK(false);
+			return eCursor::Unchanged;
+		}
+	}
+
+	bool Scene::recordSelection(eJournalOperation operation, JournalEntry& outEntry)
+	{
+		const size_t COUNT = mSelectedObjects.GetCount();
+
+		if (COUNT == 0 || !mJournal.Record(operation, COUNT, outEntry))
+		{
+			return false;
+		}
+
+		const auto HANDLES = mSelectedObjects.begin();
+
+		ParallelFor(COUNT, [this, &outEntry, HANDLES](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				captureObject(outEntry, i, HANDLES[i]);
+			}
+		});
+
+		return true;
+	}
+
+	void Scene::recordRange(size_t first, size_t count)
+	{
+		JournalEntry entry;
+		remapStaleZKeys();
+
+		if (count == 0 || !mJournal.Record(eJournalOperation::Add, count, entry))
+		{
+			return;
+		}
+
+		ParallelFor(count, [this, &entry, first](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				captureObject(entry, i, mObjects.GetHandle(first + i));
+			}
+		});
+	}
+
+	void Scene::captureObject(const JournalEntry& entry, size_t i, ObjectHandle handle) const
+	{
+		const size_t INDEX = mObjects.GetIndex(handle);
+		entry.handles[i] = handle;
+
+		if (entry.zKeys != nullptr)
+		{
+			entry.zKeys[i] = mObjects.GetZKey(INDEX);
+		}
+
+		if (entry.rects != nullptr)
+		{
+			entry.rects[i] = mObjects.GetRect(INDEX);
+		}
+
+		if (entry.lineColors != nullptr)
+		{
+			entry.lineColors[i] = mObjects.GetLineColor(INDEX);
+			entry.backgroundColors[i] = mObjects.GetBackgroundColor(INDEX);
+			entry.strokeWidths[i] = mObjects.GetStrokeWidth(INDEX);
+		}
+	}
+
+	void Scene::applyEntry(JournalEntry& entry, bool bUndo)
+	{
+		mMarqueeSelector.End();
+
+		switch (entry.operation)
+		{
+		case eJournalOperation::Add:
+		case eJournalOperation::Remove:
+			if (bUndo == (entry.operation == eJournalOperation::Add))
+			{
+				selectHandles(entry.handles, entry.count);
+				eraseSelectedObjects();
+				return;
+			}
+
+			addObjectRange(mObjects.Restore(entry.count, entry.handles, entry.rects,
+				entry.lineColors, entry.backgroundColors, entry.strokeWidths, entry.zKeys), entry.count);
+			break;
+		case eJournalOperation::Move:
+			if (bUndo)
+			{
+				translateEntryObjects(entry, -entry.offset->x, -entry.offset->y);
+			}
+			else
+			{
+				translateEntryObjects(entry, entry.offset->x, entry.offset->y);
+			}
+			break;
+		case eJournalOperation::Resize:
+			swapEntryRects(entry);
+			break;
+		case eJournalOperation::Reorder:
+			swapEntryZKeys(entry);
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+
+		mCurrMode = mSelectedObjects.GetCount() > 0 ? eMouseMode::Selected : eMouseMode::Select;
+	}
+
+	// The store is shifted in one batched pass; only the grid is updated per object.
+	void Scene::translateEntryObjects(const JournalEntry& entry, float x, float y)
+	{
+		RectF bounds;
+		selectHandles(entry.handles, entry.count);
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+
+		mBatchIndices.resize(entry.count);
+
+		ParallelFor(entry.count, [this, &entry](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				mBatchIndices[i] = static_cast<uint32_t>(mObjects.GetIndex(entry.handles[i]));
+			}
+		});
+
+		mObjects.MoveRange(mBatchIndices.data(), entry.count, x, y);
+
+		for (size_t i = 0; i < entry.count; ++i)
+		{
+			const uint32_t INDEX = mBatchIndices[i];
+			mObjectGrid.Update(entry.handles[i], mObjects.GetRect(INDEX), mObjects.IsFilled(INDEX));
+		}
+
+		mSelectedObjects.Translate(x, y);
+		updateSelectionBoundary();
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+	}
+
+	// Swapping keeps the entry usable in both directions without a second copy.
+	void Scene::swapEntryRects(JournalEntry& entry)
+	{
+		RectF bounds;
+		selectHandles(entry.handles, entry.count);
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+
+		for (size_t i = 0; i < entry.count; ++i)
+		{
+			const ObjectHandle handle = entry.handles[i];
+			const size_t INDEX = mObjects.GetIndex(handle);
+			const RectF rect = mObjects.GetRect(INDEX);
+
+			mObjects.SetRect(INDEX, entry.rects[i]);
+			mObjectGrid.Update(handle, entry.rects[i], mObjects.IsFilled(INDEX));
+			entry.rects[i] = rect;
+		}
+
+		mSelectedObjects.Invalidate();
+		updateSelectionBoundary();
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+	}
+
+	void Scene::swapEntryZKeys(JournalEntry& entry)
+	{
+		selectHandles(entry.handles, entry.count);
+
+		for (size_t i = 0; i < entry.count; ++i)
+		{
+			const size_t INDEX = mObjects.GetIndex(entry.handles[i]);
+			const uint64_t KEY = mObjects.GetZKey(INDEX);
+
+			mObjects.SetZKey(INDEX, entry.zKeys[i]);
+			entry.zKeys[i] = KEY;
+		}
+
+		updateSelectionBoundary();
+
+		RectF bounds;
+
+		if (mSelectedObjects.GetBounds(bounds))
+		{
+			addObjectDamage(bounds);
+		}
+	}
+
+	// A renumber moves every key. The journal's keys move with them, so
+	// the history still puts objects back in the order it saw.
+	void Scene::remapStaleZKeys()
+	{
+		if (mObjects.HasStaleZKeys())
+		{
+			mJournal.RemapZKeys(mObjects);
+			mObjects.ReleaseStaleZKeys();
+		}
+	}
+
+	void Scene::selectHandles(const ObjectHandle* handles, size_t count)
+	{
+		mBatchHandles.assign(handles, handles + count);
+		mSelectedObjects.Assign(mBatchHandles);
+	}
+}
@@ -0,0 +1,387 @@
+#pragma once
+
+#include "Object.h"
+#include "ObjectStore.h"
+#include "SpatialGrid.h"
+#include "RectKernels.h"
+#include "MarqueeSelector.h"
+#include "Selection.h"
+#include "DamageTracker.h"
+#include "DrawCommandList.h"
+#include "RenderBackend.h"
+#include "CpuRenderBackend.h"
+#include "SceneFile.h"
+#include "SaveWorker.h"
+#include "UndoJournal.h"
+#include "Shortcuts.h"
+#include "Profiler.h"
+#include "Camera.h"
+#include "TilePyramid.h"
+#include "GroupTransform.h"
+
+namespace canvas
+{
+	class Scene final
+	{
+	public:
+		Scene(uint32_t width, uint32_t height);
+		~Scene();
+		Scene(const Scene& other) = delete;
+		Scene& operator=(const Scene& rhs) = delete;
+
+		eCursor MouseDown(float x, float y);
+		eCursor MouseMove(float x, float y);
+		eCursor MouseUp();
+
+		void SetMode(eMouseMode mode);
+		void CopySelectedObjects();
+		void PasteCopiedObjects(float x, float y);
+		void DuplicateSelectedObjects();
+		void RemoveSelectedObjects();
+		void BringToFront();
+		void SendToBack();
+		void BringForward();
+		void SendBackward();
+		bool Undo();
+		bool Redo();
+		void SetUndoBudget(size_t budget);
+		bool RunCommand(eCommand command, float x, float y);
+		void ToggleProfiler();
+		void Pan(float x, float y);
+		void Zoom(float factor, float x, float y);
+		void ResetCamera();
+		void SetLodThreshold(float threshold);
+
+		bool Save(const char* path);
+		bool SaveAsync(const char* path, const std::function<void(bool)>& onCompleted);
+		bool Load(const char* path);
+
+		ObjectHandle AddObject(const RectF& rect, const ColorF& lineColor, const ColorF& backgroundColor, float strokeWidth);
+		ObjectHandle GetObjectOnCursor(float x, float y);
+
+		void Invalidate(const RectF& rect);
+		bool Render(RenderBackend& backend);
+
+		inline eMouseMode GetMode() const;
+		inline const ObjectStore& GetObjects() const;
+		inline const Selection& GetSelection() const;
+		inline const RectF& GetSelectionBoundary() const;
+		inline const RenderStats& GetRenderStats() const;
+		inline const UndoJournal& GetJournal() const;
+		inline const Camera& GetCamera() const;
+		inline const TilePyramid& GetTilePyramid() const;
+		inline bool IsSaving() const;
+		inline bool IsProfilerVisible() const;
+
+	private:
+		bool renderDamage(RenderBackend& backend);
+		void drawProfilerOverlay(RenderBackend& backend);
+		uint32_t drawTiles(RenderBackend& backend, const RectF& clip, float margin);
+		void buildStaticLayer(float margin);
+		void drawStaticLayer(RenderBackend& backend, const RectF& clip);
+		uint32_t drawLiveObjects(const RectF& rect, float margin);
+		void drawObject(size_t index);
+		void drawObject(size_t index, const RectF& worldRect);
+		void drawChrome();
+		void addChromeDamage();
+		void addObjectDamage(const RectF& rect);
+		void addSelectionDamage(const RectF& rect);
+		void getObjectsInRect(const RectF& rect, float margin, std::vector<uint32_t>& outIndices);
+		void gatherObjectsInRect(const RectF& rect, float margin, std::vector<uint32_t>& outIndices);
+		void getVisibleObjects(const RectF& rect, float margin, std::vector<uint32_t>& outIndices);
+		void sortPaintOrder(std::vector<uint32_t>& indices) const;
+		void getNearestOverlapping(uint32_t index, bool bAbove, std::vector<ObjectHandle>& candidates, uint32_t& outNext, uint32_t& outBeyond) const;
+		const std::vector<uint32_t>& getPaintOrder();
+
+		void addObject();
+		void addObjectRange(size_t first, size_t count);
+		void eraseSelectedObjects();
+		void moveSelectedObjects(float x, float y);
+		void resizeSelectedObjects();
+		void commitDragTransform();
+		bool getDraggedBounds(RectF& outBounds);
+		Object* getSelectionChromeOnCursor(float x, float y);
+		void addObjectsInDraggingArea();
+		void updateSelectionBoundary();
+		void hideSelectionBoundary();
+		void getResizeRect(RectF& out);
+		void stackSelectedObjects(bool bFront);
+		void stepSelectedObjects(bool bForward);
+		void sortByZOrder(std::vector<ObjectHandle>& handles) const;
+		void updateCamera();
+
+		bool recordSelection(eJournalOperation operation, JournalEntry& outEntry);
+		void recordRange(size_t first, size_t count);
+		void captureObject(const JournalEntry& entry, size_t i, ObjectHandle handle) const;
+		void applyEntry(JournalEntry& entry, bool bUndo);
+		void translateEntryObjects(const JournalEntry& entry, float x, float y);
+		void swapEntryRects(JournalEntry& entry);
+		void swapEntryZKeys(JournalEntry& entry);
+		void remapStaleZKeys();
+		void selectHandles(const ObjectHandle* handles, size_t count);
+
+		inline void setResizingRectsPoint();
+		inline void setResizingRectsNone();
+		inline float getHitMargin() const;
+		inline bool isDraggingSelection() const;
+		inline bool isChromeVisible(const Object* chrome) const;
+		inline void addDragBounds(const RectF& rect);
+
+		inline static bool isOverlapping(const RectF& objectRect, const RectF& rect, float margin);
+
+		static eCursor getResizingCursor(eResizingDirection direction);
+		static RectF getProfilerOverlayRect();
+
+	private:
+		uint32_t mWidth;
+		uint32_t mHeight;
+
+		bool mbLButtonDown;
+		bool mbDragging;
+		PointF mStartPoint;
+		PointF mEndPoint;
+		eMouseMode mCurrMode;
+		Camera mCamera;
+
+		ObjectStore mObjects;
+		SaveWorker mSaveWorker;
+		TilePyramid mTilePyramid;
+		Selection mSelectedObjects;
+		std::vector<ObjectInfo> mCopiedObjectInfo;
+		std::vector<ObjectHandle> mBatchHandles;
+		std::vector<uint32_t> mBatchIndices;
+		std::vector<ObjectHandle> mZOrderHandles;
+		std::vector<uint32_t> mNearestObjects;
+		UndoJournal mJournal;
+		SpatialGrid mObjectGrid;
+		std::vector<uint8_t> mObjectMask;
+		std::vector<uint32_t> mChangedObjects;
+		MarqueeSelector mMarqueeSelector;
+		std::vector<float> mCandidateEdges;
+		std::vector<ObjectHandle> mHitCandidates;
+
+		Object* mDragSelectionArea;
+		Object* mSelectedBoundary;
+		Object* mSelectedResizingRect;
+		eResizingDirection mResizingDirection;
+		Object* mNewObjectArea;
+		Object* mResizingRects[RESIZING_RECTS_COUNT];
+		uint32_t mVisibleResizingRects;
+		bool mbSelectionVisible;
+
+		DamageTracker mDamage;
+		RectF mPrevChromeRects[CHROME_OBJECTS_COUNT];
+		std::vector<ObjectHandle> mDirtyCandidates;
+		std::vector<uint32_t> mDirtyObjects;
+		std::vector<uint32_t> mPaintOrder;
+		uint64_t mPaintOrderVersion;
+		DrawCommandList mDrawCommands;
+		CpuRenderBackend mStaticLayer;
+		std::vector<uint32_t> mLiveObjects;
+		bool mbStaticLayerValid;
+		RectF mDragBounds;
+		GroupTransform mDragTransform;
+		RectF mDragOrigin;
+		RenderStats mRenderStats;
+		bool mbProfilerVisible;
+	};
+
+	inline eMouseMode Scene::GetMode() const
+	{
+		return mCurrMode;
+	}
+
+	inline const ObjectStore& Scene::GetObjects() const
+	{
+		return mObjects;
+	}
+
+	inline bool Scene::IsProfilerVisible() const
+	{
+		return mbProfilerVisible;
+	}
+
+	inline const Selection& Scene::GetSelection() const
+	{
+		return mSelectedObjects;
+	}
+
+	inline const RectF& Scene::GetSelectionBoundary() const
+	{
+		return mSelectedBoundary->mRect;
+	}
+
+	inline const RenderStats& Scene::GetRenderStats() const
+	{
+		return mRenderStats;
+	}
+
+	inline const UndoJournal& Scene::GetJournal() const
+	{
+		return mJournal;
+	}
+
+	inline const Camera& Scene::GetCamera() const
+	{
+		return mCamera;
+	}
+
+	inline const TilePyramid& Scene::GetTilePyramid() const
+	{
+		return mTilePyramid;
+	}
+
+	inline bool Scene::IsSaving() const
+	{
+		return mSaveWorker.IsBusy();
+	}
+
+	inline void Scene::setResizingRectsPoint()
+	{
+		const PointF LEFT_TOP = { mSelectedBoundary->mRect.left, mSelectedBoundary->mRect.top };
+		const PointF RIGHT_BOTTOM = { mSelectedBoundary->mRect.right, mSelectedBoundary->mRect.bottom };
+		const PointF CENTER = mSelectedBoundary->GetCenter();
+		const float SIZE = RESIZING_RECT_SIZE / mCamera.GetZoom();
+		
+		mResizingRects[static_cast<int>(eResizingDirection::NorthWest)]->mRect = { 
+			LEFT_TOP.x - SIZE,
+			LEFT_TOP.y - SIZE,
+			LEFT_TOP.x + SIZE,
+			LEFT_TOP.y + SIZE
+		};
+
+		mResizingRects[static_cast<int>(eResizingDirection::NorthEast)]->mRect = {
+			RIGHT_BOTTOM.x - SIZE,
+			LEFT_TOP.y - SIZE,
+			RIGHT_BOTTOM.x + SIZE,
+			LEFT_TOP.y + SIZE
+		};
+
+		mResizingRects[static_cast<int>(eResizingDirection::SouthWest)]->mRect = {
+			LEFT_TOP.x - SIZE,
+			RIGHT_BOTTOM.y - SIZE,
+			LEFT_TOP.x + SIZE,
+			RIGHT_BOTTOM.y + SIZE
+		};
+
+		mResizingRects[static_cast<int>(eResizingDirection::SouthEast)]->mRect = {
+			RIGHT_BOTTOM.x - SIZE,
+			RIGHT_BOTTOM.y - SIZE,
+			RIGHT_BOTTOM.x + SIZE,
+			RIGHT_BOTTOM.y + SIZE
+		};
+
+		mVisibleResizingRects = (1u << static_cast<int>(eResizingDirection::NorthWest))
+			| (1u << static_cast<int>(eResizingDirection::NorthEast))
+			| (1u << static_cast<int>(eResizingDirection::SouthWest))
+			| (1u << static_cast<int>(eResizingDirection::SouthEast));
+
+		if (mSelectedObjects.GetCount() == 1)
+		{
+			mVisibleResizingRects = (1u << RESIZING_RECTS_COUNT) - 1;
+
+			mResizingRects[static_cast<int>(eResizingDirection::North)]->mRect = {
+				CENTER.x - SIZE,
+				LEFT_TOP.y - SIZE,
+				CENTER.x + SIZE,
+				LEFT_TOP.y + SIZE
+			};
+
+			mResizingRects[static_cast<int>(eResizingDirection::West)]->mRect = {
+				LEFT_TOP.x - SIZE,
+				CENTER.y - SIZE,
+				LEFT_TOP.x + SIZE,
+				CENTER.y + SIZE
+			};
+
+			mResizingRects[static_cast<int>(eResizingDirection::East)]->mRect = {
+				RIGHT_BOTTOM.x - SIZE,
+				CENTER.y - SIZE,
+				RIGHT_BOTTOM.x + SIZE,
+				CENTER.y + SIZE
+			};
+
+			mResizingRects[static_cast<int>(eResizingDirection::South)]->mRect = {
+				CENTER.x - SIZE,
+				RIGHT_BOTTOM.y - SIZE,
+				CENTER.x + SIZE,
+				RIGHT_BOTTOM.y + SIZE
+			};
+		}
+		else
+		{
+			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::North)]);
+			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::West)]);
+			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::East)]);
+			SET_NONE_RECT(mResizingRects[static_cast<int>(eResizingDirection::South)]);
+		}
+	}
+
+	inline void Scene::setResizingRectsNone()
+	{
+		for (auto obj : mResizingRects)
+		{
+			SET_NONE_RECT(obj);
+		}
+
+		mVisibleResizingRects = 0;
+	}
+
+	// OBJECT_MARGIN pixels when zoomed in. Zoomed out it stays at the margin
+	// the grid files objects under, so no hit falls outside their cells.
+	inline float Scene::getHitMargin() const
+	{
+		return OBJECT_MARGIN / (std::max)(mCamera.GetZoom(), 1.f);
+	}
+
+	inline bool Scene::isDraggingSelection() const
+	{
+		return mbDragging && (mCurrMode == eMouseMode::Selected || mCurrMode == eMouseMode::Resize);
+	}
+
+	// Chrome is shown by state, not by its rect, since any world point is valid.
+	inline bool Scene::isChromeVisible(const Object* chrome) const
+	{
+		if (chrome == mDragSelectionArea)
+		{
+			return mbDragging && mCurrMode == eMouseMode::Select;
+		}
+
+		if (chrome == mNewObjectArea)
+		{
+			return mbDragging && mCurrMode == eMouseMode::Rect;
+		}
+
+		if (chrome == mSelectedBoundary)
+		{
+			return mbSelectionVisible;
+		}
+
+		for (size_t i = 0; i < RESIZING_RECTS_COUNT; ++i)
+		{
+			if (chrome == mResizingRects[i])
+			{
+				return (mVisibleResizingRects & (1u << i)) != 0;
+			}
+		}
+
+		return false;
+	}
+
+	// Empty while left > right.
+	inline void Scene::addDragBounds(const RectF& rect)
+	{
+		mDragBounds.left = (std::min)(mDragBounds.left, (std::min)(rect.left, rect.right));
+		mDragBounds.top = (std::min)(mDragBounds.top, (std::min)(rect.top, rect.bottom));
+		mDragBounds.right = (std::max)(mDragBounds.right, (std::max)(rect.left, rect.right));
+		mDragBounds.bottom = (std::max)(mDragBounds.bottom, (std::max)(rect.top, rect.bottom));
+	}
+
+	inline bool Scene::isOverlapping(const RectF& objectRect, const RectF& rect, float margin)
+	{
+		return (std::min)(objectRect.left, objectRect.right) - margin <= rect.right
+			&& (std::max)(objectRect.left, objectRect.right) + margin >= rect.left
+			&& (std::min)(objectRect.top, objectRect.bottom) - margin <= rect.bottom
+			&& (std::max)(objectRect.top, objectRect.bottom) + margin >= rect.top;
+	}
+}
@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "SceneFile.h"
+#include "MappedFile.h"
+
+namespace canvas
+{
+	// Pages are written as the snapshot hands them out, each column slice at
+	// its final offset, into a temporary file that replaces the target only
+	// once everything has reached the disk.
+	bool SceneFile::Write(const char* path, ObjectSnapshot& snapshot)
+	{
+		struct Column
+		{
+			uint32_t elementSize;
+			uint32_t wordSize;
+			uint64_t offset;
+		};
+
+		const size_t COUNT = snapshot.GetCount();
+		const size_t COLUMNS_COUNT = static_cast<size_t>(eColumn::Count);
+
+		Column columns[COLUMNS_COUNT] = {
+			{ sizeof(float), sizeof(float), 0 },
+			{ sizeof(float), sizeof(float), 0 },
+			{ sizeof(float), sizeof(float), 0 },
+			{ sizeof(float), sizeof(float), 0 },
+			{ sizeof(ColorF), sizeof(float), 0 },
+			{ sizeof(ColorF), sizeof(float), 0 },
+			{ sizeof(float), sizeof(float), 0 },
+			{ sizeof(uint64_t), sizeof(uint64_t), 0 }
+		};
+
+		std::vector<uint8_t> header(static_cast<size_t>(alignOffset(SCENE_FILE_HEADER_SIZE + COLUMNS_COUNT * SCENE_FILE_COLUMN_SIZE)), 0);
+		uint8_t* cursor = header.data();
+
+		storeLE(cursor, SCENE_FILE_MAGIC, 4);
+		storeLE(cursor + 4, SCENE_FILE_VERSION, 2);
+		storeLE(cursor + 6, SCENE_FILE_HEADER_SIZE, 2);
+		storeLE(cursor + 8, COLUMNS_COUNT, 4);
+		storeLE(cursor + 16, COUNT, 8);
+		cursor += SCENE_FILE_HEADER_SIZE;
+
+		uint64_t offset = alignOffset(header.size());
+
+		for (size_t i = 0; i < COLUMNS_COUNT; ++i)
+		{
+			columns[i].offset = offset;
+
+			storeLE(cursor, i, 4);
+			storeLE(cursor + 4, columns[i].elementSize, 4);
+			storeLE(cursor + 8, offset, 8);
+			cursor += SCENE_FILE_COLUMN_SIZE;
+
+			offset = alignOffset(offset + COUNT * columns[i].elementSize);
+		}
+
+		const std::string TEMP_PATH = std::string(path) + ".tmp";
+		FILE* file = OpenFile(TEMP_PATH.c_str(), "wb");
+
+		if (file == nullptr)
+		{
+			snapshot.Finish();
+			return false;
+		}
+
+		std::unique_ptr<ObjectPage> scratch(new ObjectPage);
+		bool bSucceeded = fwrite(header.data(), 1, header.size(), file) == header.size();
+
+		for (size_t page = 0; page < snapshot.GetPagesCount() && bSucceeded; ++page)
+		{
+			const ObjectPage& data = snapshot.ReadPage(page, *scratch);
+			const size_t FIRST = page * SNAPSHOT_PAGE_SIZE;
+			const size_t PAGE_COUNT = snapshot.GetPageCount(page);
+
+			const void* slices[COLUMNS_COUNT] = {
+				data.lefts, data.tops, data.rights, data.bottoms, data.lineColors, data.backgroundColors, data.strokeWidths, data.zKeys
+			};
+
+			for (size_t i = 0; i < COLUMNS_COUNT && bSucceeded; ++i)
+			{
+				bSucceeded = SeekFile(file, columns[i].offset + FIRST * columns[i].elementSize)
+					&& writeColumn(file, slices[i], PAGE_COUNT * columns[i].elementSize, columns[i].wordSize);
+			}
+
+			snapshot.ReleasePage(page);
+		}
+
+		snapshot.Finish();
+
+		bSucceeded = bSucceeded && fflush(file) == 0 && SyncFile(file);
+		bSucceeded = fclose(file) == 0 && bSucceeded;
+
+		if (!bSucceeded || !RenameFile(TEMP_PATH.c_str(), path))
+		{
+			RemoveFile(TEMP_PATH.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SceneFile::Read(const char* path, ObjectStore& outObjects)
+	{
+		MappedFile file;
+
+		if (!file.Open(path) || file.GetSize() < SCENE_FILE_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		const uint8_t* data = file.GetData();
+		const uint64_t SIZE = file.GetSize();
+
+		const uint32_t MAGIC = static_cast<uint32_t>(loadLE(data, 4));
+		const uint32_t VERSION = static_cast<uint32_t>(loadLE(data + 4, 2));
+		const uint32_t HEADER_SIZE = static_cast<uint32_t>(loadLE(data + 6, 2));
+		const uint64_t COLUMNS_COUNT = loadLE(data + 8, 4);
+		const uint64_t COUNT = loadLE(data + 16, 8);
+
+		if (MAGIC != SCENE_FILE_MAGIC || VERSION == 0 || VERSION > SCENE_FILE_VERSION
+			|| HEADER_SIZE < SCENE_FILE_HEADER_SIZE || COUNT >= UINT32_MAX
+			|| HEADER_SIZE + COLUMNS_COUNT * SCENE_FILE_COLUMN_SIZE > SIZE)
+		{
+			return false;
+		}
+
+		const void* columns[static_cast<size_t>(eColumn::Count)] = {};
+		const uint32_t ELEMENT_SIZES[] = {
+			sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(ColorF), sizeof(ColorF), sizeof(float), sizeof(uint64_t)
+		};
+
+		for (uint64_t i = 0; i < COLUMNS_COUNT; ++i)
+		{
+			const uint8_t* entry = data + HEADER_SIZE + i * SCENE_FILE_COLUMN_SIZE;
+			const uint64_t ID = loadLE(entry, 4);
+			const uint64_t ELEMENT_SIZE = loadLE(entry + 4, 4);
+			const uint64_t OFFSET = loadLE(entry + 8, 8);
+
+			if (ID >= static_cast<uint64_t>(eColumn::Count))
+			{
+				continue;
+			}
+
+			if (ELEMENT_SIZE != ELEMENT_SIZES[ID] || OFFSET % (ID == static_cast<uint64_t>(eColumn::ZKeys) ? sizeof(uint64_t) : sizeof(float)) != 0
+				|| OFFSET > SIZE || COUNT * ELEMENT_SIZE > SIZE - OFFSET)
+			{
+				return false;
+			}
+
+			columns[ID] = data + OFFSET;
+		}
+
+		for (size_t i = 0; i < static_cast<size_t>(eColumn::ZKeys); ++i)
+		{
+			if (columns[i] == nullptr)
+			{
+				return false;
+			}
+		}
+
+		const uint8_t* zKeys = static_cast<const uint8_t*>(columns[static_cast<size_t>(eColumn::ZKeys)]);
+
+		outObjects.Clear();
+
+#ifdef CANVAS_BIG_ENDIAN
+		outObjects.AddRange(static_cast<size_t>(COUNT), [&columns](size_t i, RectF& rect, ColorF& lineColor, ColorF& backgroundColor, float& strokeWidth)
+		{
+			rect = {
+				loadFloat(columns[static_cast<size_t>(eColumn::Lefts)], i),
+				loadFloat(columns[static_cast<size_t>(eColumn::Tops)], i),
+				loadFloat(columns[static_cast<size_t>(eColumn::Rights)], i),
+				loadFloat(columns[static_cast<size_t>(eColumn::Bottoms)], i)
+			};
+			lineColor = loadColor(columns[static_cast<size_t>(eColumn::LineColors)], i);
+			backgroundColor = loadColor(columns[static_cast<size_t>(eColumn::BackgroundColors)], i);
+			strokeWidth = loadFloat(columns[static_cast<size_t>(eColumn::StrokeWidths)], i);
+		});
+
+		for (size_t i = 0; i < COUNT && zKeys != nullptr; ++i)
+		{
+			outObjects.SetZKey(i, loadLE(zKeys + i * sizeof(uint64_t), sizeof(uint64_t)));
+		}
+#else
+		outObjects.AddColumns(static_cast<size_t>(COUNT),
+			static_cast<const float*>(columns[static_cast<size_t>(eColumn::Lefts)]),
+			static_cast<const float*>(columns[static_cast<size_t>(eColumn::Tops)]),
+			static_cast<const float*>(columns[static_cast<size_t>(eColumn::Rights)]),
+			static_cast<const float*>(columns[static_cast<size_t>(eColumn::Bottoms)]),
+			static_cast<const ColorF*>(columns[static_cast<size_t>(eColumn::LineColors)]),
+			static_cast<const ColorF*>(columns[static_cast<size_t>(eColumn::BackgroundColors)]),
+			static_cast<const float*>(columns[static_cast<size_t>(eColumn::StrokeWidths)]),
+			reinterpret_cast<const uint64_t*>(zKeys));
+#endif
+
+		return true;
+	}
+
+	// Every column is made of 32- or 64-bit words, so on little-endian hosts
+	// the bytes go straight through; big-endian hosts reverse each word.
+	bool SceneFile::writeColumn(FILE* file, const void* data, size_t bytes, size_t wordSize)
+	{
+#ifdef CANVAS_BIG_ENDIAN
+		const uint8_t* in = static_cast<const uint8_t*>(data);
+		uint8_t buffer[4096];
+
+		for (size_t i = 0; i < bytes; i += sizeof(buffer))
+		{
+			const size_t COUNT = (std::min)(bytes - i, sizeof(buffer));
+
+			for (size_t j = 0; j < COUNT; j += wordSize)
+			{
+				for (size_t k = 0; k < wordSize; ++k)
+				{
+					buffer[j + k] = in[i + j + wordSize - 1 - k];
+				}
+			}
+
+			if (fwrite(buffer, 1, COUNT, file) != COUNT)
+			{
+				return false;
+			}
+		}
+
+		return true;
+#else
+		static_cast<void>(wordSize);
+
+		return bytes == 0 || fwrite(data, 1, bytes, file) == bytes;
+#endif
+	}
+}
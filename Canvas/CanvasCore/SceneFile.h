@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ObjectStore.h"
+#include "ObjectSnapshot.h"
+
+namespace canvas
+{
+	// Versioned, little-endian, column-oriented scene file:
+	//
+	//   header   magic "CNVS", u16 version, u16 header size, u32 columns count,
+	//            u32 reserved, u64 objects count
+	//   columns  columns count x { u32 id, u32 element size, u64 offset }
+	//   data     one packed array per column, each 64-byte aligned
+	//
+	// Readers skip column ids they do not know and reject newer versions.
+	// ZKeys came later, so a file without it loads in index order.
+	class SceneFile final
+	{
+	public:
+		enum class eColumn : uint32_t
+		{
+			Lefts,
+			Tops,
+			Rights,
+			Bottoms,
+			LineColors,
+			BackgroundColors,
+			StrokeWidths,
+			ZKeys,
+
+			Count
+		};
+
+		static bool Write(const char* path, ObjectSnapshot& snapshot);
+		static bool Read(const char* path, ObjectStore& outObjects);
+
+	private:
+		SceneFile() = delete;
+
+		static bool writeColumn(FILE* file, const void* data, size_t bytes, size_t wordSize);
+
+		inline static uint64_t alignOffset(uint64_t offset);
+		inline static void storeLE(uint8_t* out, uint64_t value, size_t bytes);
+		inline static uint64_t loadLE(const uint8_t* in, size_t bytes);
+		inline static uint32_t swapWord(uint32_t word);
+		inline static float loadFloat(const void* column, size_t index);
+		inline static ColorF loadColor(const void* column, size_t index);
+	};
+
+	inline uint64_t SceneFile::alignOffset(uint64_t offset)
+	{
+		return (offset + SCENE_FILE_ALIGNMENT - 1) & ~static_cast<uint64_t>(SCENE_FILE_ALIGNMENT - 1);
+	}
+
+	inline void SceneFile::storeLE(uint8_t* out, uint64_t value, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			out[i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+	}
+
+	inline uint64_t SceneFile::loadLE(const uint8_t* in, size_t bytes)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			value |= static_cast<uint64_t>(in[i]) << (i * 8);
+		}
+
+		return value;
+	}
+
+	inline uint32_t SceneFile::swapWord(uint32_t word)
+	{
+		return (word >> 24) | ((word >> 8) & 0xFF00u) | ((word << 8) & 0xFF0000u) | (word << 24);
+	}
+
+	inline float SceneFile::loadFloat(const void* column, size_t index)
+	{
+		uint32_t word;
+		memcpy(&word, static_cast<const uint32_t*>(column) + index, sizeof(word));
+#ifdef CANVAS_BIG_ENDIAN
+		word = swapWord(word);
+#endif
+
+		float value;
+		memcpy(&value, &word, sizeof(value));
+
+		return value;
+	}
+
+	inline ColorF SceneFile::loadColor(const void* column, size_t index)
+	{
+		return { loadFloat(column, index * 4), loadFloat(column, index * 4 + 1), loadFloat(column, index * 4 + 2), loadFloat(column, index * 4 + 3) };
+	}
+}
@@ -0,0 +1,260 @@
+#include "pch.h"
+#include "Selection.h"
+
+namespace canvas
+{
+	Selection::Selection(const ObjectStore& objects)
+		: mObjects(objects)
+		, mLeafCount(0)
+		, mOffset{ 0.f, 0.f }
+		, mbDirty(false)
+	{
+		mHandles.reserve(DEFAULT_OBJECT_CAPACITY);
+	}
+
+	bool Selection::Insert(ObjectHandle handle)
+	{
+		DEBUG_BREAK(mObjects.IsValid(handle));
+
+		if (Contains(handle))
+		{
+			return false;
+		}
+
+		if (handle.index >= mPositions.size())
+		{
+			mPositions.resize(static_cast<size_t>(handle.index) + 1, getNone());
+		}
+
+		const size_t POSITION = mHandles.size();
+		mPositions[handle.index] = static_cast<uint32_t>(POSITION);
+		mHandles.push_back(handle);
+
+		if (POSITION >= mLeafCount)
+		{
+			mbDirty = true;
+		}
+
+		if (!mbDirty)
+		{
+			setLeaf(POSITION, mObjects.GetRect(mObjects.GetIndex(handle)));
+			updatePath(POSITION);
+		}
+
+		return true;
+	}
+
+	bool Selection::Erase(ObjectHandle handle)
+	{
+		if (!Contains(handle))
+		{
+			return false;
+		}
+
+		const size_t POSITION = mPositions[handle.index];
+		const size_t LAST = mHandles.size() - 1;
+
+		mPositions[handle.index] = getNone();
+
+		if (POSITION != LAST)
+		{
+			mHandles[POSITION] = mHandles[LAST];
+			mPositions[mHandles[POSITION].index] = static_cast<uint32_t>(POSITION);
+		}
+
+		mHandles.pop_back();
+
+		if (!mbDirty)
+		{
+			if (POSITION != LAST)
+			{
+				mMinLefts[mLeafCount + POSITION] = mMinLefts[mLeafCount + LAST];
+				mMinTops[mLeafCount + POSITION] = mMinTops[mLeafCount + LAST];
+				mMaxRights[mLeafCount + POSITION] = mMaxRights[mLeafCount + LAST];
+				mMaxBottoms[mLeafCount + POSITION] = mMaxBottoms[mLeafCount + LAST];
+				updatePath(POSITION);
+			}
+
+			clearLeaf(LAST);
+			updatePath(LAST);
+		}
+
+		return true;
+	}
+
+	void Selection::Clear()
+	{
+		for (auto handle : mHandles)
+		{
+			mPositions[handle.index] = getNone();
+		}
+
+		mHandles.clear();
+
+		mLeafCount = 0;
+		mMinLefts.clear();
+		mMinTops.clear();
+		mMaxRights.clear();
+		mMaxBottoms.clear();
+
+		mOffset = { 0.f, 0.f };
+		mbDirty = false;
+	}
+
+	// Takes the handles by swap and hands back the previous, emptied storage so
+	// the caller can reuse it. The handles must be distinct.
+	void Selection::Assign(std::vector<ObjectHandle>& handles)
+	{
+		Clear();
+		mHandles.swap(handles);
+
+		uint32_t maxSlot = 0;
+
+		for (auto handle : mHandles)
+		{
+			maxSlot = (std::max)(maxSlot, handle.index);
+		}
+
+		if (!mHandles.empty() && maxSlot >= mPositions.size())
+		{
+			mPositions.resize(static_cast<size_t>(maxSlot) + 1, getNone());
+		}
+
+		ParallelFor(mHandles.size(), [this](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				DEBUG_BREAK(mObjects.IsValid(mHandles[i]));
+				mPositions[mHandles[i].index] = static_cast<uint32_t>(i);
+			}
+		});
+
+		mbDirty = !mHandles.empty();
+	}
+
+	void Selection::Update(ObjectHandle handle)
+	{
+		DEBUG_BREAK(Contains(handle));
+
+		if (mbDirty)
+		{
+			return;
+		}
+
+		const size_t POSITION = mPositions[handle.index];
+		setLeaf(POSITION, mObjects.GetRect(mObjects.GetIndex(handle)));
+		updatePath(POSITION);
+	}
+
+	void Selection::Translate(float x, float y)
+	{
+		mOffset.x += x;
+		mOffset.y += y;
+	}
+
+	void Selection::Invalidate()
+	{
+		mbDirty = true;
+	}
+
+	bool Selection::GetBounds(RectF& outBounds)
+	{
+		if (mHandles.empty())
+		{
+			return false;
+		}
+
+		if (mbDirty)
+		{
+			rebuild();
+		}
+
+		outBounds = {
+			mMinLefts[1] + mOffset.x,
+			mMinTops[1] + mOffset.y,
+			mMaxRights[1] + mOffset.x,
+			mMaxBottoms[1] + mOffset.y
+		};
+
+		return true;
+	}
+
+	void Selection::setLeaf(size_t position, const RectF& rect)
+	{
+		const size_t NODE = mLeafCount + position;
+
+		mMinLefts[NODE] = rect.left - mOffset.x;
+		mMinTops[NODE] = rect.top - mOffset.y;
+		mMaxRights[NODE] = rect.right - mOffset.x;
+		mMaxBottoms[NODE] = rect.bottom - mOffset.y;
+	}
+
+	void Selection::clearLeaf(size_t position)
+	{
+		const size_t NODE = mLeafCount + position;
+
+		mMinLefts[NODE] = FLT_MAX;
+		mMinTops[NODE] = FLT_MAX;
+		mMaxRights[NODE] = -FLT_MAX;
+		mMaxBottoms[NODE] = -FLT_MAX;
+	}
+
+	void Selection::updatePath(size_t position)
+	{
+		for (size_t node = (mLeafCount + position) / 2; node > 0; node /= 2)
+		{
+			const size_t LEFT_CHILD = node * 2;
+			const size_t RIGHT_CHILD = LEFT_CHILD + 1;
+
+			mMinLefts[node] = (std::min)(mMinLefts[LEFT_CHILD], mMinLefts[RIGHT_CHILD]);
+			mMinTops[node] = (std::min)(mMinTops[LEFT_CHILD], mMinTops[RIGHT_CHILD]);
+			mMaxRights[node] = (std::max)(mMaxRights[LEFT_CHILD], mMaxRights[RIGHT_CHILD]);
+			mMaxBottoms[node] = (std::max)(mMaxBottoms[LEFT_CHILD], mMaxBottoms[RIGHT_CHILD]);
+		}
+	}
+
+	void Selection::rebuild()
+	{
+		if (mLeafCount < mHandles.size())
+		{
+			mLeafCount = mLeafCount == 0 ? DEFAULT_OBJECT_CAPACITY : mLeafCount;
+
+			while (mLeafCount < mHandles.size())
+			{
+				mLeafCount *= 2;
+			}
+
+			mMinLefts.resize(mLeafCount * 2);
+			mMinTops.resize(mLeafCount * 2);
+			mMaxRights.resize(mLeafCount * 2);
+			mMaxBottoms.resize(mLeafCount * 2);
+		}
+
+		mOffset = { 0.f, 0.f };
+
+		for (size_t i = 0; i < mLeafCount; ++i)
+		{
+			if (i < mHandles.size())
+			{
+				setLeaf(i, mObjects.GetRect(mObjects.GetIndex(mHandles[i])));
+			}
+			else
+			{
+				clearLeaf(i);
+			}
+		}
+
+		for (size_t node = mLeafCount - 1; node > 0; --node)
+		{
+			const size_t LEFT_CHILD = node * 2;
+			const size_t RIGHT_CHILD = LEFT_CHILD + 1;
+
+			mMinLefts[node] = (std::min)(mMinLefts[LEFT_CHILD], mMinLefts[RIGHT_CHILD]);
+			mMinTops[node] = (std::min)(mMinTops[LEFT_CHILD], mMinTops[RIGHT_CHILD]);
+			mMaxRights[node] = (std::max)(mMaxRights[LEFT_CHILD], mMaxRights[RIGHT_CHILD]);
+			mMaxBottoms[node] = (std::max)(mMaxBottoms[LEFT_CHILD], mMaxBottoms[RIGHT_CHILD]);
+		}
+
+		mbDirty = false;
+	}
+}
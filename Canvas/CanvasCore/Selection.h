@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ObjectStore.h"
+
+namespace canvas
+{
+	class Selection final
+	{
+	public:
+		Selection(const ObjectStore& objects);
+		~Selection() = default;
+		Selection(const Selection& other) = delete;
+		Selection& operator=(const Selection& rhs) = delete;
+
+		bool Insert(ObjectHandle handle);
+		bool Erase(ObjectHandle handle);
+		void Clear();
+		void Assign(std::vector<ObjectHandle>& handles);
+
+		void Update(ObjectHandle handle);
+		void Translate(float x, float y);
+		void Invalidate();
+		bool GetBounds(RectF& outBounds);
+
+		inline bool Contains(ObjectHandle handle) const;
+		inline size_t GetCount() const;
+		inline bool IsEmpty() const;
+		inline std::vector<ObjectHandle>::const_iterator begin() const;
+		inline std::vector<ObjectHandle>::const_iterator end() const;
+
+	private:
+		void setLeaf(size_t position, const RectF& rect);
+		void clearLeaf(size_t position);
+		void updatePath(size_t position);
+		void rebuild();
+
+		inline static uint32_t getNone();
+
+	private:
+		const ObjectStore& mObjects;
+
+		std::vector<ObjectHandle> mHandles;
+		std::vector<uint32_t> mPositions;
+
+		// Min/max segment trees over selection positions. Leaves are stored
+		// relative to mOffset so that moving the whole selection stays O(1).
+		size_t mLeafCount;
+		std::vector<float> mMinLefts;
+		std::vector<float> mMinTops;
+		std::vector<float> mMaxRights;
+		std::vector<float> mMaxBottoms;
+		PointF mOffset;
+		bool mbDirty;
+	};
+
+	inline bool Selection::Contains(ObjectHandle handle) const
+	{
+		if (handle.index >= mPositions.size() || mPositions[handle.index] == getNone())
+		{
+			return false;
+		}
+
+		return mHandles[mPositions[handle.index]] == handle;
+	}
+
+	inline size_t Selection::GetCount() const
+	{
+		return mHandles.size();
+	}
+
+	inline bool Selection::IsEmpty() const
+	{
+		return mHandles.empty();
+	}
+
+	inline std::vector<ObjectHandle>::const_iterator Selection::begin() const
+	{
+		return mHandles.begin();
+	}
+
+	inline std::vector<ObjectHandle>::const_iterator Selection::end() const
+	{
+		return mHandles.end();
+	}
+
+	inline uint32_t Selection::getNone()
+	{
+		return UINT32_MAX;
+	}
+}
@@ -0,0 +1,8 @@
+#include "pch.h"
+#include "Shortcuts.h"
+
+namespace canvas
+{
+	static_assert(HasUniqueChords(), "two shortcuts are bound to the same chord");
+	static_assert(TOTAL_KEY_COUNT <= 16, "held keys are recorded as 16 bits");
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+namespace canvas
+{
+	enum class eKeyValue
+	{
+		Select,
+		Rect,
+		Backspace,
+		C,
+		V,
+		D,
+		S,
+		O,
+		Z,
+		Y,
+		Shift,
+		Ctrl,
+		F3,
+		F4,
+		LeftBracket,
+		RightBracket,
+
+		Count
+	};
+
+	constexpr int TOTAL_KEY_COUNT = static_cast<int>(eKeyValue::Count);
+
+	enum class eCommand : uint8_t
+	{
+		None,
+		SelectMode,
+		RectMode,
+		Remove,
+		Copy,
+		Paste,
+		Duplicate,
+		Undo,
+		Redo,
+		Save,
+		Open,
+		ToggleProfiler,
+		WriteTrace,
+		BringForward,
+		SendBackward,
+		BringToFront,
+		SendToBack
+	};
+
+	enum eKeyModifier : uint8_t
+	{
+		KEY_MODIFIER_NONE = 0,
+		KEY_MODIFIER_CTRL = 1 << 0,
+		KEY_MODIFIER_SHIFT = 1 << 1,
+	};
+
+	constexpr size_t KEY_MODIFIER_COMBINATIONS = 4;
+
+	// A chord is a key going down while exactly modifiers are held, not
+	// counting the ignored ones.
+	struct Shortcut
+	{
+		eKeyValue key;
+		uint8_t modifiers;
+		uint8_t ignoredModifiers;
+		eCommand command;
+	};
+
+	constexpr Shortcut SHORTCUTS[] = {
+		{ eKeyValue::Select, KEY_MODIFIER_NONE, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, eCommand::SelectMode },
+		{ eKeyValue::Rect, KEY_MODIFIER_NONE, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, eCommand::RectMode },
+		{ eKeyValue::Backspace, KEY_MODIFIER_NONE, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, eCommand::Remove },
+		{ eKeyValue::F3, KEY_MODIFIER_NONE, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, eCommand::ToggleProfiler },
+		{ eKeyValue::F4, KEY_MODIFIER_NONE, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, eCommand::WriteTrace },
+		{ eKeyValue::RightBracket, KEY_MODIFIER_NONE, KEY_MODIFIER_SHIFT, eCommand::BringForward },
+		{ eKeyValue::RightBracket, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::BringToFront },
+		{ eKeyValue::LeftBracket, KEY_MODIFIER_NONE, KEY_MODIFIER_SHIFT, eCommand::SendBackward },
+		{ eKeyValue::LeftBracket, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::SendToBack },
+		{ eKeyValue::C, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Copy },
+		{ eKeyValue::V, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Paste },
+		{ eKeyValue::D, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Duplicate },
+		{ eKeyValue::Z, KEY_MODIFIER_CTRL, KEY_MODIFIER_NONE, eCommand::Undo },
+		{ eKeyValue::Z, KEY_MODIFIER_CTRL | KEY_MODIFIER_SHIFT, KEY_MODIFIER_NONE, eCommand::Redo },
+		{ eKeyValue::Y, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Redo },
+		{ eKeyValue::S, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Save },
+		{ eKeyValue::O, KEY_MODIFIER_CTRL, KEY_MODIFIER_SHIFT, eCommand::Open },
+	};
+
+	using CommandTable = std::array<eCommand, TOTAL_KEY_COUNT * KEY_MODIFIER_COMBINATIONS>;
+
+	inline bool IsKeyInSet(uint32_t keys, eKeyValue key)
+	{
+		return (keys & (1u << static_cast<int>(key))) != 0;
+	}
+
+	constexpr uint32_t GetModifiers(uint32_t heldKeys)
+	{
+		return ((heldKeys >> static_cast<int>(eKeyValue::Ctrl)) & 1u) * KEY_MODIFIER_CTRL
+			| ((heldKeys >> static_cast<int>(eKeyValue::Shift)) & 1u) * KEY_MODIFIER_SHIFT;
+	}
+
+	constexpr bool IsShortcutMatch(const Shortcut& shortcut, uint32_t modifiers)
+	{
+		return (modifiers & ~static_cast<uint32_t>(shortcut.ignoredModifiers)) == shortcut.modifiers;
+	}
+
+	// One slot per key and modifier combination, filled at compile time.
+	constexpr CommandTable MakeCommandTable()
+	{
+		CommandTable table = {};
+
+		for (const Shortcut& shortcut : SHORTCUTS)
+		{
+			for (uint32_t modifiers = 0; modifiers < KEY_MODIFIER_COMBINATIONS; ++modifiers)
+			{
+				if (IsShortcutMatch(shortcut, modifiers))
+				{
+					table[static_cast<size_t>(shortcut.key) * KEY_MODIFIER_COMBINATIONS + modifiers] = shortcut.command;
+				}
+			}
+		}
+
+		return table;
+	}
+
+	// False if two shortcuts claim the same chord.
+	constexpr bool HasUniqueChords()
+	{
+		for (size_t i = 0; i < std::size(SHORTCUTS); ++i)
+		{
+			for (size_t j = i + 1; j < std::size(SHORTCUTS); ++j)
+			{
+				for (uint32_t modifiers = 0; modifiers < KEY_MODIFIER_COMBINATIONS; ++modifiers)
+				{
+					if (SHORTCUTS[i].key == SHORTCUTS[j].key
+						&& IsShortcutMatch(SHORTCUTS[i], modifiers) && IsShortcutMatch(SHORTCUTS[j], modifiers))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	constexpr CommandTable COMMAND_TABLE = MakeCommandTable();
+
+	// key is the one that just went down; held keys are one bit per eKeyValue.
+	constexpr eCommand FindCommand(eKeyValue key, uint32_t heldKeys)
+	{
+		return COMMAND_TABLE[static_cast<size_t>(key) * KEY_MODIFIER_COMBINATIONS + GetModifiers(heldKeys)];
+	}
+}
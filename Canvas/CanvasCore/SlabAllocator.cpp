@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "SlabAllocator.h"
+#include "Profiler.h"
+
+namespace canvas
+{
+	SlabAllocator::SlabAllocator(size_t slabSize)
+		: mSlabSize(slabSize)
+		, mFreeLists{}
+		, mCursor(nullptr)
+		, mEnd(nullptr)
+		, mStats{ 0, 0, 0, 0, 0, 0 }
+	{
+		DEBUG_BREAK(slabSize >= SLAB_MAX_BLOCK_SIZE);
+	}
+
+	SlabAllocator::~SlabAllocator()
+	{
+		Release();
+	}
+
+	void* SlabAllocator::Allocate(size_t size)
+	{
+		++mStats.allocations;
+
+		if (size > SLAB_MAX_BLOCK_SIZE)
+		{
+			return allocateLarge(size);
+		}
+
+		const size_t SIZE_CLASS = getSizeClass(size);
+		const size_t BLOCK_SIZE = SLAB_MIN_BLOCK_SIZE << SIZE_CLASS;
+		mStats.bytesInUse += BLOCK_SIZE;
+
+		FreeBlock* block = mFreeLists[SIZE_CLASS];
+
+		if (block != nullptr)
+		{
+			mFreeLists[SIZE_CLASS] = block->next;
+			return block;
+		}
+
+		if (mCursor == nullptr || static_cast<size_t>(mEnd - mCursor) < BLOCK_SIZE)
+		{
+			// The tail of the old slab is too small for this class; hand it to the
+			// smaller free lists instead of wasting it.
+			while (mCursor != nullptr && static_cast<size_t>(mEnd - mCursor) >= SLAB_MIN_BLOCK_SIZE)
+			{
+				size_t tailClass = getSizeClass(static_cast<size_t>(mEnd - mCursor));
+
+				if ((SLAB_MIN_BLOCK_SIZE << tailClass) > static_cast<size_t>(mEnd - mCursor))
+				{
+					--tailClass;
+				}
+
+				FreeBlock* tail = reinterpret_cast<FreeBlock*>(mCursor);
+				tail->next = mFreeLists[tailClass];
+				mFreeLists[tailClass] = tail;
+				mCursor += SLAB_MIN_BLOCK_SIZE << tailClass;
+			}
+
+			mCursor = allocateSlab();
+			mEnd = mCursor + mSlabSize;
+		}
+
+		void* memory = mCursor;
+		mCursor += BLOCK_SIZE;
+
+		return memory;
+	}
+
+	void SlabAllocator::Free(void* memory, size_t size)
+	{
+		if (memory == nullptr)
+		{
+			return;
+		}
+
+		++mStats.frees;
+
+		if (size > SLAB_MAX_BLOCK_SIZE)
+		{
+			freeLarge(memory, size);
+			return;
+		}
+
+		const size_t SIZE_CLASS = getSizeClass(size);
+		mStats.bytesInUse -= SLAB_MIN_BLOCK_SIZE << SIZE_CLASS;
+
+		FreeBlock* block = static_cast<FreeBlock*>(memory);
+		block->next = mFreeLists[SIZE_CLASS];
+		mFreeLists[SIZE_CLASS] = block;
+	}
+
+	void SlabAllocator::Release()
+	{
+		for (uint8_t* slab : mSlabs)
+		{
+			::operator delete(slab);
+			++mStats.systemFrees;
+		}
+
+		for (LargeHeader* header : mLargeBlocks)
+		{
+			::operator delete(header);
+			++mStats.systemFrees;
+		}
+
+		mSlabs.clear();
+		mLargeBlocks.clear();
+
+		for (FreeBlock*& freeList : mFreeLists)
+		{
+			freeList = nullptr;
+		}
+
+		mCursor = nullptr;
+		mEnd = nullptr;
+		mStats.bytesInUse = 0;
+		mStats.bytesReserved = 0;
+	}
+
+	void* SlabAllocator::allocateLarge(size_t size)
+	{
+		LargeHeader* header = static_cast<LargeHeader*>(::operator new(sizeof(LargeHeader) + size));
+		header->index = mLargeBlocks.size();
+		mLargeBlocks.push_back(header);
+
+		++mStats.systemAllocations;
+		Profiler::Count(eProfileCounter::Allocations, 1);
+		mStats.bytesInUse += size;
+		mStats.bytesReserved += size;
+
+		return header + 1;
+	}
+
+	void SlabAllocator::freeLarge(void* memory, size_t size)
+	{
+		LargeHeader* header = static_cast<LargeHeader*>(memory) - 1;
+		LargeHeader* last = mLargeBlocks.back();
+
+		mLargeBlocks[header->index] = last;
+		last->index = header->index;
+		mLargeBlocks.pop_back();
+
+		::operator delete(header);
+
+		++mStats.systemFrees;
+		mStats.bytesInUse -= size;
+		mStats.bytesReserved -= size;
+	}
+
+	uint8_t* SlabAllocator::allocateSlab()
+	{
+		uint8_t* slab = static_cast<uint8_t*>(::operator new(mSlabSize));
+		mSlabs.push_back(slab);
+
+		++mStats.systemAllocations;
+		Profiler::Count(eProfileCounter::Allocations, 1);
+		mStats.bytesReserved += mSlabSize;
+
+		return slab;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace canvas
+{
+	struct SlabStats
+	{
+		uint64_t allocations;
+		uint64_t frees;
+		uint64_t systemAllocations;
+		uint64_t systemFrees;
+		size_t bytesInUse;
+		size_t bytesReserved;
+	};
+
+	class SlabAllocator final
+	{
+	public:
+		SlabAllocator(size_t slabSize);
+		~SlabAllocator();
+		SlabAllocator(const SlabAllocator& other) = delete;
+		SlabAllocator& operator=(const SlabAllocator& rhs) = delete;
+
+		void* Allocate(size_t size);
+		void Free(void* memory, size_t size);
+		void Release();
+
+		inline const SlabStats& GetStats() const;
+		inline static size_t GetBlockSize(size_t size);
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		struct LargeHeader
+		{
+			size_t index;
+			size_t padding;
+		};
+
+		void* allocateLarge(size_t size);
+		void freeLarge(void* memory, size_t size);
+		uint8_t* allocateSlab();
+
+		inline static size_t getSizeClass(size_t size);
+
+	private:
+		size_t mSlabSize;
+		FreeBlock* mFreeLists[SLAB_SIZE_CLASS_COUNT];
+		std::vector<uint8_t*> mSlabs;
+		std::vector<LargeHeader*> mLargeBlocks;
+		uint8_t* mCursor;
+		uint8_t* mEnd;
+		SlabStats mStats;
+	};
+
+	inline const SlabStats& SlabAllocator::GetStats() const
+	{
+		return mStats;
+	}
+
+	inline size_t SlabAllocator::GetBlockSize(size_t size)
+	{
+		return size > SLAB_MAX_BLOCK_SIZE ? size : SLAB_MIN_BLOCK_SIZE << getSizeClass(size);
+	}
+
+	inline size_t SlabAllocator::getSizeClass(size_t size)
+	{
+		size_t sizeClass = 0;
+
+		while ((SLAB_MIN_BLOCK_SIZE << sizeClass) < size)
+		{
+			++sizeClass;
+		}
+
+		return sizeClass;
+	}
+}
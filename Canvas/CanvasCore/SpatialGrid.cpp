@@ -0,0 +1,513 @@
+#include "pch.h"
+#include "SpatialGrid.h"
+
+namespace canvas
+{
+	SpatialGrid::SpatialGrid(float cellSize)
+		: mInverseCellSize(1.f / cellSize)
+		, mCells(DEFAULT_OBJECT_CAPACITY, { 0, nullptr, 0, 0 })
+		, mUsedCellsCount(0)
+		, mAllocator(SLAB_SIZE)
+	{
+		mRanges.reserve(DEFAULT_OBJECT_CAPACITY);
+	}
+
+	SpatialGrid::~SpatialGrid()
+	{
+		releaseCells();
+	}
+
+	void SpatialGrid::Insert(ObjectHandle handle, const RectF& rect, bool bFilled)
+	{
+		if (handle.index >= mRanges.size())
+		{
+			mRanges.resize(static_cast<size_t>(handle.index) + 1, { 0, 0, -1, -1, 0, 0, -1, -1 });
+		}
+
+		DEBUG_BREAK(isEmptyRange(mRanges[handle.index]));
+
+		const CellRange range = getCellRange(rect, bFilled);
+		addToCells(handle, range);
+		mRanges[handle.index] = range;
+	}
+
+	// Inserts objects [first, first + count) of the store. The batch's cell
+	// bounds are split into row bands and each band lists the objects that
+	// overlap it, so a band only ever touches its own cells. Cell references
+	// are counted per band, every touched cell is looked up and grown once,
+	// and handles are then scattered straight into the buckets while the
+	// band's buckets are still in cache. Bands own disjoint cells, so both
+	// passes run in parallel without synchronisation.
+	void SpatialGrid::InsertRange(const ObjectStore& objects, size_t first, size_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		uint32_t maxSlot = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			maxSlot = (std::max)(maxSlot, objects.GetHandle(first + i).index);
+		}
+
+		if (maxSlot >= mRanges.size())
+		{
+			mRanges.resize(static_cast<size_t>(maxSlot) + 1, { 0, 0, -1, -1, 0, 0, -1, -1 });
+		}
+
+		ParallelFor(count, [this, &objects, first](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const size_t INDEX = first + i;
+				const ObjectHandle HANDLE = objects.GetHandle(INDEX);
+
+				DEBUG_BREAK(isEmptyRange(mRanges[HANDLE.index]));
+				mRanges[HANDLE.index] = getCellRange(objects.GetRect(INDEX), objects.IsFilled(INDEX));
+			}
+		});
+
+		CellRange bounds = mRanges[objects.GetHandle(first).index];
+
+		for (size_t i = 1; i < count; ++i)
+		{
+			const CellRange& range = mRanges[objects.GetHandle(first + i).index];
+
+			bounds.left = (std::min)(bounds.left, range.left);
+			bounds.top = (std::min)(bounds.top, range.top);
+			bounds.right = (std::max)(bounds.right, range.right);
+			bounds.bottom = (std::max)(bounds.bottom, range.bottom);
+		}
+
+		const uint64_t WIDTH = static_cast<uint64_t>(static_cast<int64_t>(bounds.right) - bounds.left + 1);
+		const uint64_t HEIGHT = static_cast<uint64_t>(static_cast<int64_t>(bounds.bottom) - bounds.top + 1);
+
+		if (WIDTH * HEIGHT > count * GRID_BULK_MAX_CELLS_PER_OBJECT)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const ObjectHandle HANDLE = objects.GetHandle(first + i);
+				addToCells(HANDLE, mRanges[HANDLE.index]);
+			}
+
+			return;
+		}
+
+		const int LEFT = bounds.left;
+		const int TOP = bounds.top;
+		const size_t BAND_HEIGHT = static_cast<size_t>((HEIGHT * GRID_BULK_BAND_OBJECTS + count - 1) / count);
+		const size_t BANDS_COUNT = static_cast<size_t>((HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT);
+		const size_t MIN_BANDS_COUNT = count < PARALLEL_MIN_CHUNK_SIZE * 2 ? BANDS_COUNT : 1;
+
+		std::vector<uint32_t> bandStarts(BANDS_COUNT + 1, 0);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const CellRange& range = mRanges[objects.GetHandle(first + i).index];
+
+			const size_t LAST_BAND = static_cast<size_t>(range.bottom - TOP) / BAND_HEIGHT;
+
+			for (size_t band = static_cast<size_t>(range.top - TOP) / BAND_HEIGHT; band <= LAST_BAND; ++band)
+			{
+				++bandStarts[band + 1];
+			}
+		}
+
+		for (size_t band = 0; band < BANDS_COUNT; ++band)
+		{
+			bandStarts[band + 1] += bandStarts[band];
+		}
+
+		std::vector<BandEntry> bandEntries(bandStarts[BANDS_COUNT]);
+		std::vector<uint32_t> bandCursors(bandStarts.begin(), bandStarts.end() - 1);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const ObjectHandle HANDLE = objects.GetHandle(first + i);
+			const CellRange& range = mRanges[HANDLE.index];
+
+			const size_t LAST_BAND = static_cast<size_t>(range.bottom - TOP) / BAND_HEIGHT;
+
+			for (size_t band = static_cast<size_t>(range.top - TOP) / BAND_HEIGHT; band <= LAST_BAND; ++band)
+			{
+				bandEntries[bandCursors[band]++] = { HANDLE, range };
+			}
+		}
+
+		std::vector<uint32_t> counts(static_cast<size_t>(WIDTH * HEIGHT), 0);
+
+		auto forEachBandCell = [&bandStarts, &bandEntries, LEFT, TOP, WIDTH, BAND_HEIGHT](size_t band, const auto& func)
+		{
+			const int BAND_TOP = TOP + static_cast<int>(band * BAND_HEIGHT);
+			const int BAND_BOTTOM = BAND_TOP + static_cast<int>(BAND_HEIGHT) - 1;
+
+			for (size_t i = bandStarts[band]; i < bandStarts[band + 1]; ++i)
+			{
+				const ObjectHandle HANDLE = bandEntries[i].handle;
+				CellRange range = bandEntries[i].range;
+
+				range.top = (std::max)(range.top, BAND_TOP);
+				range.bottom = (std::min)(range.bottom, BAND_BOTTOM);
+
+				forEachCell(range, [&func, HANDLE, LEFT, TOP, WIDTH](int x, int y)
+				{
+					func(static_cast<size_t>(y - TOP) * WIDTH + (x - LEFT), HANDLE);
+				});
+			}
+		};
+
+		ParallelFor(BANDS_COUNT, MIN_BANDS_COUNT, [&counts, &forEachBandCell](size_t begin, size_t end)
+		{
+			for (size_t band = begin; band < end; ++band)
+			{
+				forEachBandCell(band, [&counts](size_t cellIndex, ObjectHandle)
+				{
+					++counts[cellIndex];
+				});
+			}
+		});
+
+		size_t usedCellsCount = 0;
+
+		for (uint32_t cellCount : counts)
+		{
+			usedCellsCount += cellCount != 0;
+		}
+
+		reserveCells(usedCellsCount);
+
+		std::vector<ObjectHandle*> cursors(counts.size(), nullptr);
+
+		for (size_t cellIndex = 0; cellIndex < counts.size(); ++cellIndex)
+		{
+			const uint32_t CELL_COUNT = counts[cellIndex];
+
+			if (CELL_COUNT == 0)
+			{
+				continue;
+			}
+
+			const int X = LEFT + static_cast<int>(cellIndex % WIDTH);
+			const int Y = TOP + static_cast<int>(cellIndex / WIDTH);
+
+			Cell& cell = findOrAddCell(makeKey(X, Y), (std::max)(CELL_COUNT, static_cast<uint32_t>(GRID_CELL_INITIAL_CAPACITY)));
+			reserveHandles(cell, cell.count + CELL_COUNT);
+
+			cursors[cellIndex] = cell.handles + cell.count;
+			cell.count += CELL_COUNT;
+		}
+
+		ParallelFor(BANDS_COUNT, MIN_BANDS_COUNT, [&cursors, &forEachBandCell](size_t begin, size_t end)
+		{
+			for (size_t band = begin; band < end; ++band)
+			{
+				forEachBandCell(band, [&cursors](size_t cellIndex, ObjectHandle handle)
+				{
+					*cursors[cellIndex]++ = handle;
+				});
+			}
+		});
+	}
+
+	void SpatialGrid::Update(ObjectHandle handle, const RectF& rect, bool bFilled)
+	{
+		DEBUG_BREAK(handle.index < mRanges.size());
+		DEBUG_BREAK(!isEmptyRange(mRanges[handle.index]));
+
+		CellRange& prevRange = mRanges[handle.index];
+		const CellRange range = getCellRange(rect, bFilled);
+
+		if (isSameRange(prevRange, range))
+		{
+			return;
+		}
+
+		removeFromCells(handle, prevRange);
+		addToCells(handle, range);
+		prevRange = range;
+	}
+
+	void SpatialGrid::Remove(ObjectHandle handle)
+	{
+		DEBUG_BREAK(handle.index < mRanges.size());
+		DEBUG_BREAK(!isEmptyRange(mRanges[handle.index]));
+
+		CellRange& range = mRanges[handle.index];
+		removeFromCells(handle, range);
+		range = { 0, 0, -1, -1, 0, 0, -1, -1 };
+	}
+
+	void SpatialGrid::Clear()
+	{
+		releaseCells();
+		mRanges.clear();
+	}
+
+	const ObjectHandle* SpatialGrid::GetCandidates(float x, float y, size_t& outCount) const
+	{
+		const Cell* cell = findCell(makeKey(toCell(x), toCell(y)));
+
+		if (cell == nullptr)
+		{
+			outCount = 0;
+			return nullptr;
+		}
+
+		outCount = cell->count;
+		return cell->handles;
+	}
+
+	void SpatialGrid::GetCandidates(const RectF& rect, std::vector<ObjectHandle>& outCandidates) const
+	{
+		outCandidates.clear();
+
+		const int LEFT = toCell(rect.left);
+		const int TOP = toCell(rect.top);
+		const int RIGHT = toCell(rect.right);
+		const int BOTTOM = toCell(rect.bottom);
+
+		// A zoomed out view can span more cells than the table holds; walk the table then.
+		if ((static_cast<double>(RIGHT) - LEFT + 1) * (static_cast<double>(BOTTOM) - TOP + 1) > static_cast<double>(mCells.size()))
+		{
+			for (const Cell& cell : mCells)
+			{
+				const int X = static_cast<int>(static_cast<uint32_t>(cell.key >> 32));
+				const int Y = static_cast<int>(static_cast<uint32_t>(cell.key));
+
+				if (cell.handles != nullptr && X >= LEFT && X <= RIGHT && Y >= TOP && Y <= BOTTOM)
+				{
+					outCandidates.insert(outCandidates.end(), cell.handles, cell.handles + cell.count);
+				}
+			}
+
+			return;
+		}
+
+		for (int y = TOP; y <= BOTTOM; ++y)
+		{
+			for (int x = LEFT; x <= RIGHT; ++x)
+			{
+				const Cell* cell = findCell(makeKey(x, y));
+
+				if (cell != nullptr)
+				{
+					outCandidates.insert(outCandidates.end(), cell->handles, cell->handles + cell->count);
+				}
+			}
+		}
+	}
+
+	SpatialGrid::CellRange SpatialGrid::getCellRange(const RectF& rect, bool bFilled) const
+	{
+		const float LEFT = rect.left < rect.right ? rect.left : rect.right;
+		const float RIGHT = rect.left < rect.right ? rect.right : rect.left;
+		const float TOP = rect.top < rect.bottom ? rect.top : rect.bottom;
+		const float BOTTOM = rect.top < rect.bottom ? rect.bottom : rect.top;
+
+		CellRange range = {
+			toCell(LEFT - OBJECT_MARGIN),
+			toCell(TOP - OBJECT_MARGIN),
+			toCell(RIGHT + OBJECT_MARGIN),
+			toCell(BOTTOM + OBJECT_MARGIN),
+			0,
+			0,
+			-1,
+			-1
+		};
+
+		if (!bFilled)
+		{
+			// A hollow rect is only hit on its edge bands, so cells lying entirely
+			// inside the band-free interior never need to reference it.
+			range.innerLeft = toCell(LEFT + OBJECT_MARGIN) + 1;
+			range.innerTop = toCell(TOP + OBJECT_MARGIN) + 1;
+			range.innerRight = toCell(RIGHT - OBJECT_MARGIN) - 1;
+			range.innerBottom = toCell(BOTTOM - OBJECT_MARGIN) - 1;
+		}
+
+		return range;
+	}
+
+	void SpatialGrid::addToCells(ObjectHandle handle, const CellRange& range)
+	{
+		forEachCell(range, [this, handle](int x, int y)
+		{
+			appendHandles(findOrAddCell(makeKey(x, y), GRID_CELL_INITIAL_CAPACITY), &handle, 1);
+		});
+	}
+
+	void SpatialGrid::removeFromCells(ObjectHandle handle, const CellRange& range)
+	{
+		forEachCell(range, [this, handle](int x, int y)
+		{
+			Cell* cell = const_cast<Cell*>(findCell(makeKey(x, y)));
+			DEBUG_BREAK(cell != nullptr);
+
+			for (uint32_t i = 0; i < cell->count; ++i)
+			{
+				if (cell->handles[i] == handle)
+				{
+					cell->handles[i] = cell->handles[--cell->count];
+					break;
+				}
+			}
+
+			if (cell->count == 0)
+			{
+				eraseCell(static_cast<size_t>(cell - mCells.data()));
+			}
+		});
+	}
+
+	const SpatialGrid::Cell* SpatialGrid::findCell(uint64_t key) const
+	{
+		const size_t MASK = mCells.size() - 1;
+
+		for (size_t i = hashKey(key) & MASK; ; i = (i + 1) & MASK)
+		{
+			const Cell& cell = mCells[i];
+
+			if (cell.handles == nullptr)
+			{
+				return nullptr;
+			}
+
+			if (cell.key == key)
+			{
+				return &cell;
+			}
+		}
+	}
+
+	SpatialGrid::Cell& SpatialGrid::findOrAddCell(uint64_t key, uint32_t capacity)
+	{
+		reserveCells(1);
+
+		const size_t MASK = mCells.size() - 1;
+		size_t i = hashKey(key) & MASK;
+
+		while (mCells[i].handles != nullptr)
+		{
+			if (mCells[i].key == key)
+			{
+				return mCells[i];
+			}
+
+			i = (i + 1) & MASK;
+		}
+
+		Cell& cell = mCells[i];
+		cell.key = key;
+		cell.handles = static_cast<ObjectHandle*>(mAllocator.Allocate(capacity * sizeof(ObjectHandle)));
+		cell.count = 0;
+		cell.capacity = capacity;
+		++mUsedCellsCount;
+
+		return cell;
+	}
+
+	// Objects move through an unbounded world, so emptied cells give their
+	// bucket back. Later cells of the probe run shift back into the hole, which
+	// keeps lookups free of tombstones.
+	void SpatialGrid::eraseCell(size_t slot)
+	{
+		const size_t MASK = mCells.size() - 1;
+
+		mAllocator.Free(mCells[slot].handles, mCells[slot].capacity * sizeof(ObjectHandle));
+
+		for (size_t i = (slot + 1) & MASK; mCells[i].handles != nullptr; i = (i + 1) & MASK)
+		{
+			const size_t HOME = hashKey(mCells[i].key) & MASK;
+
+			if (((i - HOME) & MASK) >= ((i - slot) & MASK))
+			{
+				mCells[slot] = mCells[i];
+				slot = i;
+			}
+		}
+
+		mCells[slot] = { 0, nullptr, 0, 0 };
+		--mUsedCellsCount;
+	}
+
+	void SpatialGrid::appendHandles(Cell& cell, const ObjectHandle* handles, uint32_t count)
+	{
+		reserveHandles(cell, cell.count + count);
+
+		memcpy(cell.handles + cell.count, handles, count * sizeof(ObjectHandle));
+		cell.count += count;
+	}
+
+	void SpatialGrid::reserveHandles(Cell& cell, uint32_t capacity)
+	{
+		if (capacity <= cell.capacity)
+		{
+			return;
+		}
+
+		uint32_t grownCapacity = cell.capacity * 2;
+
+		while (grownCapacity < capacity)
+		{
+			grownCapacity *= 2;
+		}
+
+		ObjectHandle* handles = static_cast<ObjectHandle*>(mAllocator.Allocate(grownCapacity * sizeof(ObjectHandle)));
+
+		memcpy(handles, cell.handles, cell.count * sizeof(ObjectHandle));
+		mAllocator.Free(cell.handles, cell.capacity * sizeof(ObjectHandle));
+
+		cell.handles = handles;
+		cell.capacity = grownCapacity;
+	}
+
+	void SpatialGrid::reserveCells(size_t count)
+	{
+		size_t size = mCells.size();
+
+		while ((mUsedCellsCount + count) * 2 > size)
+		{
+			size *= 2;
+		}
+
+		if (size == mCells.size())
+		{
+			return;
+		}
+
+		std::vector<Cell> cells(size, { 0, nullptr, 0, 0 });
+		const size_t MASK = cells.size() - 1;
+
+		for (const Cell& cell : mCells)
+		{
+			if (cell.handles == nullptr)
+			{
+				continue;
+			}
+
+			size_t i = hashKey(cell.key) & MASK;
+
+			while (cells[i].handles != nullptr)
+			{
+				i = (i + 1) & MASK;
+			}
+
+			cells[i] = cell;
+		}
+
+		mCells.swap(cells);
+	}
+
+	void SpatialGrid::releaseCells()
+	{
+		for (Cell& cell : mCells)
+		{
+			cell = { 0, nullptr, 0, 0 };
+		}
+
+		mUsedCellsCount = 0;
+		mAllocator.Release();
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ObjectStore.h"
+#include "SlabAllocator.h"
+
+namespace canvas
+{
+	class SpatialGrid final
+	{
+	public:
+		SpatialGrid(float cellSize);
+		~SpatialGrid();
+		SpatialGrid(const SpatialGrid& other) = delete;
+		SpatialGrid& operator=(const SpatialGrid& rhs) = delete;
+
+		void Insert(ObjectHandle handle, const RectF& rect, bool bFilled);
+		void InsertRange(const ObjectStore& objects, size_t first, size_t count);
+		void Update(ObjectHandle handle, const RectF& rect, bool bFilled);
+		void Remove(ObjectHandle handle);
+		void Clear();
+
+		const ObjectHandle* GetCandidates(float x, float y, size_t& outCount) const;
+		void GetCandidates(const RectF& rect, std::vector<ObjectHandle>& outCandidates) const;
+
+		inline const SlabStats& GetAllocatorStats() const;
+
+	private:
+		struct Cell
+		{
+			uint64_t key;
+			ObjectHandle* handles;
+			uint32_t count;
+			uint32_t capacity;
+		};
+
+		struct CellRange
+		{
+			int left;
+			int top;
+			int right;
+			int bottom;
+			int innerLeft;
+			int innerTop;
+			int innerRight;
+			int innerBottom;
+		};
+
+		struct BandEntry
+		{
+			ObjectHandle handle;
+			CellRange range;
+		};
+
+		CellRange getCellRange(const RectF& rect, bool bFilled) const;
+		void addToCells(ObjectHandle handle, const CellRange& range);
+		void removeFromCells(ObjectHandle handle, const CellRange& range);
+		const Cell* findCell(uint64_t key) const;
+		Cell& findOrAddCell(uint64_t key, uint32_t capacity);
+		void eraseCell(size_t slot);
+		void appendHandles(Cell& cell, const ObjectHandle* handles, uint32_t count);
+		void reserveHandles(Cell& cell, uint32_t capacity);
+		void reserveCells(size_t count);
+		void releaseCells();
+
+		template<typename Func>
+		inline static void forEachCell(const CellRange& range, const Func& func);
+
+		inline int toCell(float coord) const;
+		inline static uint64_t makeKey(int cellX, int cellY);
+		inline static size_t hashKey(uint64_t key);
+		inline static bool isSameRange(const CellRange& lhs, const CellRange& rhs);
+		inline static bool isInnerCell(const CellRange& range, int cellX, int cellY);
+		inline static bool isEmptyRange(const CellRange& range);
+
+	private:
+		float mInverseCellSize;
+		std::vector<Cell> mCells;
+		size_t mUsedCellsCount;
+		std::vector<CellRange> mRanges;
+		SlabAllocator mAllocator;
+	};
+
+	inline const SlabStats& SpatialGrid::GetAllocatorStats() const
+	{
+		return mAllocator.GetStats();
+	}
+
+	template<typename Func>
+	inline void SpatialGrid::forEachCell(const CellRange& range, const Func& func)
+	{
+		for (int y = range.top; y <= range.bottom; ++y)
+		{
+			for (int x = range.left; x <= range.right; ++x)
+			{
+				if (isInnerCell(range, x, y))
+				{
+					x = range.innerRight;
+					continue;
+				}
+
+				func(x, y);
+			}
+		}
+	}
+
+	inline int SpatialGrid::toCell(float coord) const
+	{
+		return static_cast<int>(floorf(coord * mInverseCellSize));
+	}
+
+	inline uint64_t SpatialGrid::makeKey(int cellX, int cellY)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+	}
+
+	inline size_t SpatialGrid::hashKey(uint64_t key)
+	{
+		key ^= key >> 29;
+		key *= 0x9E3779B97F4A7C15ull;
+		return static_cast<size_t>(key ^ (key >> 32));
+	}
+
+	inline bool SpatialGrid::isSameRange(const CellRange& lhs, const CellRange& rhs)
+	{
+		return lhs.left == rhs.left && lhs.top == rhs.top && lhs.right == rhs.right && lhs.bottom == rhs.bottom
+			&& lhs.innerLeft == rhs.innerLeft && lhs.innerTop == rhs.innerTop
+			&& lhs.innerRight == rhs.innerRight && lhs.innerBottom == rhs.innerBottom;
+	}
+
+	inline bool SpatialGrid::isEmptyRange(const CellRange& range)
+	{
+		return range.left > range.right;
+	}
+
+	inline bool SpatialGrid::isInnerCell(const CellRange& range, int cellX, int cellY)
+	{
+		return cellX >= range.innerLeft && cellX <= range.innerRight
+			&& cellY >= range.innerTop && cellY <= range.innerBottom;
+	}
+}
@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "TilePyramid.h"
+#include "CpuRenderBackend.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	TilePyramid::TilePyramid()
+		: mThreshold(LOD_ZOOM_THRESHOLD)
+		, mFrame(0)
+		, mJob{ nullptr, 0.f, {}, {}, {} }
+		, mbBusy(false)
+		, mbCancelled(false)
+	{
+	}
+
+	TilePyramid::~TilePyramid()
+	{
+		Cancel();
+	}
+
+	void TilePyramid::SetThreshold(float threshold)
+	{
+		if (threshold == mThreshold)
+		{
+			return;
+		}
+
+		Clear();
+		mThreshold = threshold;
+	}
+
+	// The finest level that is not magnified at this zoom.
+	uint32_t TilePyramid::GetLevel(float zoom) const
+	{
+		uint32_t level = 0;
+
+		while (level < LOD_MAX_LEVEL && zoom <= getScale(level + 1, mThreshold))
+		{
+			++level;
+		}
+
+		return level;
+	}
+
+	// Null if the tile is not built yet; it is then requested for the next build.
+	const uint32_t* TilePyramid::FindTile(uint32_t level, int x, int y)
+	{
+		const uint64_t KEY = makeKey(level, x, y);
+		auto it = mTiles.find(KEY);
+
+		if (it != mTiles.end())
+		{
+			it->second.lastUsed = mFrame;
+			return it->second.pixels.data();
+		}
+
+		if (mPending.insert(KEY).second)
+		{
+			mRequests.push_back(KEY);
+		}
+
+		return nullptr;
+	}
+
+	// rect and margin are in the world. Tiles still being built from an older
+	// snapshot are thrown away when they arrive.
+	void TilePyramid::Invalidate(const RectF& rect, float margin)
+	{
+		for (auto it = mTiles.begin(); it != mTiles.end();)
+		{
+			const float PIXEL = 1.f / getScale(getKeyLevel(it->first), mThreshold);
+			const RectF TILE = getTileRect(it->first, mThreshold);
+
+			if (rect.left - margin - PIXEL <= TILE.right && rect.right + margin + PIXEL >= TILE.left
+				&& rect.top - margin - PIXEL <= TILE.bottom && rect.bottom + margin + PIXEL >= TILE.top)
+			{
+				it = mTiles.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (size_t i = 0; i < mJob.keys.size(); ++i)
+		{
+			const float PIXEL = 1.f / getScale(getKeyLevel(mJob.keys[i]), mJob.threshold);
+			const RectF TILE = getTileRect(mJob.keys[i], mJob.threshold);
+
+			if (rect.left - margin - PIXEL <= TILE.right && rect.right + margin + PIXEL >= TILE.left
+				&& rect.top - margin - PIXEL <= TILE.bottom && rect.bottom + margin + PIXEL >= TILE.top)
+			{
+				mJob.discarded[i] = 1;
+			}
+		}
+	}
+
+	void TilePyramid::Clear()
+	{
+		Cancel();
+
+		mTiles.clear();
+		mRequests.clear();
+		mPending.clear();
+	}
+
+	// Once per frame, before any FindTile: takes in a finished build and
+	// drops the least recently drawn tiles past LOD_MAX_TILES.
+	void TilePyramid::Update()
+	{
+		++mFrame;
+
+		if (!mJob.keys.empty() && !IsBuilding())
+		{
+			wait();
+
+			for (size_t i = 0; i < mJob.keys.size(); ++i)
+			{
+				mPending.erase(mJob.keys[i]);
+
+				if (mJob.discarded[i] == 0 && !mJob.pixels[i].empty())
+				{
+					mTiles[mJob.keys[i]] = { std::move(mJob.pixels[i]), mFrame };
+				}
+			}
+
+			mJob.snapshot.reset();
+			mJob.keys.clear();
+			mJob.pixels.clear();
+			mJob.discarded.clear();
+		}
+
+		evict();
+	}
+
+	// Starts building every requested tile, unless a build is running or
+	// someone else holds the store's snapshot.
+	bool TilePyramid::Build(ObjectStore& objects)
+	{
+		if (mRequests.empty() || !mJob.keys.empty() || objects.HasSnapshot())
+		{
+			return false;
+		}
+
+		wait();
+
+		mJob.snapshot = objects.TakeSnapshot();
+		mJob.threshold = mThreshold;
+		mJob.keys.swap(mRequests);
+		mJob.pixels.assign(mJob.keys.size(), {});
+		mJob.discarded.assign(mJob.keys.size(), 0);
+		mRequests.clear();
+
+		mbCancelled.store(false, std::memory_order_relaxed);
+		mbBusy.store(true, std::memory_order_release);
+
+		mThread = std::thread([this]()
+		{
+			Tracer::SetThreadName("tiles");
+
+			{
+				TraceScope scope("tiles");
+				build(mJob, mbCancelled);
+			}
+
+			mbBusy.store(false, std::memory_order_release);
+		});
+
+		return true;
+	}
+
+	// Blocks until the worker lets go of its snapshot. What it built is lost
+	// and gets requested again.
+	void TilePyramid::Cancel()
+	{
+		mbCancelled.store(true, std::memory_order_relaxed);
+		wait();
+
+		for (uint64_t key : mJob.keys)
+		{
+			mPending.erase(key);
+		}
+
+		mJob.snapshot.reset();
+		mJob.keys.clear();
+		mJob.pixels.clear();
+		mJob.discarded.clear();
+	}
+
+	void TilePyramid::wait()
+	{
+		if (mThread.joinable())
+		{
+			mThread.join();
+		}
+	}
+
+	void TilePyramid::evict()
+	{
+		if (mTiles.size() <= LOD_MAX_TILES)
+		{
+			return;
+		}
+
+		std::vector<std::pair<uint64_t, uint64_t>> ages;
+		ages.reserve(mTiles.size());
+
+		for (const auto& tile : mTiles)
+		{
+			ages.push_back({ tile.second.lastUsed, tile.first });
+		}
+
+		const size_t EXCESS = mTiles.size() - LOD_MAX_TILES;
+		std::nth_element(ages.begin(), ages.begin() + EXCESS, ages.end());
+
+		for (size_t i = 0; i < EXCESS; ++i)
+		{
+			mTiles.erase(ages[i].second);
+		}
+	}
+
+	// One pass over the snapshot files every object under the tiles it
+	// touches, then each tile is drawn back to front on its own.
+	void TilePyramid::build(Job& job, const std::atomic<bool>& bCancelled)
+	{
+		struct Draw
+		{
+			uint64_t zKey;
+			size_t index;
+			RectF rect;
+			ColorF lineColor;
+			ColorF backgroundColor;
+			float strokeWidth;
+		};
+
+		std::unordered_map<uint64_t, uint32_t> slots;
+		std::vector<std::vector<Draw>> draws(job.keys.size());
+		uint32_t levels = 0;
+
+		for (uint32_t i = 0; i < job.keys.size(); ++i)
+		{
+			slots[job.keys[i]] = i;
+			levels |= 1u << getKeyLevel(job.keys[i]);
+		}
+
+		ObjectSnapshot& snapshot = *job.snapshot;
+		std::unique_ptr<ObjectPage> scratch = std::make_unique<ObjectPage>();
+
+		for (size_t page = 0; page < snapshot.GetPagesCount() && !bCancelled.load(std::memory_order_relaxed); ++page)
+		{
+			const ObjectPage& data = snapshot.ReadPage(page, *scratch);
+
+			for (size_t i = 0; i < snapshot.GetPageCount(page); ++i)
+			{
+				const Draw DRAW = {
+					data.zKeys[i],
+					page * SNAPSHOT_PAGE_SIZE + i,
+					{ data.lefts[i], data.tops[i], data.rights[i], data.bottoms[i] },
+					data.lineColors[i],
+					data.backgroundColors[i],
+					data.strokeWidths[i]
+				};
+				const float LEFT = (std::min)(DRAW.rect.left, DRAW.rect.right);
+				const float TOP = (std::min)(DRAW.rect.top, DRAW.rect.bottom);
+				const float RIGHT = (std::max)(DRAW.rect.left, DRAW.rect.right);
+				const float BOTTOM = (std::max)(DRAW.rect.top, DRAW.rect.bottom);
+
+				for (uint32_t level = 0; level <= LOD_MAX_LEVEL; ++level)
+				{
+					if ((levels & (1u << level)) == 0)
+					{
+						continue;
+					}
+
+					const float TILE_SIZE = LOD_TILE_SIZE / getScale(level, job.threshold);
+					const float MARGIN = DRAW.strokeWidth / 2 + 1.f / getScale(level, job.threshold);
+					const int TILE_LEFT = toTileCoord(LEFT - MARGIN, TILE_SIZE);
+					const int TILE_TOP = toTileCoord(TOP - MARGIN, TILE_SIZE);
+					const int TILE_RIGHT = toTileCoord(RIGHT + MARGIN, TILE_SIZE);
+					const int TILE_BOTTOM = toTileCoord(BOTTOM + MARGIN, TILE_SIZE);
+
+					// A huge object is cheaper to test against the requested tiles.
+					if (static_cast<uint64_t>(TILE_RIGHT - TILE_LEFT + 1) * (TILE_BOTTOM - TILE_TOP + 1) > job.keys.size())
+					{
+						for (size_t k = 0; k < job.keys.size(); ++k)
+						{
+							const RectF TILE = getTileRect(job.keys[k], job.threshold);
+
+							if (getKeyLevel(job.keys[k]) == level && LEFT - MARGIN <= TILE.right && RIGHT + MARGIN >= TILE.left
+								&& TOP - MARGIN <= TILE.bottom && BOTTOM + MARGIN >= TILE.top)
+							{
+								draws[k].push_back(DRAW);
+							}
+						}
+
+						continue;
+					}
+
+					for (int y = TILE_TOP; y <= TILE_BOTTOM; ++y)
+					{
+						for (int x = TILE_LEFT; x <= TILE_RIGHT; ++x)
+						{
+							auto it = slots.find(makeKey(level, x, y));
+
+							if (it != slots.end())
+							{
+								draws[it->second].push_back(DRAW);
+							}
+						}
+					}
+				}
+			}
+
+			snapshot.ReleasePage(page);
+		}
+
+		snapshot.Finish();
+
+		CpuRenderBackend backend(LOD_TILE_SIZE, LOD_TILE_SIZE);
+
+		for (size_t k = 0; k < job.keys.size() && !bCancelled.load(std::memory_order_relaxed); ++k)
+		{
+			const float SCALE = getScale(getKeyLevel(job.keys[k]), job.threshold);
+			const RectF TILE = getTileRect(job.keys[k], job.threshold);
+
+			std::sort(draws[k].begin(), draws[k].end(), [](const Draw& lhs, const Draw& rhs)
+			{
+				return lhs.zKey < rhs.zKey || (lhs.zKey == rhs.zKey && lhs.index < rhs.index);
+			});
+
+			backend.BeginFrame();
+			backend.Clear(MakeColor(0xFFFFFF, 1.f));
+
+			for (const Draw& draw : draws[k])
+			{
+				const RectF RECT = {
+					(draw.rect.left - TILE.left) * SCALE,
+					(draw.rect.top - TILE.top) * SCALE,
+					(draw.rect.right - TILE.left) * SCALE,
+					(draw.rect.bottom - TILE.top) * SCALE
+				};
+
+				backend.FillRect(RECT, draw.backgroundColor);
+				backend.StrokeRect(RECT, draw.lineColor, draw.strokeWidth * SCALE);
+			}
+
+			backend.EndFrame();
+			job.pixels[k] = backend.GetPixels();
+		}
+	}
+
+	RectF TilePyramid::getTileRect(uint64_t key, float threshold)
+	{
+		// Shifting the 28-bit fields to the top of an int sign-extends them on the way back.
+		const int X = static_cast<int32_t>(static_cast<uint32_t>((key >> 28) & LOD_TILE_COORD_MASK) << 4) >> 4;
+		const int Y = static_cast<int32_t>(static_cast<uint32_t>(key & LOD_TILE_COORD_MASK) << 4) >> 4;
+		const float TILE_SIZE = LOD_TILE_SIZE / getScale(getKeyLevel(key), threshold);
+
+		return { X * TILE_SIZE, Y * TILE_SIZE, (X + 1) * TILE_SIZE, (Y + 1) * TILE_SIZE };
+	}
+}
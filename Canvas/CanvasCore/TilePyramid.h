@@ -0,0 +1,139 @@
+#pragma once
+
+#include "ObjectStore.h"
+
+namespace canvas
+{
+	// Pre-rasterized scene content for zoomed out views. Level l is drawn at
+	// threshold / 2^l pixels per world unit and cut into LOD_TILE_SIZE pixel
+	// tiles. Tiles that are missing while a frame is drawn are requested, and
+	// all requests are built together on a worker thread from one snapshot.
+	// A change under a tile drops it until it is requested again.
+	class TilePyramid final
+	{
+	public:
+		TilePyramid();
+		~TilePyramid();
+		TilePyramid(const TilePyramid& other) = delete;
+		TilePyramid& operator=(const TilePyramid& rhs) = delete;
+
+		void SetThreshold(float threshold);
+		uint32_t GetLevel(float zoom) const;
+		const uint32_t* FindTile(uint32_t level, int x, int y);
+		void Invalidate(const RectF& rect, float margin);
+		void Clear();
+		void Update();
+		bool Build(ObjectStore& objects);
+		void Cancel();
+
+		inline bool IsActive(float zoom) const;
+		inline bool IsBuilding() const;
+		inline bool HasRequests() const;
+		inline float GetThreshold() const;
+		inline size_t GetTilesCount() const;
+		inline int GetTileCoord(float value, uint32_t level) const;
+		inline RectF GetTileRect(uint32_t level, int x, int y) const;
+
+	private:
+		struct Tile
+		{
+			std::vector<uint32_t> pixels;
+			uint64_t lastUsed;
+		};
+
+		// Owned by the worker from Build until mbBusy drops, except discarded,
+		// which only the main thread touches.
+		struct Job
+		{
+			std::shared_ptr<ObjectSnapshot> snapshot;
+			float threshold;
+			std::vector<uint64_t> keys;
+			std::vector<std::vector<uint32_t>> pixels;
+			std::vector<uint8_t> discarded;
+		};
+
+		void wait();
+		void evict();
+
+		static void build(Job& job, const std::atomic<bool>& bCancelled);
+		static RectF getTileRect(uint64_t key, float threshold);
+
+		inline static uint64_t makeKey(uint32_t level, int x, int y);
+		inline static uint32_t getKeyLevel(uint64_t key);
+		inline static float getScale(uint32_t level, float threshold);
+		inline static int toTileCoord(float value, float tileSize);
+
+	private:
+		float mThreshold;
+		uint64_t mFrame;
+		std::unordered_map<uint64_t, Tile> mTiles;
+		std::vector<uint64_t> mRequests;
+		std::unordered_set<uint64_t> mPending;
+
+		Job mJob;
+		std::thread mThread;
+		std::atomic<bool> mbBusy;
+		std::atomic<bool> mbCancelled;
+	};
+
+	// A threshold of zero turns the pyramid off.
+	inline bool TilePyramid::IsActive(float zoom) const
+	{
+		return zoom < mThreshold;
+	}
+
+	inline bool TilePyramid::IsBuilding() const
+	{
+		return mbBusy.load(std::memory_order_acquire);
+	}
+
+	inline bool TilePyramid::HasRequests() const
+	{
+		return !mRequests.empty();
+	}
+
+	inline float TilePyramid::GetThreshold() const
+	{
+		return mThreshold;
+	}
+
+	inline size_t TilePyramid::GetTilesCount() const
+	{
+		return mTiles.size();
+	}
+
+	inline int TilePyramid::GetTileCoord(float value, uint32_t level) const
+	{
+		return toTileCoord(value, LOD_TILE_SIZE / getScale(level, mThreshold));
+	}
+
+	inline RectF TilePyramid::GetTileRect(uint32_t level, int x, int y) const
+	{
+		return getTileRect(makeKey(level, x, y), mThreshold);
+	}
+
+	// Level in the top byte, then x and y as 28-bit two's complement.
+	inline uint64_t TilePyramid::makeKey(uint32_t level, int x, int y)
+	{
+		return static_cast<uint64_t>(level) << 56
+			| (static_cast<uint64_t>(static_cast<uint32_t>(x)) & LOD_TILE_COORD_MASK) << 28
+			| (static_cast<uint64_t>(static_cast<uint32_t>(y)) & LOD_TILE_COORD_MASK);
+	}
+
+	inline uint32_t TilePyramid::getKeyLevel(uint64_t key)
+	{
+		return static_cast<uint32_t>(key >> 56);
+	}
+
+	inline float TilePyramid::getScale(uint32_t level, float threshold)
+	{
+		return ldexpf(threshold, -static_cast<int>(level));
+	}
+
+	inline int TilePyramid::toTileCoord(float value, float tileSize)
+	{
+		const float LIMIT = static_cast<float>(LOD_TILE_COORD_MASK >> 2);
+
+		return static_cast<int>((std::min)((std::max)(floorf(value / tileSize), -LIMIT), LIMIT));
+	}
+}
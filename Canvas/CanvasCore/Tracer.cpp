@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "Tracer.h"
+#include "MappedFile.h"
+
+namespace canvas
+{
+	std::atomic<bool> Tracer::mbEnabled(false);
+	std::atomic<uint32_t> Tracer::mNextThreadId(1);
+	std::mutex Tracer::mMutex;
+	std::vector<std::unique_ptr<Tracer::Ring>> Tracer::mRings;
+	std::vector<Tracer::Ring*> Tracer::mFreeRings;
+	std::vector<Tracer::ThreadName> Tracer::mThreadNames;
+
+	Tracer::Lease::~Lease()
+	{
+		if (ring != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFreeRings.push_back(ring);
+		}
+	}
+
+	void Tracer::Enable()
+	{
+		mbEnabled.store(true, std::memory_order_relaxed);
+	}
+
+	void Tracer::Disable()
+	{
+		mbEnabled.store(false, std::memory_order_relaxed);
+	}
+
+	void Tracer::SetThreadName(const char* name)
+	{
+		const uint32_t THREAD_ID = getLease().threadId;
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		for (ThreadName& threadName : mThreadNames)
+		{
+			if (threadName.threadId == THREAD_ID)
+			{
+				threadName.name = name;
+				return;
+			}
+		}
+
+		mThreadNames.push_back({ THREAD_ID, name });
+	}
+
+	void Tracer::AddEvent(const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+	{
+		Lease& lease = getLease();
+
+		if (lease.ring == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mFreeRings.empty())
+			{
+				mRings.push_back(std::make_unique<Ring>());
+				mRings.back()->writing.store(0, std::memory_order_relaxed);
+				mRings.back()->written.store(0, std::memory_order_relaxed);
+				mRings.back()->slots = std::make_unique<Slot[]>(TRACE_RING_CAPACITY);
+				mFreeRings.push_back(mRings.back().get());
+			}
+
+			lease.ring = mFreeRings.back();
+			mFreeRings.pop_back();
+		}
+
+		Ring& ring = *lease.ring;
+		const uint64_t INDEX = ring.written.load(std::memory_order_relaxed);
+		Slot& slot = ring.slots[INDEX & (TRACE_RING_CAPACITY - 1)];
+
+		ring.writing.store(INDEX + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.begin.store(std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count(), std::memory_order_relaxed);
+		slot.duration.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(), std::memory_order_relaxed);
+		slot.threadId.store(lease.threadId, std::memory_order_relaxed);
+
+		ring.written.store(INDEX + 1, std::memory_order_release);
+	}
+
+	// Times are microseconds from the earliest span written.
+	bool Tracer::Write(const char* path)
+	{
+		std::vector<TraceEvent> events;
+		std::vector<ThreadName> threadNames;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			for (const std::unique_ptr<Ring>& ring : mRings)
+			{
+				readRing(*ring, events);
+			}
+
+			threadNames = mThreadNames;
+		}
+
+		std::sort(events.begin(), events.end(), [](const TraceEvent& lhs, const TraceEvent& rhs)
+		{
+			return lhs.begin < rhs.begin;
+		});
+
+		FILE* file = OpenFile(path, "w");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const uint64_t ORIGIN = events.empty() ? 0 : events.front().begin;
+		const char* separator = "";
+
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+		for (const ThreadName& threadName : threadNames)
+		{
+			fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+				separator, threadName.threadId, threadName.name);
+			separator = ",";
+		}
+
+		for (const TraceEvent& event : events)
+		{
+			fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"canvas\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				separator, event.name, event.threadId, (event.begin - ORIGIN) / 1e3, event.duration / 1e3);
+			separator = ",";
+		}
+
+		fprintf(file, "\n]}\n");
+
+		return fclose(file) == 0;
+	}
+
+	Tracer::Lease& Tracer::getLease()
+	{
+		thread_local Lease lease;
+
+		if (lease.threadId == 0)
+		{
+			lease.threadId = mNextThreadId.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return lease;
+	}
+
+	// Slots are copied while their thread may be overwriting the oldest ones.
+	// Anything below writing - capacity once the copy is done may be torn and
+	// is dropped.
+	void Tracer::readRing(Ring& ring, std::vector<TraceEvent>& outEvents)
+	{
+		const uint64_t END = ring.written.load(std::memory_order_acquire);
+		const uint64_t BEGIN = END > TRACE_RING_CAPACITY ? END - TRACE_RING_CAPACITY : 0;
+		const size_t FIRST = outEvents.size();
+
+		for (uint64_t i = BEGIN; i < END; ++i)
+		{
+			const Slot& slot = ring.slots[i & (TRACE_RING_CAPACITY - 1)];
+
+			outEvents.push_back({ slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+				slot.duration.load(std::memory_order_relaxed), slot.threadId.load(std::memory_order_relaxed) });
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		const uint64_t WRITING = ring.writing.load(std::memory_order_relaxed);
+		const uint64_t VALID_BEGIN = WRITING > TRACE_RING_CAPACITY ? WRITING - TRACE_RING_CAPACITY : 0;
+
+		if (VALID_BEGIN > BEGIN)
+		{
+			const size_t DROPPED = static_cast<size_t>((std::min)(VALID_BEGIN, END) - BEGIN);
+			outEvents.erase(outEvents.begin() + FIRST, outEvents.begin() + FIRST + DROPPED);
+		}
+	}
+}
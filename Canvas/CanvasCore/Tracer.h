@@ -0,0 +1,113 @@
+#pragma once
+
+namespace canvas
+{
+	struct TraceEvent
+	{
+		const char* name;
+		uint64_t begin;
+		uint64_t duration;
+		uint32_t threadId;
+	};
+
+	// Timeline of named spans, written as Chrome trace-event JSON that
+	// chrome://tracing and Perfetto open. Every thread records into a ring of
+	// its own that keeps the newest TRACE_RING_CAPACITY spans; Write copies
+	// the rings without stopping the threads. Names must be string literals.
+	class Tracer final
+	{
+	public:
+		static void Enable();
+		static void Disable();
+		static void SetThreadName(const char* name);
+		static void AddEvent(const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+		static bool Write(const char* path);
+
+		inline static bool IsEnabled();
+
+	private:
+		struct Slot
+		{
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> begin;
+			std::atomic<uint64_t> duration;
+			std::atomic<uint32_t> threadId;
+		};
+
+		// Only the leasing thread writes. writing runs ahead of written while a
+		// slot is being filled, so a reader can tell which slots it may have
+		// seen half overwritten.
+		struct Ring
+		{
+			std::atomic<uint64_t> writing;
+			std::atomic<uint64_t> written;
+			std::unique_ptr<Slot[]> slots;
+		};
+
+		// Returns the thread's ring to the pool when the thread exits.
+		struct Lease
+		{
+			Ring* ring = nullptr;
+			uint32_t threadId = 0;
+
+			~Lease();
+		};
+
+		struct ThreadName
+		{
+			uint32_t threadId;
+			const char* name;
+		};
+
+		Tracer() = delete;
+
+		static Lease& getLease();
+		static void readRing(Ring& ring, std::vector<TraceEvent>& outEvents);
+
+	private:
+		static std::atomic<bool> mbEnabled;
+		static std::atomic<uint32_t> mNextThreadId;
+		static std::mutex mMutex;
+		static std::vector<std::unique_ptr<Ring>> mRings;
+		static std::vector<Ring*> mFreeRings;
+		static std::vector<ThreadName> mThreadNames;
+	};
+
+	// Records the span until the end of the scope if tracing is enabled.
+	class TraceScope final
+	{
+	public:
+		inline TraceScope(const char* name);
+		inline ~TraceScope();
+		TraceScope(const TraceScope& other) = delete;
+		TraceScope& operator=(const TraceScope& rhs) = delete;
+
+	private:
+		const char* mName;
+		bool mbActive;
+		std::chrono::steady_clock::time_point mBegin;
+	};
+
+	inline bool Tracer::IsEnabled()
+	{
+		return mbEnabled.load(std::memory_order_relaxed);
+	}
+
+	inline TraceScope::TraceScope(const char* name)
+		: mName(name)
+		, mbActive(Tracer::IsEnabled())
+	{
+		if (mbActive)
+		{
+			mBegin = std::chrono::steady_clock::now();
+		}
+	}
+
+	inline TraceScope::~TraceScope()
+	{
+		if (mbActive)
+		{
+			Tracer::AddEvent(mName, mBegin, std::chrono::steady_clock::now());
+		}
+	}
+}
@@ -0,0 +1,308 @@
+#include "pch.h"
+#include "UndoJournal.h"
+
+namespace canvas
+{
+	UndoJournal::UndoJournal(size_t budget)
+		: mBudget(budget)
+		, mCapacity(0)
+		, mUsedBytes(0)
+		, mRecords(64)
+		, mFirst(0)
+		, mCount(0)
+		, mCursor(0)
+	{
+	}
+
+	// Drops everything that could be redone and appends a record for count
+	// objects. The caller fills the returned entry; it stays open so that a
+	// drag can keep updating it until Seal.
+	bool UndoJournal::Record(eJournalOperation operation, size_t count, JournalEntry& outEntry)
+	{
+		Seal();
+
+		for (size_t i = mCursor; i < mCount; ++i)
+		{
+			mUsedBytes -= getRecord(i).bytes;
+		}
+
+		mCount = mCursor;
+
+		const size_t BYTES = getRecordSize(operation, count);
+
+		if (count > UINT32_MAX || BYTES > mBudget)
+		{
+			Clear();
+			return false;
+		}
+
+		const size_t OFFSET = allocate(BYTES);
+
+		if (mCount == mRecords.size())
+		{
+			std::vector<Span> records(mRecords.size() * 2);
+
+			for (size_t i = 0; i < mCount; ++i)
+			{
+				records[i] = getRecord(i);
+			}
+
+			mRecords.swap(records);
+			mFirst = 0;
+		}
+
+		getRecord(mCount) = { OFFSET, BYTES };
+		++mCount;
+		mCursor = mCount;
+		mUsedBytes += BYTES;
+
+		Header& header = getHeader(mCount - 1);
+		header.operation = operation;
+		header.bOpen = 1;
+		header.count = static_cast<uint32_t>(count);
+		header.offset = { 0.f, 0.f };
+
+		getEntry(mCount - 1, outEntry);
+
+		return true;
+	}
+
+	bool UndoJournal::GetOpenEntry(eJournalOperation operation, JournalEntry& outEntry)
+	{
+		if (mCursor == 0 || mCursor != mCount)
+		{
+			return false;
+		}
+
+		const Header& header = getHeader(mCount - 1);
+
+		if (!header.bOpen || header.operation != operation)
+		{
+			return false;
+		}
+
+		getEntry(mCount - 1, outEntry);
+
+		return true;
+	}
+
+	void UndoJournal::Seal()
+	{
+		if (mCount > 0)
+		{
+			getHeader(mCount - 1).bOpen = 0;
+		}
+	}
+
+	bool UndoJournal::Undo(JournalEntry& outEntry)
+	{
+		Seal();
+
+		if (!CanUndo())
+		{
+			return false;
+		}
+
+		--mCursor;
+		getEntry(mCursor, outEntry);
+
+		return true;
+	}
+
+	bool UndoJournal::Redo(JournalEntry& outEntry)
+	{
+		Seal();
+
+		if (!CanRedo())
+		{
+			return false;
+		}
+
+		getEntry(mCursor, outEntry);
+		++mCursor;
+
+		return true;
+	}
+
+	void UndoJournal::SetBudget(size_t budget)
+	{
+		Clear();
+
+		mBuffer.reset();
+		mBudget = budget;
+		mCapacity = 0;
+	}
+
+	void UndoJournal::Clear()
+	{
+		mFirst = 0;
+		mCount = 0;
+		mCursor = 0;
+		mUsedBytes = 0;
+	}
+
+	// Carries every saved key, on both sides of the cursor, over the
+	// renumbers the store has made since it last released them.
+	void UndoJournal::RemapZKeys(const ObjectStore& objects)
+	{
+		for (size_t record = 0; record < mCount; ++record)
+		{
+			JournalEntry entry;
+			getEntry(record, entry);
+
+			if (entry.zKeys == nullptr)
+			{
+				continue;
+			}
+
+			for (size_t i = 0; i < entry.count; ++i)
+			{
+				entry.zKeys[i] = objects.RemapZKey(entry.zKeys[i]);
+			}
+		}
+	}
+
+	// Records sit in the ring from oldest to newest, possibly wrapping once.
+	// A record never straddles the end; the unused tail is skipped instead.
+	// Records are only dropped once the ring has grown to the budget.
+	size_t UndoJournal::allocate(size_t bytes)
+	{
+		for (;;)
+		{
+			if (mCount == 0 && mCapacity >= bytes)
+			{
+				mFirst = 0;
+				return 0;
+			}
+
+			if (mCount > 0)
+			{
+				const size_t OLDEST = getRecord(0).offset;
+				const Span& newest = getRecord(mCount - 1);
+				const size_t END = newest.offset + newest.bytes;
+
+				if (newest.offset >= OLDEST)
+				{
+					if (mCapacity - END >= bytes)
+					{
+						return END;
+					}
+
+					if (OLDEST >= bytes)
+					{
+						return 0;
+					}
+				}
+				else if (OLDEST - END >= bytes)
+				{
+					return END;
+				}
+			}
+
+			if (mCapacity < mBudget)
+			{
+				grow(bytes);
+				continue;
+			}
+
+			DEBUG_BREAK(mCount > 0);
+
+			mUsedBytes -= getRecord(0).bytes;
+			mFirst = (mFirst + 1) % mRecords.size();
+			--mCount;
+			--mCursor;
+		}
+	}
+
+	// Copies the records to the front of a larger ring, oldest first, which
+	// also closes the gaps left by wrapping.
+	void UndoJournal::grow(size_t bytes)
+	{
+		size_t capacity = (std::max)(mCapacity * 2, UNDO_JOURNAL_INITIAL_CAPACITY);
+
+		while (capacity < mUsedBytes + bytes)
+		{
+			capacity *= 2;
+		}
+
+		capacity = (std::min)(capacity, mBudget);
+
+		std::unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+		size_t offset = 0;
+
+		for (size_t i = 0; i < mCount; ++i)
+		{
+			Span& record = getRecord(i);
+
+			memcpy(buffer.get() + offset, mBuffer.get() + record.offset, record.bytes);
+			record.offset = offset;
+			offset += record.bytes;
+		}
+
+		mBuffer.swap(buffer);
+		mCapacity = capacity;
+	}
+
+	void UndoJournal::getEntry(size_t record, JournalEntry& outEntry)
+	{
+		Header& header = getHeader(record);
+		uint8_t* cursor = reinterpret_cast<uint8_t*>(&header + 1);
+		const size_t COUNT = header.count;
+
+		outEntry = { header.operation, COUNT, &header.offset, reinterpret_cast<ObjectHandle*>(cursor), nullptr, nullptr, nullptr, nullptr, nullptr };
+		cursor += COUNT * sizeof(ObjectHandle);
+
+		switch (header.operation)
+		{
+		case eJournalOperation::Add:
+		case eJournalOperation::Remove:
+			outEntry.zKeys = reinterpret_cast<uint64_t*>(cursor);
+			cursor += COUNT * sizeof(uint64_t);
+			outEntry.rects = reinterpret_cast<RectF*>(cursor);
+			cursor += COUNT * sizeof(RectF);
+			outEntry.lineColors = reinterpret_cast<ColorF*>(cursor);
+			cursor += COUNT * sizeof(ColorF);
+			outEntry.backgroundColors = reinterpret_cast<ColorF*>(cursor);
+			cursor += COUNT * sizeof(ColorF);
+			outEntry.strokeWidths = reinterpret_cast<float*>(cursor);
+			break;
+		case eJournalOperation::Resize:
+			outEntry.rects = reinterpret_cast<RectF*>(cursor);
+			break;
+		case eJournalOperation::Reorder:
+			outEntry.zKeys = reinterpret_cast<uint64_t*>(cursor);
+			break;
+		case eJournalOperation::Move:
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+	}
+
+	size_t UndoJournal::getRecordSize(eJournalOperation operation, size_t count)
+	{
+		size_t bytes = sizeof(Header) + count * sizeof(ObjectHandle);
+
+		switch (operation)
+		{
+		case eJournalOperation::Add:
+		case eJournalOperation::Remove:
+			bytes += count * (sizeof(uint64_t) + sizeof(RectF) + sizeof(ColorF) * 2 + sizeof(float));
+			break;
+		case eJournalOperation::Resize:
+			bytes += count * sizeof(RectF);
+			break;
+		case eJournalOperation::Reorder:
+			bytes += count * sizeof(uint64_t);
+			break;
+		case eJournalOperation::Move:
+			break;
+		default:
+			DEBUG_BREAK(false);
+			break;
+		}
+
+		return (bytes + UNDO_JOURNAL_ALIGNMENT - 1) & ~(UNDO_JOURNAL_ALIGNMENT - 1);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ObjectStore.h"
+
+namespace canvas
+{
+	enum class eJournalOperation : uint8_t
+	{
+		Add,
+		Remove,
+		Move,
+		Resize,
+		Reorder
+	};
+
+	// Mutable view of one journal record. Only the columns the operation
+	// needs are stored; the others are nullptr.
+	//
+	//   Add, Remove  handles, z keys, rects, colors and stroke widths
+	//   Move         handles and the total offset
+	//   Resize       handles and the rects to swap back in
+	//   Reorder      handles and the z keys to swap back in
+	struct JournalEntry
+	{
+		eJournalOperation operation;
+		size_t count;
+		PointF* offset;
+		ObjectHandle* handles;
+		uint64_t* zKeys;
+		RectF* rects;
+		ColorF* lineColors;
+		ColorF* backgroundColors;
+		float* strokeWidths;
+	};
+
+	// Undo history kept as variable-length records in a byte ring. The ring
+	// doubles as the history grows, up to the budget; past that the oldest
+	// records are dropped to make room, and a record larger than the whole
+	// budget clears the history instead.
+	class UndoJournal final
+	{
+	public:
+		UndoJournal(size_t budget);
+		~UndoJournal() = default;
+		UndoJournal(const UndoJournal& other) = delete;
+		UndoJournal& operator=(const UndoJournal& rhs) = delete;
+
+		bool Record(eJournalOperation operation, size_t count, JournalEntry& outEntry);
+		bool GetOpenEntry(eJournalOperation operation, JournalEntry& outEntry);
+		void Seal();
+
+		bool Undo(JournalEntry& outEntry);
+		bool Redo(JournalEntry& outEntry);
+
+		void SetBudget(size_t budget);
+		void Clear();
+		void RemapZKeys(const ObjectStore& objects);
+
+		inline bool CanUndo() const;
+		inline bool CanRedo() const;
+		inline size_t GetUsedBytes() const;
+
+	private:
+		struct Header
+		{
+			eJournalOperation operation;
+			uint8_t bOpen;
+			uint32_t count;
+			PointF offset;
+		};
+
+		struct Span
+		{
+			size_t offset;
+			size_t bytes;
+		};
+
+		size_t allocate(size_t bytes);
+		void grow(size_t bytes);
+		void getEntry(size_t record, JournalEntry& outEntry);
+
+		inline Span& getRecord(size_t record);
+		inline Header& getHeader(size_t record);
+
+		static size_t getRecordSize(eJournalOperation operation, size_t count);
+
+	private:
+		std::unique_ptr<uint8_t[]> mBuffer;
+		size_t mBudget;
+		size_t mCapacity;
+		size_t mUsedBytes;
+
+		std::vector<Span> mRecords;
+		size_t mFirst;
+		size_t mCount;
+		size_t mCursor;
+	};
+
+	inline bool UndoJournal::CanUndo() const
+	{
+		return mCursor > 0;
+	}
+
+	inline bool UndoJournal::CanRedo() const
+	{
+		return mCursor < mCount;
+	}
+
+	inline size_t UndoJournal::GetUsedBytes() const
+	{
+		return mUsedBytes;
+	}
+
+	inline UndoJournal::Span& UndoJournal::getRecord(size_t record)
+	{
+		return mRecords[(mFirst + record) % mRecords.size()];
+	}
+
+	inline UndoJournal::Header& UndoJournal::getHeader(size_t record)
+	{
+		return *reinterpret_cast<Header*>(mBuffer.get() + getRecord(record).offset);
+	}
+}
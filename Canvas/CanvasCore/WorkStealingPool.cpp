@@ -0,0 +1,214 @@
+#include "pch.h"
+#include "WorkStealingPool.h"
+#include "Tracer.h"
+
+namespace canvas
+{
+	WorkStealingPool::WorkStealingPool(size_t threadsCount)
+		: mShares(std::make_unique<Share[]>((std::max)(threadsCount, static_cast<size_t>(1))))
+		, mSharesCount((std::max)(threadsCount, static_cast<size_t>(1)))
+		, mGeneration(0)
+		, mBusyCount(0)
+		, mbStopping(false)
+		, mFunc(nullptr)
+	{
+		for (size_t i = 0; i < mSharesCount; ++i)
+		{
+			mShares[i].bounds.store(0, std::memory_order_relaxed);
+		}
+
+		mThreads.reserve(mSharesCount - 1);
+
+		for (size_t i = 1; i < mSharesCount; ++i)
+		{
+			mThreads.emplace_back(&WorkStealingPool::workerMain, this, i);
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mbStopping = true;
+		}
+
+		mWorkReady.notify_all();
+
+		for (std::thread& thread : mThreads)
+		{
+			thread.join();
+		}
+	}
+
+	void WorkStealingPool::Run(size_t count, const std::function<void(size_t)>& func)
+	{
+		DEBUG_BREAK(count <= UINT32_MAX);
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		if (mSharesCount == 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				func(i);
+			}
+
+			return;
+		}
+
+		for (size_t i = 0; i < mSharesCount; ++i)
+		{
+			const uint32_t BEGIN = static_cast<uint32_t>(count * i / mSharesCount);
+			const uint32_t END = static_cast<uint32_t>(count * (i + 1) / mSharesCount);
+
+			mShares[i].bounds.store(packBounds(BEGIN, END), std::memory_order_relaxed);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFunc = &func;
+			mBusyCount = mSharesCount - 1;
+			++mGeneration;
+		}
+
+		mWorkReady.notify_all();
+
+		work(0);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWorkDone.wait(lock, [this]() { return mBusyCount == 0; });
+		mFunc = nullptr;
+	}
+
+	// One pool per process with a thread per hardware thread, started on first
+	// use. Run is not reentrant, so a call made while it is busy, from another
+	// thread or from inside one of its items, runs inline on the caller.
+	void WorkStealingPool::RunShared(size_t count, const std::function<void(size_t)>& func)
+	{
+		static WorkStealingPool pool((std::max)(std::thread::hardware_concurrency(), 1u));
+		static std::atomic<bool> bBusy(false);
+
+		if (bBusy.exchange(true, std::memory_order_acquire))
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				func(i);
+			}
+
+			return;
+		}
+
+		pool.Run(count, func);
+		bBusy.store(false, std::memory_order_release);
+	}
+
+	void WorkStealingPool::workerMain(size_t index)
+	{
+		Tracer::SetThreadName("worker");
+
+		uint64_t generation = 0;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWorkReady.wait(lock, [this, generation]() { return mbStopping || mGeneration != generation; });
+
+				if (mbStopping)
+				{
+					return;
+				}
+
+				generation = mGeneration;
+			}
+
+			work(index);
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				if (--mBusyCount == 0)
+				{
+					mWorkDone.notify_one();
+				}
+			}
+		}
+	}
+
+	// Items never come back once taken, so one pass that finds every share
+	// empty means the batch only has items already running.
+	void WorkStealingPool::work(size_t index)
+	{
+		const std::function<void(size_t)>& func = *mFunc;
+		size_t item;
+
+		for (;;)
+		{
+			while (takeFront(index, item))
+			{
+				func(item);
+			}
+
+			if (!stealBack(index, item))
+			{
+				return;
+			}
+
+			func(item);
+		}
+	}
+
+	bool WorkStealingPool::takeFront(size_t index, size_t& outItem)
+	{
+		std::atomic<uint64_t>& bounds = mShares[index].bounds;
+		uint64_t current = bounds.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			const uint32_t BEGIN = static_cast<uint32_t>(current);
+			const uint32_t END = static_cast<uint32_t>(current >> 32);
+
+			if (BEGIN >= END)
+			{
+				return false;
+			}
+
+			if (bounds.compare_exchange_weak(current, packBounds(BEGIN + 1, END), std::memory_order_relaxed))
+			{
+				outItem = BEGIN;
+				return true;
+			}
+		}
+	}
+
+	bool WorkStealingPool::stealBack(size_t index, size_t& outItem)
+	{
+		for (size_t offset = 1; offset < mSharesCount; ++offset)
+		{
+			std::atomic<uint64_t>& bounds = mShares[(index + offset) % mSharesCount].bounds;
+			uint64_t current = bounds.load(std::memory_order_relaxed);
+
+			for (;;)
+			{
+				const uint32_t BEGIN = static_cast<uint32_t>(current);
+				const uint32_t END = static_cast<uint32_t>(current >> 32);
+
+				if (BEGIN >= END)
+				{
+					break;
+				}
+
+				if (bounds.compare_exchange_weak(current, packBounds(BEGIN, END - 1), std::memory_order_relaxed))
+				{
+					outItem = END - 1;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+}
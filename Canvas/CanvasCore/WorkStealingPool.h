@@ -0,0 +1,61 @@
+#pragma once
+
+namespace canvas
+{
+	// Persistent threads that run func(i) for every i in [0, count). Each
+	// thread starts on its own contiguous share, taking items from the front;
+	// once that is empty it steals from the back of the others' shares. The
+	// calling thread works too, and Run returns when every item has run.
+	class WorkStealingPool final
+	{
+	public:
+		WorkStealingPool(size_t threadsCount);
+		~WorkStealingPool();
+		WorkStealingPool(const WorkStealingPool& other) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool& rhs) = delete;
+
+		void Run(size_t count, const std::function<void(size_t)>& func);
+
+		static void RunShared(size_t count, const std::function<void(size_t)>& func);
+
+		inline size_t GetThreadsCount() const;
+
+	private:
+		// begin in the low half, end in the high half, so the owner and a
+		// thief race on one word.
+		struct alignas(64) Share
+		{
+			std::atomic<uint64_t> bounds;
+		};
+
+		void workerMain(size_t index);
+		void work(size_t index);
+		bool takeFront(size_t index, size_t& outItem);
+		bool stealBack(size_t index, size_t& outItem);
+
+		inline static uint64_t packBounds(uint32_t begin, uint32_t end);
+
+	private:
+		std::vector<std::thread> mThreads;
+		std::unique_ptr<Share[]> mShares;
+		size_t mSharesCount;
+
+		std::mutex mMutex;
+		std::condition_variable mWorkReady;
+		std::condition_variable mWorkDone;
+		uint64_t mGeneration;
+		size_t mBusyCount;
+		bool mbStopping;
+		const std::function<void(size_t)>* mFunc;
+	};
+
+	inline size_t WorkStealingPool::GetThreadsCount() const
+	{
+		return mSharesCount;
+	}
+
+	inline uint64_t WorkStealingPool::packBounds(uint32_t begin, uint32_t end)
+	{
+		return static_cast<uint64_t>(begin) | (static_cast<uint64_t>(end) << 32);
+	}
+}
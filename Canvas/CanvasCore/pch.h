@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cfloat>
+#include <cassert>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <functional>
+#include <string>
+#include <chrono>
+#include <array>
+#include <iterator>
+
+#include "CoreHelper.h"
@@ -0,0 +1,295 @@
+#include "pch.h"
+#include "Scene.h"
+#include "CpuRenderBackend.h"
+#include "InputRecording.h"
+#include "KeyManager.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+
+#define FNV_OFFSET_BASIS (0xCBF29CE484222325ull)
+#define FNV_PRIME (0x100000001B3ull)
+
+namespace canvas
+{
+	// Feeds a recorded session into the scene the way App does: mouse input
+	// is queued and applied once per recorded frame, keys flush the queue and
+	// run their shortcut. Key state is rebuilt from the recorded held keys.
+	// Rendering goes to the CPU backend.
+	class Replayer final
+	{
+	public:
+		Replayer(const InputRecording& recording);
+		~Replayer() = default;
+		Replayer(const Replayer& other) = delete;
+		Replayer& operator=(const Replayer& rhs) = delete;
+
+		void Run();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct PendingInput
+		{
+			Clock::time_point time;
+			bool bKey;
+		};
+
+		void keyDown(const RecordedInput& input);
+		void frame();
+		uint64_t hashScene() const;
+
+		static void report(const char* name, std::vector<Clock::duration>& durations);
+		inline static uint64_t hashBytes(uint64_t hash, const void* data, size_t bytes);
+
+	private:
+		const InputRecording& mRecording;
+		Scene mScene;
+		CpuRenderBackend mBackend;
+		InputQueue mInput;
+		KeyManager mKeys;
+
+		std::vector<PendingInput> mPendingInputs;
+		std::vector<Clock::duration> mMouseLatencies;
+		std::vector<Clock::duration> mKeyLatencies;
+		std::vector<Clock::duration> mFrameTimes;
+		size_t mSkippedCount;
+	};
+
+	Replayer::Replayer(const InputRecording& recording)
+		: mRecording(recording)
+		, mScene(recording.GetWidth(), recording.GetHeight())
+		, mBackend(recording.GetWidth(), recording.GetHeight())
+		, mSkippedCount(0)
+	{
+	}
+
+	// An input's latency runs from the moment it is fed until the end of the
+	// frame that shows it.
+	void Replayer::Run()
+	{
+		const std::vector<RecordedInput>& inputs = mRecording.GetInputs();
+
+		mScene.Invalidate({ 0.f, 0.f, static_cast<float>(mRecording.GetWidth()), static_cast<float>(mRecording.GetHeight()) });
+
+		const Clock::time_point BEGIN = Clock::now();
+
+		for (const RecordedInput& input : inputs)
+		{
+			switch (input.type)
+			{
+			case eInputType::MouseDown:
+			case eInputType::MouseMove:
+			case eInputType::MouseUp:
+			case eInputType::Pan:
+			{
+				const Clock::time_point NOW = Clock::now();
+				mInput.Push(input.type, input.x, input.y, NOW);
+				mPendingInputs.push_back({ NOW, false });
+			}
+				break;
+			case eInputType::Zoom:
+			{
+				const Clock::time_point NOW = Clock::now();
+				mInput.PushZoom(input.factor, input.x, input.y, NOW);
+				mPendingInputs.push_back({ NOW, false });
+			}
+				break;
+			case eInputType::KeyDown:
+				mPendingInputs.push_back({ Clock::now(), true });
+				keyDown(input);
+				break;
+			case eInputType::KeyUp:
+				mKeys.SetHeldKeys(input.keys);
+				break;
+			case eInputType::Frame:
+				frame();
+				break;
+			default:
+				DEBUG_BREAK(false);
+				break;
+			}
+		}
+
+		frame();
+
+		const double REPLAY_MS = std::chrono::duration<double, std::milli>(Clock::now() - BEGIN).count();
+		const double SESSION_SECONDS = inputs.empty() ? 0.0 : inputs.back().time / 1e6;
+
+		printf("%zu inputs, %.1f s recorded, replayed in %.1f ms\n", inputs.size(), SESSION_SECONDS, REPLAY_MS);
+
+		report("mouse", mMouseLatencies);
+		report("key", mKeyLatencies);
+		report("frame", mFrameTimes);
+
+		if (mSkippedCount > 0)
+		{
+			printf("%zu save, open or trace shortcuts were not replayed\n", mSkippedCount);
+		}
+
+		printf("objects %zu, scene hash %016llx\n", mScene.GetObjects().GetCount(), static_cast<unsigned long long>(hashScene()));
+	}
+
+	void Replayer::keyDown(const RecordedInput& input)
+	{
+		if (!mInput.IsEmpty())
+		{
+			mInput.Apply(mScene);
+		}
+
+		const eCommand COMMAND = mKeys.SetHeldKeys(input.keys);
+
+		if (!mScene.RunCommand(COMMAND, input.x, input.y) && COMMAND != eCommand::None)
+		{
+			++mSkippedCount;
+		}
+	}
+
+	void Replayer::frame()
+	{
+		if (mPendingInputs.empty() && mInput.IsEmpty())
+		{
+			return;
+		}
+
+		TraceScope scope("frame");
+		const Clock::time_point BEGIN = Clock::now();
+
+		mInput.Apply(mScene);
+		mScene.Render(mBackend);
+		mKeys.EndFrame();
+
+		const Clock::time_point END = Clock::now();
+		mFrameTimes.push_back(END - BEGIN);
+
+		for (const PendingInput& input : mPendingInputs)
+		{
+			(input.bKey ? mKeyLatencies : mMouseLatencies).push_back(END - input.time);
+		}
+
+		mPendingInputs.clear();
+	}
+
+	// FNV-1a over the handles and columns, z keys included, in store order.
+	uint64_t Replayer::hashScene() const
+	{
+		const ObjectStore& objects = mScene.GetObjects();
+		uint64_t hash = FNV_OFFSET_BASIS;
+
+		for (size_t i = 0; i < objects.GetCount(); ++i)
+		{
+			const ObjectHandle HANDLE = objects.GetHandle(i);
+			const RectF RECT = objects.GetRect(i);
+			const ColorF LINE_COLOR = objects.GetLineColor(i);
+			const ColorF BACKGROUND_COLOR = objects.GetBackgroundColor(i);
+			const float STROKE_WIDTH = objects.GetStrokeWidth(i);
+			const uint64_t Z_KEY = objects.GetZKey(i);
+
+			hash = hashBytes(hash, &HANDLE, sizeof(HANDLE));
+			hash = hashBytes(hash, &RECT, sizeof(RECT));
+			hash = hashBytes(hash, &LINE_COLOR, sizeof(LINE_COLOR));
+			hash = hashBytes(hash, &BACKGROUND_COLOR, sizeof(BACKGROUND_COLOR));
+			hash = hashBytes(hash, &STROKE_WIDTH, sizeof(STROKE_WIDTH));
+			hash = hashBytes(hash, &Z_KEY, sizeof(Z_KEY));
+		}
+
+		return hash;
+	}
+
+	void Replayer::report(const char* name, std::vector<Clock::duration>& durations)
+	{
+		if (durations.empty())
+		{
+			return;
+		}
+
+		std::sort(durations.begin(), durations.end());
+
+		const auto percentile = [&durations](double fraction)
+		{
+			const size_t INDEX = (std::min)(static_cast<size_t>(fraction * durations.size()), durations.size() - 1);
+			return std::chrono::duration<double, std::micro>(durations[INDEX]).count();
+		};
+
+		printf("%-6s %10zu  p50 %10.1f us  p90 %10.1f us  p99 %10.1f us  max %10.1f us\n", name, durations.size(),
+			percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0));
+	}
+
+	inline uint64_t Replayer::hashBytes(uint64_t hash, const void* data, size_t bytes)
+	{
+		const uint8_t* cursor = static_cast<const uint8_t*>(data);
+
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			hash = (hash ^ cursor[i]) * FNV_PRIME;
+		}
+
+		return hash;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* sessionPath = nullptr;
+	const char* profilePath = nullptr;
+	const char* tracePath = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			profilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else
+		{
+			sessionPath = argv[i];
+		}
+	}
+
+	if (sessionPath == nullptr)
+	{
+		printf("usage: %s [--profile profile.txt] [--trace trace.json] session.cvin\n", argv[0]);
+		return 1;
+	}
+
+	canvas::InputRecording recording;
+
+	if (!recording.Read(sessionPath) || recording.GetWidth() == 0 || recording.GetHeight() == 0)
+	{
+		printf("failed to read %s\n", sessionPath);
+		return 1;
+	}
+
+	if (profilePath != nullptr)
+	{
+		canvas::Profiler::Enable();
+	}
+
+	if (tracePath != nullptr)
+	{
+		canvas::Tracer::Enable();
+		canvas::Tracer::SetThreadName("main");
+	}
+
+	canvas::Replayer replayer(recording);
+	replayer.Run();
+
+	if (profilePath != nullptr && !canvas::Profiler::Dump(profilePath))
+	{
+		printf("failed to write %s\n", profilePath);
+		return 1;
+	}
+
+	if (tracePath != nullptr && !canvas::Tracer::Write(tracePath))
+	{
+		printf("failed to write %s\n", tracePath);
+		return 1;
+	}
+
+	return 0;
+}
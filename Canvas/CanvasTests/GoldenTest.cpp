@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "Scene.h"
+
+#include <cstdio>
+
+#define GOLDEN_TEST_WIDTH (256)
+#define GOLDEN_TEST_HEIGHT (192)
+
+namespace canvas
+{
+	// Renders a small fixed scene through Scene::Render and compares a hash
+	// of the pixels with the stored one, at the default camera and zoomed
+	// in, with one thread and with the tile pool. The scene has opaque and
+	// translucent fills that overlap, a stroke-only object and stroke widths
+	// from one to six. A change that moves any pixel changes the hash; if
+	// it is meant to, update the stored values with the printed ones.
+	class GoldenTest final
+	{
+	public:
+		GoldenTest() = default;
+		~GoldenTest() = default;
+		GoldenTest(const GoldenTest& other) = delete;
+		GoldenTest& operator=(const GoldenTest& rhs) = delete;
+
+		bool Run();
+
+	private:
+		struct Frame
+		{
+			float zoom;
+			float panX;
+			float panY;
+			uint64_t hash;
+		};
+
+		bool runFrame(const Frame& frame, size_t threadsCount) const;
+
+		static void addObjects(Scene& scene);
+		static uint64_t hashPixels(const std::vector<uint32_t>& pixels);
+	};
+
+	bool GoldenTest::Run()
+	{
+		static const Frame FRAMES[] = {
+			{ 1.f, 0.f, 0.f, 0xE4762502BDE987E4ull },
+			{ 1.5f, -20.f, -12.f, 0xB8993A8635224510ull },
+		};
+		static const size_t THREADS_COUNTS[] = { 1, 4 };
+
+		size_t failedCount = 0;
+
+		for (const Frame& frame : FRAMES)
+		{
+			for (size_t threadsCount : THREADS_COUNTS)
+			{
+				failedCount += runFrame(frame, threadsCount) ? 0 : 1;
+			}
+		}
+
+		printf("%zu of %zu frames differ\n", failedCount, std::size(FRAMES) * std::size(THREADS_COUNTS));
+
+		return failedCount == 0;
+	}
+
+	bool GoldenTest::runFrame(const Frame& frame, size_t threadsCount) const
+	{
+		Scene scene(GOLDEN_TEST_WIDTH, GOLDEN_TEST_HEIGHT);
+		CpuRenderBackend backend(GOLDEN_TEST_WIDTH, GOLDEN_TEST_HEIGHT, threadsCount);
+
+		addObjects(scene);
+		scene.Zoom(frame.zoom, 0.f, 0.f);
+		scene.Pan(frame.panX, frame.panY);
+		scene.Render(backend);
+
+		const uint64_t HASH = hashPixels(backend.GetPixels());
+
+		if (HASH != frame.hash)
+		{
+			printf("zoom %g, %zu threads: hash 0x%016llx, expected 0x%016llx\n",
+				frame.zoom, threadsCount, static_cast<unsigned long long>(HASH), static_cast<unsigned long long>(frame.hash));
+			return false;
+		}
+
+		return true;
+	}
+
+	void GoldenTest::addObjects(Scene& scene)
+	{
+		const ColorF CLEAR = MakeColor(0x000000, 0.f);
+
+		scene.AddObject({ 16.f, 16.f, 120.f, 96.f }, MakeColor(0x202020, 1.f), MakeColor(0x3070C0, 1.f), 1.f);
+		scene.AddObject({ 80.f, 56.f, 200.f, 150.f }, MakeColor(0xC03030, 1.f), MakeColor(0xE0A020, 0.5f), 3.f);
+		scene.AddObject({ 40.f, 110.f, 150.f, 176.f }, MakeColor(0x108010, 0.75f), MakeColor(0x60C060, 0.25f), 6.f);
+		scene.AddObject({ 170.f, 20.f, 240.f, 90.f }, MakeColor(0x8020A0, 1.f), CLEAR, 2.5f);
+		scene.AddObject({ 150.5f, 100.25f, 230.75f, 180.5f }, MakeColor(0x000000, 0.5f), MakeColor(0x2040FF, 0.6f), 1.5f);
+	}
+
+	// FNV-1a over the pixel values, so the hash does not depend on byte order.
+	uint64_t GoldenTest::hashPixels(const std::vector<uint32_t>& pixels)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		for (uint32_t pixel : pixels)
+		{
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				hash = (hash ^ ((pixel >> shift) & 0xFF)) * 0x100000001B3ull;
+			}
+		}
+
+		return hash;
+	}
+}
+
+int main()
+{
+	canvas::GoldenTest test;
+
+	return test.Run() ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "CpuRenderBackend.h"
+
+#include <cstdio>
+#include <random>
+
+#define RASTER_TEST_WIDTH (333)
+#define RASTER_TEST_HEIGHT (217)
+#define RASTER_TEST_FRAMES (300)
+#define RASTER_TEST_OPS (96)
+#define RASTER_TEST_BITMAP_SIZE (64)
+
+namespace canvas
+{
+	// Draws the same random frames with one thread and with the tile pool,
+	// which must agree bit for bit: clips, clears, opaque and translucent
+	// fills, strokes, rects partly or wholly off screen, and bitmaps at
+	// fractional positions and non-unit scales, so tile seams cut through
+	// every kind of op.
+	class RasterTest final
+	{
+	public:
+		RasterTest();
+		~RasterTest() = default;
+		RasterTest(const RasterTest& other) = delete;
+		RasterTest& operator=(const RasterTest& rhs) = delete;
+
+		bool Run();
+
+	private:
+		void drawFrame(RenderBackend& backend, uint32_t seed) const;
+
+	private:
+		std::vector<uint32_t> mBitmap;
+	};
+
+	RasterTest::RasterTest()
+		: mBitmap(static_cast<size_t>(RASTER_TEST_BITMAP_SIZE) * RASTER_TEST_BITMAP_SIZE)
+	{
+		for (size_t i = 0; i < mBitmap.size(); ++i)
+		{
+			mBitmap[i] = static_cast<uint32_t>(i * 2654435761u) | 0xFF000000u;
+		}
+	}
+
+	bool RasterTest::Run()
+	{
+		static const size_t THREADS_COUNTS[] = { 2, 3, 4, 8 };
+
+		CpuRenderBackend reference(RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, 1);
+		size_t failedCount = 0;
+
+		for (size_t threadsCount : THREADS_COUNTS)
+		{
+			CpuRenderBackend tiled(RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, threadsCount);
+
+			for (uint32_t frame = 0; frame < RASTER_TEST_FRAMES; ++frame)
+			{
+				drawFrame(reference, frame);
+				drawFrame(tiled, frame);
+
+				size_t diffCount = 0;
+
+				for (size_t i = 0; i < reference.GetPixels().size(); ++i)
+				{
+					diffCount += reference.GetPixels()[i] != tiled.GetPixels()[i];
+				}
+
+				if (diffCount > 0)
+				{
+					printf("frame %u, %zu threads: %zu pixels differ\n", frame, threadsCount, diffCount);
+					++failedCount;
+				}
+			}
+		}
+
+		printf("%zu of %zu frames differ\n", failedCount, std::size(THREADS_COUNTS) * RASTER_TEST_FRAMES);
+
+		return failedCount == 0;
+	}
+
+	void RasterTest::drawFrame(RenderBackend& backend, uint32_t seed) const
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> x(-0.25f * RASTER_TEST_WIDTH, 1.25f * RASTER_TEST_WIDTH);
+		std::uniform_real_distribution<float> y(-0.25f * RASTER_TEST_HEIGHT, 1.25f * RASTER_TEST_HEIGHT);
+		std::uniform_real_distribution<float> extent(0.f, 120.f);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		std::uniform_real_distribution<float> scale(0.25f, 2.5f);
+		std::uniform_int_distribution<int> kind(0, 9);
+		int clipDepth = 0;
+
+		auto randomRect = [&]()
+		{
+			const float LEFT = x(random);
+			const float TOP = y(random);
+
+			return RectF{ LEFT, TOP, LEFT + extent(random), TOP + extent(random) };
+		};
+
+		auto randomColor = [&](bool bOpaque)
+		{
+			return ColorF{ unit(random), unit(random), unit(random), bOpaque ? 1.f : unit(random) };
+		};
+
+		backend.BeginFrame();
+		backend.Clear(MakeColor(0xFFFFFF, 1.f));
+
+		for (int i = 0; i < RASTER_TEST_OPS; ++i)
+		{
+			switch (kind(random))
+			{
+			case 0:
+				if (clipDepth < 3)
+				{
+					backend.PushClip(randomRect());
+					++clipDepth;
+				}
+				break;
+			case 1:
+				if (clipDepth > 0)
+				{
+					backend.PopClip();
+					--clipDepth;
+				}
+				break;
+			case 2:
+				backend.Clear(randomColor(unit(random) < 0.5f));
+				break;
+			case 3:
+				backend.FillRect(randomRect(), randomColor(true));
+				break;
+			case 4:
+			case 5:
+				backend.FillRect(randomRect(), randomColor(false));
+				break;
+			case 6:
+				backend.StrokeRect(randomRect(), randomColor(unit(random) < 0.5f), 0.5f + 6.f * unit(random));
+				break;
+			case 7:
+			{
+				const RectF RECTS[] = { randomRect(), randomRect(), randomRect() };
+				backend.FillRects(RECTS, std::size(RECTS), randomColor(false));
+				backend.StrokeRects(RECTS, std::size(RECTS), randomColor(true), 1.f + 3.f * unit(random));
+			}
+				break;
+			default:
+			{
+				const float LEFT = x(random);
+				const float TOP = y(random);
+				const float WIDTH = RASTER_TEST_BITMAP_SIZE * scale(random);
+				const float HEIGHT = unit(random) < 0.5f ? WIDTH : RASTER_TEST_BITMAP_SIZE * scale(random);
+
+				backend.DrawBitmap({ LEFT, TOP, LEFT + WIDTH, TOP + HEIGHT }, mBitmap.data(),
+					RASTER_TEST_BITMAP_SIZE, RASTER_TEST_BITMAP_SIZE, RASTER_TEST_BITMAP_SIZE);
+			}
+				break;
+			}
+		}
+
+		for (; clipDepth > 0; --clipDepth)
+		{
+			backend.PopClip();
+		}
+
+		backend.EndFrame();
+	}
+}
+
+int main()
+{
+	canvas::RasterTest test;
+
+	return test.Run() ? 0 : 1;
+}
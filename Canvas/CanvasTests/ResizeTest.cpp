@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "Scene.h"
+
+#include <cmath>
+#include <cstdio>
+
+#define RESIZE_TEST_WIDTH (800)
+#define RESIZE_TEST_HEIGHT (600)
+#define RESIZE_TEST_TOLERANCE (1e-3f)
+
+namespace canvas
+{
+	// Drags a corner of a two-object selection at several zooms, with pure
+	// axis and diagonal drags split into one or more moves, rendering between
+	// them as the window would. The objects must scale about the opposite
+	// corner by the drag projected onto the boundary's diagonal, in world units.
+	class ResizeTest final
+	{
+	public:
+		ResizeTest() = default;
+		~ResizeTest() = default;
+		ResizeTest(const ResizeTest& other) = delete;
+		ResizeTest& operator=(const ResizeTest& rhs) = delete;
+
+		bool Run();
+
+	private:
+		struct Drag
+		{
+			eResizingDirection direction;
+			float x;
+			float y;
+			int movesCount;
+		};
+
+		bool runDrag(float zoom, const Drag& drag) const;
+
+		static PointF toScreen(const Scene& scene, float x, float y);
+	};
+
+	bool ResizeTest::Run()
+	{
+		static const float ZOOMS[] = { 0.5f, 1.f, 2.f };
+		static const Drag DRAGS[] = {
+			{ eResizingDirection::SouthEast, 40.f, 0.f, 1 },
+			{ eResizingDirection::NorthWest, -5.f, 0.f, 1 },
+			{ eResizingDirection::NorthEast, 0.f, -30.f, 6 },
+			{ eResizingDirection::SouthWest, -12.f, 20.f, 4 },
+			{ eResizingDirection::SouthEast, -20.f, 0.f, 5 },
+		};
+
+		size_t failedCount = 0;
+
+		for (float zoom : ZOOMS)
+		{
+			for (const Drag& drag : DRAGS)
+			{
+				failedCount += runDrag(zoom, drag) ? 0 : 1;
+			}
+		}
+
+		printf("%zu of %zu drags failed\n", failedCount, std::size(ZOOMS) * std::size(DRAGS));
+
+		return failedCount == 0;
+	}
+
+	bool ResizeTest::runDrag(float zoom, const Drag& drag) const
+	{
+		static const RectF RECTS[] = {
+			{ 40.f, 40.f, 100.f, 70.f },
+			{ 130.f, 110.f, 170.f, 160.f },
+		};
+
+		Scene scene(RESIZE_TEST_WIDTH, RESIZE_TEST_HEIGHT);
+		CpuRenderBackend backend(RESIZE_TEST_WIDTH, RESIZE_TEST_HEIGHT);
+
+		for (const RectF& rect : RECTS)
+		{
+			scene.AddObject(rect, MakeColor(0x000000, 1.f), MakeColor(0xFFFFFF, 1.f), DEFAULT_STROKE_WIDTH);
+		}
+
+		scene.Zoom(zoom, 0.f, 0.f);
+
+		const PointF MARQUEE_START = toScreen(scene, 10.f, 10.f);
+		const PointF MARQUEE_END = toScreen(scene, 200.f, 200.f);
+
+		scene.MouseDown(MARQUEE_START.x, MARQUEE_START.y);
+		scene.MouseMove(MARQUEE_END.x, MARQUEE_END.y);
+		scene.MouseUp();
+		scene.Render(backend);
+
+		if (scene.GetSelection().GetCount() != std::size(RECTS))
+		{
+			printf("zoom %g: %zu objects selected\n", zoom, scene.GetSelection().GetCount());
+			return false;
+		}
+
+		const RectF ORIGIN = scene.GetSelectionBoundary();
+		const bool B_WEST = drag.direction == eResizingDirection::NorthWest || drag.direction == eResizingDirection::SouthWest;
+		const bool B_NORTH = drag.direction == eResizingDirection::NorthWest || drag.direction == eResizingDirection::NorthEast;
+		const PointF CORNER = toScreen(scene, B_WEST ? ORIGIN.left : ORIGIN.right, B_NORTH ? ORIGIN.top : ORIGIN.bottom);
+
+		scene.MouseMove(CORNER.x, CORNER.y);
+		scene.MouseDown(CORNER.x, CORNER.y);
+
+		for (int i = 1; i <= drag.movesCount; ++i)
+		{
+			scene.MouseMove(CORNER.x + drag.x * i / drag.movesCount, CORNER.y + drag.y * i / drag.movesCount);
+			scene.Render(backend);
+		}
+
+		scene.MouseUp();
+
+		const float DIAGONAL_X = (B_WEST ? -1.f : 1.f) * (ORIGIN.right - ORIGIN.left);
+		const float DIAGONAL_Y = (B_NORTH ? -1.f : 1.f) * (ORIGIN.bottom - ORIGIN.top);
+		const float SCALE = 1.f + (drag.x * DIAGONAL_X + drag.y * DIAGONAL_Y) / zoom
+			/ (DIAGONAL_X * DIAGONAL_X + DIAGONAL_Y * DIAGONAL_Y);
+		const float ANCHOR_X = B_WEST ? ORIGIN.right : ORIGIN.left;
+		const float ANCHOR_Y = B_NORTH ? ORIGIN.bottom : ORIGIN.top;
+		const ObjectStore& objects = scene.GetObjects();
+		bool bPassed = true;
+
+		for (size_t i = 0; i < std::size(RECTS); ++i)
+		{
+			const RectF EXPECTED = {
+				ANCHOR_X + (RECTS[i].left - ANCHOR_X) * SCALE,
+				ANCHOR_Y + (RECTS[i].top - ANCHOR_Y) * SCALE,
+				ANCHOR_X + (RECTS[i].right - ANCHOR_X) * SCALE,
+				ANCHOR_Y + (RECTS[i].bottom - ANCHOR_Y) * SCALE
+			};
+			const RectF& rect = objects.GetRect(i);
+
+			if (std::fabs(rect.left - EXPECTED.left) > RESIZE_TEST_TOLERANCE
+				|| std::fabs(rect.top - EXPECTED.top) > RESIZE_TEST_TOLERANCE
+				|| std::fabs(rect.right - EXPECTED.right) > RESIZE_TEST_TOLERANCE
+				|| std::fabs(rect.bottom - EXPECTED.bottom) > RESIZE_TEST_TOLERANCE)
+			{
+				printf("zoom %g, drag (%g, %g) in %d: object %zu is (%g, %g, %g, %g), expected (%g, %g, %g, %g)\n",
+					zoom, drag.x, drag.y, drag.movesCount, i,
+					rect.left, rect.top, rect.right, rect.bottom,
+					EXPECTED.left, EXPECTED.top, EXPECTED.right, EXPECTED.bottom);
+				bPassed = false;
+			}
+		}
+
+		return bPassed;
+	}
+
+	PointF ResizeTest::toScreen(const Scene& scene, float x, float y)
+	{
+		const RectF RECT = scene.GetCamera().ToScreen({ x, y, x, y });
+
+		return { RECT.left, RECT.top };
+	}
+}
+
+int main()
+{
+	canvas::ResizeTest test;
+
+	return test.Run() ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#define Z_ORDER_TEST_WIDTH (320)
+#define Z_ORDER_TEST_HEIGHT (240)
+#define Z_ORDER_TEST_STEPS (48)
+
+namespace canvas
+{
+	// Three overlapping objects take turns stepping the top one backward,
+	// which halves the key gap above the bottom one each time until the
+	// store has to renumber; a fourth object apart from them, sent to the
+	// back first, only changes its key then. Undo must walk the whole history back across the
+	// renumber, and redo must walk it forward again.
+	class ZOrderTest final
+	{
+	public:
+		ZOrderTest() = default;
+		~ZOrderTest() = default;
+		ZOrderTest(const ZOrderTest& other) = delete;
+		ZOrderTest& operator=(const ZOrderTest& rhs) = delete;
+
+		bool Run();
+
+	private:
+		static std::vector<uint32_t> getPaintOrder(const Scene& scene);
+	};
+
+	bool ZOrderTest::Run()
+	{
+		Scene scene(Z_ORDER_TEST_WIDTH, Z_ORDER_TEST_HEIGHT);
+		const ColorF LINE_COLOR = MakeColor(0x000000, 1.f);
+
+		scene.AddObject({ 20.f, 20.f, 120.f, 100.f }, LINE_COLOR, MakeColor(0xC04040, 1.f), 1.f);
+		scene.AddObject({ 60.f, 40.f, 160.f, 140.f }, LINE_COLOR, MakeColor(0x40C040, 1.f), 1.f);
+		scene.AddObject({ 40.f, 70.f, 140.f, 170.f }, LINE_COLOR, MakeColor(0x4040C0, 1.f), 1.f);
+		scene.AddObject({ 200.f, 20.f, 300.f, 120.f }, LINE_COLOR, MakeColor(0x808080, 1.f), 1.f);
+
+		scene.MouseDown(250.f, 70.f);
+		scene.MouseUp();
+		scene.SendToBack();
+
+		const uint64_t APART_KEY = scene.GetObjects().GetZKey(3);
+		std::vector<std::vector<uint32_t>> orders;
+
+		orders.push_back(getPaintOrder(scene));
+
+		for (int i = 0; i < Z_ORDER_TEST_STEPS; ++i)
+		{
+			scene.MouseDown(300.f, 220.f);
+			scene.MouseUp();
+			scene.MouseDown(80.f, 80.f);
+			scene.MouseUp();
+			scene.SendBackward();
+
+			orders.push_back(getPaintOrder(scene));
+		}
+
+		if (scene.GetObjects().GetZKey(3) == APART_KEY)
+		{
+			printf("no renumber in %d steps\n", Z_ORDER_TEST_STEPS);
+			return false;
+		}
+
+		for (size_t i = orders.size() - 1; i > 0; --i)
+		{
+			if (!scene.Undo() || getPaintOrder(scene) != orders[i - 1])
+			{
+				printf("undo to step %zu does not restore its order\n", i - 1);
+				return false;
+			}
+		}
+
+		for (size_t i = 1; i < orders.size(); ++i)
+		{
+			if (!scene.Redo() || getPaintOrder(scene) != orders[i])
+			{
+				printf("redo to step %zu does not restore its order\n", i);
+				return false;
+			}
+		}
+
+		printf("%d steps undone and redone across a renumber\n", Z_ORDER_TEST_STEPS);
+
+		return true;
+	}
+
+	// Back to front, as handle indices.
+	std::vector<uint32_t> ZOrderTest::getPaintOrder(const Scene& scene)
+	{
+		const ObjectStore& objects = scene.GetObjects();
+		std::vector<uint32_t> order(objects.GetCount());
+
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+
+		std::sort(order.begin(), order.end(), [&objects](uint32_t lhs, uint32_t rhs)
+		{
+			return objects.IsAbove(rhs, lhs);
+		});
+
+		for (uint32_t& index : order)
+		{
+			index = objects.GetHandle(index).index;
+		}
+
+		return order;
+	}
+}
+
+int main()
+{
+	canvas::ZOrderTest test;
+
+	return test.Run() ? 0 : 1;
+}